@@ -0,0 +1,129 @@
+// Agency save benchmark: the former full save (SaveCommand: toJSON() of the
+// whole agency, every history in one DOM, every file rewritten) compared with
+// the incremental checkpoint after one new message in one agent, and the
+// first (full) checkpoint. The agents keep a chat like history as a journal.
+//
+// usage: builds/benchmarks/agency_checkpoint [--agents=8] [--messages=2000] [--size=1000] [--rounds=5]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Owns.hpp"
+#include "../tools/utils/JSON.hpp"
+#include "../tools/utils/files.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/str/str_contains.hpp"
+#include "../tools/str/tpl_replace.hpp"
+#include "../tools/str/implode.hpp"
+#include "../tools/containers/in_array.hpp"
+#include "../tools/agency/Agency.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency;
+using namespace benchmarks;
+
+// A history like ChatbotAgent's
+class HistoryWorker: public Worker<string> {
+public:
+    using Worker<string>::Worker;
+
+    vector<string> messages;
+
+    string type() const override { return "history"; }
+
+    void handle(const string&, const string& item) override {
+        messages.push_back(item);
+    }
+
+    JSON toJSON() const override {
+        JSON json = toSnapshot();
+        vector<JSON> jmessages;
+        string key;
+        journal(0, jmessages, key);
+        json.set(key, jmessages);
+        return json;
+    }
+
+    JSON toSnapshot() const override {
+        return Worker<string>::toJSON();
+    }
+
+    size_t journal(size_t from, vector<JSON>& entries, string& key) const override {
+        key = "history.messages";
+        for (size_t i = from; i < messages.size(); i++) {
+            JSON jmessage;
+            jmessage.set("sender", "user");
+            jmessage.set("text", messages[i]);
+            entries.push_back(jmessage);
+        }
+        return messages.size();
+    }
+};
+
+// The former SaveCommand::saveAgency()
+void full_save(Agency<string>& agency, const string& filename) {
+    JSON jagency = agency.toJSON();
+    vector<JSON> jworkers = jagency.get<vector<JSON>>("workers");
+    vector<string> fworkers;
+    for (const JSON& jworker: jworkers) {
+        string fworker = (fs::path(filename).parent_path() / (jworker.get<string>("name") + ".json")).string();
+        file_put_contents(fworker, jworker.dump(4), false, true);
+        fworkers.push_back(fworker);
+    }
+    jagency.set("workers", fworkers);
+    file_put_contents(filename, jagency.dump(4), false, true);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t agents = args.get<size_t>("agents", 8);
+        size_t messages = args.get<size_t>("messages", 2000);
+        size_t size = args.get<size_t>("size", 1000);
+        size_t rounds = args.get<size_t>("rounds", 5);
+
+        string dir = (fs::temp_directory_path() / "agency_checkpoint").string();
+        fs::remove_all(dir);
+        fs::create_directories(dir + "/full");
+        fs::create_directories(dir + "/incremental");
+
+        Owns owns;
+        AgentRoleMap roles;
+        PackQueue<string> queue;
+        Agency<string> agency(owns, roles, queue, "agency");
+        for (size_t i = 0; i < agents; i++) {
+            HistoryWorker& worker = agency.spawn<HistoryWorker>(owns, &agency, queue, "agent" + to_string(i));
+            for (size_t j = 0; j < messages; j++) worker.messages.push_back(string(size, 'a' + (char)(j % 26)));
+        }
+        agency.tick(); // spawn messages
+
+        string full = dir + "/full/agency.json";
+        string incremental = dir + "/incremental/agency.json";
+        long long fullNs = 0;
+        for (size_t i = 0; i < rounds; i++) fullNs += measure_ns([&]() { full_save(agency, full); });
+        long long firstNs = measure_ns([&]() { agency.checkpoint(incremental); });
+        long long incrementalNs = 0;
+        Checkpoint::Stats stats;
+        for (size_t i = 0; i < rounds; i++) {
+            queue.Produce(Pack<string>("user", "agent0", "one more message"));
+            agency.tick();
+            incrementalNs += measure_ns([&]() { stats = agency.checkpoint(incremental); });
+        }
+
+        double fullMs = (double)fullNs / (double)rounds / 1e6;
+        double incrementalMs = (double)incrementalNs / (double)rounds / 1e6;
+        report("save " + to_string(agents) + " agents x " + to_string(messages) + " messages of " + to_string(size) + " bytes", {
+            { "full save ms", fmt(fullMs) },
+            { "first checkpoint ms", fmt((double)firstNs / 1e6) },
+            { "incremental ms", fmt(incrementalMs) + " (" + fmt(fullMs / incrementalMs, 1) + "x)" },
+            { "incremental writes", to_string(stats.written) + " segment(s), " + to_string(stats.appended) + " entry, " + to_string(stats.bytes) + " bytes" },
+        });
+        fs::remove_all(dir);
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
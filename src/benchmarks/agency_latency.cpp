@@ -0,0 +1,133 @@
+// Agency pack handoff benchmark: latency from PackQueue::Produce() (what
+// Worker::send() does) to the entry of the recipient's handle(), and the
+// CPU an idle agency burns. Compares the former fixed sleep polling loop
+// (sleep_ms(10) + tick()) with the event-driven sync() (blocks on the
+// queue), inline and with a pool thread running the handle() calls.
+//
+// usage: builds/benchmarks/agency_latency [--packs=20000] [--polled-packs=300] [--idle-ms=1000]
+
+#include <ctime>
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Owns.hpp"
+#include "../tools/utils/JSON.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/str/str_contains.hpp"
+#include "../tools/str/tpl_replace.hpp"
+#include "../tools/str/implode.hpp"
+#include "../tools/containers/in_array.hpp"
+#include "../tools/agency/Agency.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency;
+using namespace benchmarks;
+
+// Timestamps the handle() entry
+class LatencyWorker: public Worker<string> {
+public:
+    using Worker<string>::Worker;
+
+    atomic<long long> handledAt = 0;
+    atomic<size_t> handled = 0;
+
+    string type() const override { return "latency"; }
+
+    void handle(const string&, const string&) override {
+        handledAt = now_ns();
+        handled++;
+    }
+
+    static long long now_ns() {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+long long cpu_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct Result {
+    vector<long long> latencies;
+    long long idleCpuNs = 0;
+};
+
+// polled: the former sync() loop, threads: pool size (0 = inline)
+Result run(size_t packs, long idleMs, bool polled, size_t threads) {
+    Owns owns;
+    AgentRoleMap roles;
+    PackQueue<string> queue;
+    Agency<string> agency(owns, roles, queue, "agency");
+    agency.setThreads(threads);
+    LatencyWorker& worker = agency.spawn<LatencyWorker>(owns, &agency, queue, "worker");
+    Pack<string> pack;
+    while (queue.Consume(pack)); // spawn message
+
+    atomic<bool> polling = polled;
+    thread poller;
+    if (polled) poller = thread([&]() {
+        while (polling) {
+            sleep_ms(10);
+            agency.tick();
+        }
+    });
+    else agency.start();
+
+    Result result;
+    long long cpu = cpu_ns();
+    sleep_ms(idleMs);
+    result.idleCpuNs = cpu_ns() - cpu;
+
+    WorkerId sender("user");
+    WorkerId recipient("worker");
+    result.latencies.reserve(packs);
+    for (size_t i = 0; i < packs; i++) {
+        if (polled) sleep_ms((long)(i % 10)); // spread the sends over the poll period
+        size_t before = worker.handled;
+        long long sentAt = LatencyWorker::now_ns();
+        queue.Produce(Pack<string>(sender, recipient, "ping"));
+        while (worker.handled == before) this_thread::yield();
+        result.latencies.push_back(worker.handledAt - sentAt);
+    }
+
+    if (polled) {
+        polling = false;
+        poller.join();
+    }
+    agency.stop();
+    return result;
+}
+
+void print(const string& label, Result& result, long idleMs) {
+    report(label, {
+        { "p50 us", fmt(percentile(result.latencies, 50) / 1000.0) },
+        { "p99 us", fmt(percentile(result.latencies, 99) / 1000.0) },
+        { "max us", fmt(percentile(result.latencies, 100) / 1000.0) },
+        { "idle CPU %", fmt(100.0 * (double)result.idleCpuNs / (double)(idleMs * 1000000LL), 3) },
+    });
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t packs = args.get<size_t>("packs", 20000);
+        size_t polledPacks = args.get<size_t>("polled-packs", 300);
+        long idleMs = args.get<long>("idle-ms", 1000);
+
+        Result polled = run(polledPacks, idleMs, true, 0);
+        print("sleep_ms(10) polling", polled, idleMs);
+        Result inlined = run(packs, idleMs, false, 0);
+        print("event-driven, inline", inlined, idleMs);
+        Result pooled = run(packs, idleMs, false, 1);
+        print("event-driven, 1 pool thread", pooled, idleMs);
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include "../tools/utils/system.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+// Shared helpers for the standalone benchmark programs in this folder.
+// Build and run one with: src/tools/build/bin/compile src/benchmarks/<name>.cpp && builds/benchmarks/<name>
+
+namespace benchmarks {
+
+    // Samples the process thread count in the background and keeps the peak
+    class ThreadCountSampler {
+    public:
+        ThreadCountSampler(long interval_ms = 1): interval_ms(interval_ms) {
+            peak = get_threads_count();
+            sampler = thread([this]() {
+                while (running) {
+                    size_t count = get_threads_count();
+                    if (count > peak) peak = count;
+                    sleep_ms(this->interval_ms);
+                }
+            });
+        }
+
+        ~ThreadCountSampler() {
+            stop();
+        }
+
+        size_t stop() {
+            running = false;
+            if (sampler.joinable()) sampler.join();
+            return peak - 1; // without the sampler thread
+        }
+
+    private:
+        long interval_ms;
+        atomic<bool> running = true;
+        atomic<size_t> peak = 0;
+        thread sampler;
+    };
+
+    // Wall clock time of a callback in nanoseconds
+    inline long long measure_ns(function<void()> callback) {
+        auto start = chrono::steady_clock::now();
+        callback();
+        auto end = chrono::steady_clock::now();
+        return chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    }
+
+    inline double per_sec(size_t count, long long ns) {
+        return ns > 0 ? (double)count * 1e9 / (double)ns : 0.0;
+    }
+
+    // p in [0..100], sorts the samples in place
+    inline long long percentile(vector<long long>& samples, double p) {
+        if (samples.empty()) return 0;
+        sort(samples.begin(), samples.end());
+        size_t idx = (size_t)((p / 100.0) * (double)(samples.size() - 1));
+        return samples[idx];
+    }
+
+    inline void report(const string& label, const vector<pair<string, string>>& values) {
+        cout << left << setw(40) << label;
+        for (const auto& [key, value]: values) cout << "  " << key << ": " << value;
+        cout << endl;
+    }
+
+    inline string fmt(double value, int precision = 2) {
+        ostringstream ss;
+        ss << fixed << setprecision(precision) << value;
+        return ss.str();
+    }
+
+}
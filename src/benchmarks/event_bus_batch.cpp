@@ -0,0 +1,101 @@
+// Batch publish benchmark: Async EventBus with a pooled consumer, publishing
+// one event per createAndPublishEvent() call compared with EventBus::Batch
+// at several batch sizes (one queue lock, one router wakeup and one
+// subscription snapshot read per batch). Reports the publisher cost per
+// event and the end-to-end events/sec (until the consumer has them all).
+//
+// usage: builds/benchmarks/event_bus_batch [--events=1000000] [--capacity=1024]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/utils/Logger.hpp"
+#include "../tools/_events/events.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::events;
+using namespace benchmarks;
+
+class BenchEvent: public TypedEvent<BenchEvent> {
+public:
+    BenchEvent(size_t seq = 0): seq(seq) {}
+    size_t seq;
+};
+
+class CountingConsumer: public BaseEventConsumer {
+public:
+    using BaseEventConsumer::BaseEventConsumer;
+    atomic<size_t> received = 0;
+    void handleEvent(Event&) override { received.fetch_add(1, memory_order_relaxed); }
+protected:
+    void registerEventInterests() override {
+        registerHandler<BenchEvent>([](BenchEvent&) {});
+    }
+};
+
+struct Result {
+    double publishNs; // publisher time per event
+    double rate;      // end-to-end events/sec
+};
+
+// batchSize 0 publishes one by one without a batch
+Result bench(Logger& logger, size_t events, size_t capacity, size_t batchSize) {
+    if (batchSize > capacity) throw ERROR("Batch size is above the queue capacity");
+    RingBufferEventQueue queue(capacity, logger);
+    EventBus bus(logger, queue, EventBus::DeliveryMode::Async);
+    CountingConsumer consumer("consumer");
+    consumer.registerWithEventBus(&bus);
+    const ComponentId source = "bench";
+    const ComponentId target = "consumer";
+    // the queue never drops: the publisher waits for room
+    size_t room = batchSize ? batchSize : 1;
+    auto waitRoom = [&]() {
+        while (queue.available() + room > capacity) this_thread::yield();
+    };
+
+    long long publishNs = 0;
+    long long ns = measure_ns([&]() {
+        size_t i = 0;
+        while (i < events) {
+            waitRoom();
+            auto start = chrono::steady_clock::now();
+            if (!batchSize) {
+                bus.createAndPublishEvent<BenchEvent>(source, target, i++);
+            } else {
+                EventBus::Batch batch = bus.createBatch(source, batchSize);
+                for (size_t n = 0; n < batchSize && i < events; n++)
+                    batch.add<BenchEvent>(target, i++);
+                batch.publish();
+            }
+            publishNs += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        }
+        while (consumer.received < events) this_thread::yield();
+    });
+    bus.stop();
+    if (consumer.received != events) throw ERROR("Lost events");
+    return { (double)publishNs / (double)events, per_sec(events, ns) };
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t events = args.get<size_t>("events", 1000000);
+        size_t capacity = args.get<size_t>("capacity", 1024);
+
+        Logger logger("bench");
+        for (size_t batchSize: { 0, 1, 16, 256 }) {
+            Result result = bench(logger, events, capacity, batchSize);
+            report(batchSize ? "batch of " + to_string(batchSize) : "one by one", {
+                { "publish ns/event", fmt(result.publishNs) },
+                { "end-to-end events/sec", fmt(result.rate) },
+            });
+        }
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Parallel publishers benchmark: events/sec of FilteredEventBus delivery with
+// 1..N publisher threads, on the copy-on-write subscription snapshot compared
+// with the former delivery (exclusive bus lock for the whole delivery and a
+// copy of the filter list under a mutex per consumer).
+//
+// usage: builds/benchmarks/event_bus_publishers [--events=1000000] [--consumers=4] [--max-threads=8]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/utils/Logger.hpp"
+#include "../tools/_events/events.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::events;
+using namespace benchmarks;
+
+class BenchEvent: public TypedEvent<BenchEvent> {
+public:
+    BenchEvent(size_t seq = 0): seq(seq) {}
+    size_t seq;
+};
+
+class CountingConsumer: public BaseEventConsumer {
+public:
+    using BaseEventConsumer::BaseEventConsumer;
+    atomic<size_t> received = 0;
+    void handleEvent(Event&) override { received.fetch_add(1, memory_order_relaxed); }
+protected:
+    void registerEventInterests() override {
+        registerHandler<BenchEvent>([](BenchEvent&) {});
+    }
+};
+
+class PassFilter: public EventFilter {
+public:
+    bool shouldDeliverEvent(const ComponentId&, Event&) override { return true; }
+};
+
+// The delivery that FilteredEventBus used before the snapshot
+class LegacyFilteredEventBus: public EventBus {
+public:
+    LegacyFilteredEventBus(Logger& logger, EventQueue& eventQueue): EventBus(logger, eventQueue) {}
+
+    void addEventFilter(EventFilter& filter) {
+        lock_guard<mutex> lock(m_filterMutex);
+        m_filters.push_back(&filter);
+    }
+
+protected:
+    void deliverEventInternal(Event& event) override {
+        unique_lock<shared_mutex> lock(m_mutex);
+        auto typeIt = m_eventInterests.find(event.getTypeId());
+        if (typeIt == m_eventInterests.end()) return;
+        for (const ComponentId& consumerId: typeIt->second) {
+            auto consumerIt = m_consumers.find(consumerId);
+            if (consumerIt == m_consumers.end()) continue;
+            vector<EventFilter*> filtersCopy;
+            {
+                lock_guard<mutex> lock(m_filterMutex);
+                filtersCopy = m_filters;
+            }
+            bool deliver = true;
+            for (EventFilter* filter: filtersCopy)
+                if (!filter->shouldDeliverEvent(consumerId, event)) deliver = false;
+            if (deliver) consumerIt->second->handleEvent(event);
+        }
+    }
+
+private:
+    mutex m_filterMutex;
+    vector<EventFilter*> m_filters;
+};
+
+template<typename Bus>
+double run_publishers(Bus& bus, size_t events, size_t publishers) {
+    long long ns = measure_ns([&]() {
+        vector<thread> threads;
+        for (size_t p = 0; p < publishers; p++) {
+            threads.emplace_back([&bus, events, publishers, p]() {
+                for (size_t i = p; i < events; i += publishers)
+                    bus.template createAndPublishEvent<BenchEvent>("bench", "", i);
+            });
+        }
+        for (thread& t: threads) t.join();
+    });
+    return per_sec(events, ns);
+}
+
+template<typename Bus>
+double bench(Logger& logger, size_t events, size_t consumerCount, size_t publishers) {
+    RingBufferEventQueue queue(1024, logger);
+    Bus bus(logger, queue);
+    PassFilter filter;
+    bus.addEventFilter(filter);
+    vector<unique_ptr<CountingConsumer>> consumers;
+    for (size_t i = 0; i < consumerCount; i++) {
+        consumers.push_back(make_unique<CountingConsumer>("consumer" + to_string(i)));
+        consumers.back()->registerWithEventBus(&bus);
+    }
+    double rate = run_publishers(bus, events, publishers);
+    for (const unique_ptr<CountingConsumer>& consumer: consumers)
+        if (consumer->received != events) throw ERROR("Lost events at " + consumer->getId());
+    return rate;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t events = args.get<size_t>("events", 1000000);
+        size_t consumers = args.get<size_t>("consumers", 4);
+        size_t maxThreads = args.get<size_t>("max-threads", 8);
+
+        Logger logger("bench");
+        double legacyBase = 0, snapshotBase = 0;
+        for (size_t threads = 1; threads <= maxThreads; threads <<= 1) {
+            double legacy = bench<LegacyFilteredEventBus>(logger, events, consumers, threads);
+            double snapshot = bench<FilteredEventBus>(logger, events, consumers, threads);
+            if (threads == 1) {
+                legacyBase = legacy;
+                snapshotBase = snapshot;
+            }
+            report(to_string(threads) + " publisher(s)", {
+                { "legacy events/sec", fmt(legacy) },
+                { "scaling", fmt(legacy / legacyBase, 2) + "x" },
+                { "snapshot events/sec", fmt(snapshot) },
+                { "scaling", fmt(snapshot / snapshotBase, 2) + "x" },
+            });
+        }
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Event lifetime benchmark: publishes N events through the EventBus and reports
+// events/sec and the peak thread count, compared with the former lifetime
+// handling (heap allocation + one detached reaper thread polling per event).
+//
+// usage: builds/benchmarks/event_lifetime [--events=1000000] [--legacy-events=1000000]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/utils/Logger.hpp"
+#include "../tools/_events/events.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::events;
+using namespace benchmarks;
+
+class BenchEvent: public TypedEvent<BenchEvent> {
+public:
+    BenchEvent(size_t seq = 0): seq(seq) {}
+    size_t seq;
+};
+
+class CountingConsumer: public BaseEventConsumer {
+public:
+    using BaseEventConsumer::BaseEventConsumer;
+    atomic<size_t> received = 0;
+protected:
+    void registerEventInterests() override {
+        registerHandler<BenchEvent>([this](BenchEvent&) { received++; });
+    }
+};
+
+// The lifetime handling that EventBus::createAndPublishEvent used before the pool
+void legacy_publish(EventConsumer& consumer, size_t seq) {
+    BenchEvent* event = new BenchEvent(seq);
+    static const ComponentId source = "bench";
+    event->sourceId = source;
+    event->timestamp = chrono::system_clock::now();
+    consumer.handleEvent(*event);
+    thread([event]() {
+        while (event->isHolded()) sleep_ms(1);
+        delete event;
+    }).detach();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t events = args.get<size_t>("events", 1000000);
+        size_t legacyEvents = args.get<size_t>("legacy-events", events);
+
+        Logger logger("bench");
+        RingBufferEventQueue queue(1024, logger);
+        EventBus bus(logger, queue);
+        CountingConsumer consumer("consumer");
+        consumer.registerWithEventBus(&bus);
+
+        // before
+        {
+            ThreadCountSampler threads;
+            size_t failed = 0;
+            long long ns = measure_ns([&]() {
+                for (size_t i = 0; i < legacyEvents; i++) {
+                    try {
+                        legacy_publish(consumer, i);
+                    } catch (system_error&) {
+                        failed++; // thread limit reached
+                    }
+                }
+            });
+            sleep_ms(100); // let the reapers finish
+            report("legacy (new + detached reaper)", {
+                { "events", to_string(legacyEvents) },
+                { "events/sec", fmt(per_sec(legacyEvents, ns)) },
+                { "peak threads", to_string(threads.stop()) },
+                { "thread failures", to_string(failed) },
+            });
+        }
+
+        // after
+        {
+            consumer.received = 0;
+            ThreadCountSampler threads;
+            long long ns = measure_ns([&]() {
+                for (size_t i = 0; i < events; i++)
+                    bus.createAndPublishEvent<BenchEvent>("bench", "", i);
+            });
+            EventPool<BenchEvent>& pool = EventPool<BenchEvent>::instance();
+            report("pooled (refcounted)", {
+                { "events", to_string(events) },
+                { "events/sec", fmt(per_sec(events, ns)) },
+                { "peak threads", to_string(threads.stop()) },
+                { "pool allocations", to_string(pool.getAllocatedCount()) },
+                { "live", to_string(pool.getLiveCount()) },
+            });
+            if (consumer.received != events) throw ERROR("Lost events: " + to_string(events - consumer.received));
+        }
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Event queue benchmark: single producer / single consumer throughput of the
+// slot based RingBufferEventQueue (copy, move, emplace, zero-copy handle read)
+// compared with the former RingBuffer<Event> by-value queue (which sliced the
+// payload off and copied the base event on both write and read).
+//
+// usage: builds/benchmarks/event_queue [--events=1000000] [--capacity=1024]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/utils/Logger.hpp"
+#include "../tools/utils/RingBuffer.hpp"
+#include "../tools/_events/events.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::events;
+using namespace benchmarks;
+
+class SmallEvent: public TypedEvent<SmallEvent> {
+public:
+    SmallEvent(size_t seq = 0): seq(seq) {}
+    size_t seq;
+};
+
+class LargeEvent: public TypedEvent<LargeEvent> {
+public:
+    LargeEvent(size_t seq = 0): seq(seq), text(200, 'x') {}
+    size_t seq;
+    string text;
+    char payload[512] = {};
+};
+
+// Runs a producer and a consumer thread, returns the events/sec
+double run_spsc(size_t events, function<void(size_t)> produce, function<bool()> consume) {
+    long long ns = measure_ns([&]() {
+        thread consumer([&]() {
+            size_t received = 0;
+            while (received < events)
+                if (consume()) received++;
+        });
+        for (size_t i = 0; i < events; i++) produce(i);
+        consumer.join();
+    });
+    return per_sec(events, ns);
+}
+
+template<typename EventType>
+void bench(const string& name, size_t events, size_t capacity, Logger& logger) {
+    const ComponentId source = "bench";
+    // the queues never drop: the producer waits for room
+    auto waitRoom = [capacity](auto& queue) {
+        while (queue.available() >= capacity) this_thread::yield();
+    };
+
+    double legacy;
+    {
+        RingBuffer<Event> queue(capacity, RingBuffer<Event>::WritePolicy::Reject);
+        legacy = run_spsc(events, [&](size_t i) {
+            EventType event(i);
+            event.sourceId = source;
+            waitRoom(queue);
+            queue.write_one(event); // sliced copy
+        }, [&]() {
+            Event event;
+            return queue.read(&event, 1, true, 100) == 1;
+        });
+    }
+
+    double copied;
+    {
+        RingBufferEventQueue queue(capacity, logger);
+        copied = run_spsc(events, [&](size_t i) {
+            EventType event(i);
+            event.sourceId = source;
+            waitRoom(queue);
+            queue.write(event);
+        }, [&]() {
+            EventType event(0);
+            return queue.read(event, true, 100) == 1;
+        });
+    }
+
+    double moved;
+    {
+        RingBufferEventQueue queue(capacity, logger);
+        moved = run_spsc(events, [&](size_t i) {
+            EventType event(i);
+            event.sourceId = source;
+            waitRoom(queue);
+            queue.write(move(event));
+        }, [&]() {
+            EventHandle handle;
+            return queue.read(handle, true, 100) == 1;
+        });
+    }
+
+    double emplaced;
+    {
+        RingBufferEventQueue queue(capacity, logger);
+        emplaced = run_spsc(events, [&](size_t i) {
+            waitRoom(queue);
+            queue.emplace<EventType>(i);
+        }, [&]() {
+            EventHandle handle;
+            return queue.read(handle, true, 100) == 1;
+        });
+    }
+
+    report(name + " (" + to_string(sizeof(EventType)) + " bytes)", {
+        { "legacy RingBuffer<Event> events/sec", fmt(legacy) },
+        { "write(copy) + read(copy) events/sec", fmt(copied) },
+        { "write(move) + read(handle) events/sec", fmt(moved) },
+        { "emplace + read(handle) events/sec", fmt(emplaced) },
+    });
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t events = args.get<size_t>("events", 1000000);
+        size_t capacity = args.get<size_t>("capacity", 1024);
+
+        Logger logger("bench");
+        bench<SmallEvent>("small event", events, capacity, logger);
+        bench<LargeEvent>("large event (heap slot)", events, capacity, logger);
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Multi-producer / multi-consumer event queue benchmark: events/sec of the
+// mutex + condition variable RingBufferEventQueue and the LockFreeEventQueue
+// with 1..16 producers and consumers passing events by reference (push/pop).
+//
+// usage: builds/benchmarks/event_queue_mpmc [--events=1000000] [--capacity=1024] [--max-threads=16]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/utils/Logger.hpp"
+#include "../tools/_events/events.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::events;
+using namespace benchmarks;
+
+class BenchEvent: public TypedEvent<BenchEvent> {
+public:
+    BenchEvent(size_t seq = 0): seq(seq) {}
+    size_t seq;
+};
+
+// Pushes the events (each one held once) from the producers and pops them with the consumers,
+// the producers wait for room so drops only happen when they race for the last free cell
+template<typename Queue>
+double run_mpmc(Queue& queue, vector<BenchEvent>& events, size_t producers, size_t consumers, size_t& dropped) {
+    atomic<size_t> received = 0;
+    atomic<size_t> drops = 0;
+    queue.setDropCallback([&drops](size_t count) { drops += count; });
+    long long ns = measure_ns([&]() {
+        vector<thread> threads;
+        for (size_t c = 0; c < consumers; c++) {
+            threads.emplace_back([&]() {
+                Event* event = nullptr;
+                while (received + drops < events.size()) {
+                    if (!queue.pop(event, true, 10)) continue;
+                    event->release();
+                    received++;
+                }
+            });
+        }
+        for (size_t p = 0; p < producers; p++) {
+            threads.emplace_back([&, p]() {
+                for (size_t i = p; i < events.size(); i += producers) {
+                    events[i].hold();
+                    while (queue.available() >= queue.getCapacity()) this_thread::yield(); // never drop
+                    if (!queue.push(&events[i])) events[i].release(); // rejected
+                }
+            });
+        }
+        for (thread& t: threads) t.join();
+    });
+    dropped = drops;
+    return per_sec(events.size(), ns);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t count = args.get<size_t>("events", 1000000);
+        size_t capacity = args.get<size_t>("capacity", 1024);
+        size_t maxThreads = args.get<size_t>("max-threads", 16);
+
+        Logger logger("bench");
+        logger.setMinLogLevel(Logger::Level::ERROR); // drops are counted, not logged
+        vector<BenchEvent> events(count);
+
+        for (size_t threads = 1; threads <= maxThreads; threads <<= 1) {
+            size_t lockedDrops = 0, lockFreeDrops = 0;
+            RingBufferEventQueue ringBufferQueue(capacity, logger);
+            double locked = run_mpmc(ringBufferQueue, events, threads, threads, lockedDrops);
+            LockFreeEventQueue lockFreeQueue(capacity, logger, LockFreeEventQueue::WritePolicy::Reject);
+            double lockFree = run_mpmc(lockFreeQueue, events, threads, threads, lockFreeDrops);
+            report(to_string(threads) + " producer(s) x " + to_string(threads) + " consumer(s)", {
+                { "RingBufferEventQueue events/sec", fmt(locked) },
+                { "LockFreeEventQueue events/sec", fmt(lockFree) },
+                { "speedup", fmt(lockFree / locked, 2) + "x" },
+                { "drops", to_string(lockedDrops) + " / " + to_string(lockFreeDrops) },
+            });
+        }
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
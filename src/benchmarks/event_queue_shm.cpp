@@ -0,0 +1,127 @@
+// Shared memory event queue benchmark: a forked child process opens the peer
+// side of a SharedMemoryEventQueue and echoes every event back. Reports the
+// round trip latency percentiles (blocking reads, futex wakeups) and the
+// one-way events/sec of a burst that the child counts.
+//
+// usage: builds/benchmarks/event_queue_shm [--round-trips=100000] [--events=1000000] [--capacity=1024]
+
+#include <sys/wait.h>
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/utils/Logger.hpp"
+#include "../tools/_events/events.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::events;
+using namespace benchmarks;
+
+class PingEvent: public TypedEvent<PingEvent> {
+public:
+    PingEvent(int64_t seq = 0): seq(seq) {}
+    int64_t seq;
+};
+
+// seq < 0 ends the echo loop of the child, the reply carries how many it got
+// (the parent waits for a reply before the next round trip, so there is room)
+void echo(const string& name, EventCodecs& codecs, Logger& logger) {
+    SharedMemoryEventQueue queue(name, SharedMemoryEventQueue::Role::Peer, codecs, logger);
+    int64_t received = 0;
+    while (true) {
+        EventHandle handle;
+        if (!queue.read(handle, true, 1000)) continue;
+        PingEvent* ping = handle.as<PingEvent>();
+        if (!ping) continue;
+        if (ping->seq < 0) {
+            PingEvent done(received);
+            queue.write(done);
+            return;
+        }
+        received++;
+        if (ping->seq % 2 == 0) continue; // odd ones are round trips
+        queue.write(*ping);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t roundTrips = args.get<size_t>("round-trips", 100000);
+        size_t events = args.get<size_t>("events", 1000000);
+        size_t capacity = args.get<size_t>("capacity", 1024);
+
+        Logger logger("bench");
+        EventCodecs codecs;
+        codecs.add<PingEvent>("PingEvent",
+            [](BinaryWriter& writer, const PingEvent& event) { writer.write(event.seq); },
+            [](BinaryReader& reader) { return PingEvent(reader.read<int64_t>()); }
+        );
+        string name = "/prompt-bench-" + to_string(getpid());
+        SharedMemoryEventQueue queue(name, SharedMemoryEventQueue::Role::Owner, codecs, logger, capacity, 64,
+            SharedMemoryEventQueue::WritePolicy::Reject);
+
+        pid_t pid = fork();
+        if (pid < 0) throw ERROR("Unable to fork");
+        if (pid == 0) {
+            try {
+                echo(name, codecs, logger);
+            } catch (exception& e) {
+                cerr << "Child error: " << e.what() << endl;
+                _exit(1);
+            }
+            _exit(0);
+        }
+
+        vector<long long> samples;
+        samples.reserve(roundTrips);
+        for (size_t i = 0; i < roundTrips; i++) {
+            PingEvent ping(2 * (int64_t)i + 1);
+            EventHandle pong;
+            long long ns = measure_ns([&]() {
+                queue.write(ping);
+                while (!queue.read(pong, true, 1000));
+            });
+            if (!pong.as<PingEvent>() || pong.as<PingEvent>()->seq != ping.seq) throw ERROR("Unexpected reply");
+            samples.push_back(ns);
+        }
+        report("round trip (ns)", {
+            { "p50", to_string(percentile(samples, 50)) },
+            { "p99", to_string(percentile(samples, 99)) },
+            { "p99.9", to_string(percentile(samples, 99.9)) },
+        });
+
+        // the producer waits for room, nothing is dropped
+        long long ns = measure_ns([&]() {
+            auto waitRoom = [&]() {
+                while (queue.pending() >= queue.getCapacity()) this_thread::yield();
+            };
+            for (size_t i = 0; i < events; i++) {
+                PingEvent ping(2 * (int64_t)i);
+                waitRoom();
+                queue.write(ping);
+            }
+            PingEvent end(-1);
+            waitRoom();
+            queue.write(end);
+            EventHandle done;
+            while (!queue.read(done, true, 1000));
+            if (!done.as<PingEvent>() || done.as<PingEvent>()->seq != (int64_t)(roundTrips + events))
+                throw ERROR("Lost events");
+        });
+        report("one-way burst", {
+            { "events/sec", fmt(per_sec(events, ns)) },
+        });
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) throw ERROR("Child process failed");
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Message dispatch benchmark: packs handled by a worker that gets
+// strings (control messages compared by name, tool calls re-parsed from
+// JSON text by the recipient) versus one that gets Message variants
+// (a std::visit on the alternative, the tool call arguments parsed once
+// by the sender). Counts the making of the item as well, strings
+// allocate where a Control does not.
+//
+// usage: builds/benchmarks/message_dispatch [--packs=1000000]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/agency/Message.hpp"
+#include "../tools/agency/PackQueue.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency;
+using namespace benchmarks;
+
+struct Counts {
+    size_t controls = 0;
+    size_t texts = 0;
+    long long sum = 0; // of the tool call arguments, keeps the work
+};
+
+void handle(const string& item, Counts& counts) {
+    if (control_of(item)) { counts.controls++; return; }
+    if (!item.empty() && item[0] == '{') { // a tool call
+        json call = json::parse(item);
+        counts.sum += call["arguments"]["n"].get<long long>();
+        return;
+    }
+    counts.texts++;
+}
+
+void handle(const Message& item, Counts& counts) {
+    visit(overloaded{
+        [&](Control) { counts.controls++; },
+        [&](const Text&) { counts.texts++; },
+        [&](const ToolCall& call) { counts.sum += call.arguments["n"].get<long long>(); },
+        [](const auto&) {},
+    }, item);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t packs = args.get<size_t>("packs", 1000000);
+
+        // control messages only
+        Counts strings, messages;
+        double stringControls = per_sec(packs, measure_ns([&]() {
+            for (size_t i = 0; i < packs; i++) {
+                Pack<string> pack("user", "agency", string(i % 2 ? "list" : "exit"));
+                handle(pack.item.get(), strings);
+            }
+        }));
+        double messageControls = per_sec(packs, measure_ns([&]() {
+            for (size_t i = 0; i < packs; i++) {
+                Pack<Message> pack("user", "agency", Message(i % 2 ? Control::List : Control::Exit));
+                handle(pack.item.get(), messages);
+            }
+        }));
+        if (strings.controls != packs || messages.controls != packs) throw ERROR("Controls lost");
+
+        // a tool call in every 8th pack, text otherwise, the call is made
+        // (and its arguments parsed) once and sent to 4 recipients
+        size_t calls = packs / 4;
+        json arguments = { { "n", 1 } };
+        double stringMixed = per_sec(calls * 4, measure_ns([&]() {
+            for (size_t i = 0; i < calls; i++) {
+                Payload<string> item(i % 8 ? string("some text of a chat message") : json({ { "tool", "sum" }, { "arguments", arguments } }).dump());
+                for (int r = 0; r < 4; r++) handle(Pack<string>("user", "worker", item).item.get(), strings);
+            }
+        }));
+        double messageMixed = per_sec(calls * 4, measure_ns([&]() {
+            for (size_t i = 0; i < calls; i++) {
+                Payload<Message> item(i % 8 ? Message(Text("some text of a chat message")) : Message(ToolCall{ to_string(i), "sum", arguments }));
+                for (int r = 0; r < 4; r++) handle(Pack<Message>("user", "worker", item).item.get(), messages);
+            }
+        }));
+        if (strings.sum != messages.sum || strings.texts != messages.texts) throw ERROR("Items lost");
+
+        report("control packs", {
+            { "string packs/sec", fmt(stringControls) },
+            { "message", fmt(messageControls) + " (" + fmt(messageControls / stringControls, 1) + "x)" },
+        });
+        report("text and tool call packs", {
+            { "string packs/sec", fmt(stringMixed) },
+            { "message", fmt(messageMixed) + " (" + fmt(messageMixed / stringMixed, 1) + "x)" },
+        });
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Broadcast send benchmark: Worker::send() of a long item (e.g. an LLM
+// response) to many recipients, produced and consumed through a PackQueue.
+// The shared payload is allocated once per broadcast, the former way copied
+// the item into every pack (emulated here with one payload per recipient).
+// The single recipient send of an rvalue moves the item all the way.
+//
+// usage: builds/benchmarks/pack_broadcast [--broadcasts=2000] [--size=65536] [--recipients=16]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Owns.hpp"
+#include "../tools/utils/JSON.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/str/str_contains.hpp"
+#include "../tools/str/tpl_replace.hpp"
+#include "../tools/str/implode.hpp"
+#include "../tools/agency/Worker.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency;
+using namespace benchmarks;
+
+class Broadcaster: public Worker<string> {
+public:
+    using Worker<string>::Worker;
+
+    string type() const override { return "broadcaster"; }
+    void handle(const string&, const string&) override {}
+
+    void broadcast(const string& item) { send(item); }
+    void broadcast(string&& item) { send(move(item)); }
+
+    // The former send(): a copy of the item in every pack
+    void broadcastCopies(const string& item) {
+        for (const string& recipient: recipients)
+            queue.Produce(Pack<string>(id, recipient, Payload<string>(item)));
+    }
+};
+
+template<typename Send>
+double run(PackQueue<string>& queue, size_t broadcasts, Send send) {
+    Pack<string> pack;
+    size_t bytes = 0;
+    long long ns = measure_ns([&]() {
+        for (size_t i = 0; i < broadcasts; i++) {
+            send();
+            while (queue.Consume(pack)) bytes += pack.item.get().size();
+        }
+    });
+    if (!bytes) throw ERROR("Nothing delivered");
+    return per_sec(broadcasts, ns);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t broadcasts = args.get<size_t>("broadcasts", 2000);
+        size_t size = args.get<size_t>("size", 65536);
+        size_t count = args.get<size_t>("recipients", 16);
+
+        Owns owns;
+        PackQueue<string> queue;
+        Broadcaster sender(owns, nullptr, queue, "sender");
+        vector<string> recipients;
+        for (size_t i = 0; i < count; i++) recipients.push_back("agent" + to_string(i));
+        sender.setRecipients(recipients);
+        string item(size, 'x');
+
+        double copies = run(queue, broadcasts, [&]() { sender.broadcastCopies(item); });
+        double shared = run(queue, broadcasts, [&]() { sender.broadcast(item); });
+        report("broadcast to " + to_string(count), {
+            { "copies/sec", fmt(copies) },
+            { "shared", fmt(shared) + " (" + fmt(shared / copies, 1) + "x)" },
+            { "bytes copied", to_string(size * count) + " -> " + to_string(size) },
+        });
+
+        sender.setRecipients({ "agent0" });
+        double copied = run(queue, broadcasts, [&]() { sender.broadcast(item); });
+        double moved = run(queue, broadcasts, [&]() { sender.broadcast(string(item)); });
+        report("single recipient (incl. making the item)", {
+            { "lvalue sends/sec", fmt(copied) },
+            { "rvalue", fmt(moved) },
+        });
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
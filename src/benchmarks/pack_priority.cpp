@@ -0,0 +1,150 @@
+// Priority lanes benchmark: a backlog of background packs keeps the
+// agency's pool busy (each takes --work microseconds to handle) while
+// interactive packs come every --interval milliseconds, measures the
+// latency of the interactive packs from Produce() to handle():
+//   fifo: everything in the normal lane, as before the lanes
+//   strict / fair: interactive and background lanes, strict priority or
+//   weighted-fair dequeue, the background handle() runs to its end
+//   preempt: strict, and the background handle() yields when preempted
+//
+// usage: builds/benchmarks/pack_priority [--threads=2] [--workers=8] [--backlog=4000]
+//                                        [--work=100] [--interactive=50] [--interval=2]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Owns.hpp"
+#include "../tools/utils/JSON.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/str/str_contains.hpp"
+#include "../tools/str/tpl_replace.hpp"
+#include "../tools/str/implode.hpp"
+#include "../tools/containers/in_array.hpp"
+#include "../tools/agency/Agency.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency;
+using namespace benchmarks;
+
+long long now_ns() {
+    return chrono::steady_clock::now().time_since_epoch().count();
+}
+
+// Spins on each pack, gives up early when preempted (if cooperative)
+class BusyWorker: public Worker<string> {
+public:
+    BusyWorker(Owns& owns, Worker<string>* agency, PackQueue<string>& queue, const string& name, long long workNs, bool cooperative, atomic<size_t>& yields):
+        Worker<string>(owns, agency, queue, name), workNs(workNs), cooperative(cooperative), yields(yields) {}
+
+    string type() const override { return "busy"; }
+
+    void handle(const string&, const string&) override {
+        long long end = now_ns() + workNs;
+        while (now_ns() < end)
+            if (cooperative && isPreempted()) {
+                yields++;
+                return;
+            }
+    }
+
+private:
+    long long workNs;
+    bool cooperative;
+    atomic<size_t>& yields;
+};
+
+// Timestamps the interactive packs
+class ChatWorker: public Worker<string> {
+public:
+    using Worker<string>::Worker;
+
+    string type() const override { return "chat"; }
+
+    void handle(const string&, const string&) override {
+        handledAt.push_back(now_ns());
+        handled.fetch_add(1, memory_order_release);
+    }
+
+    vector<long long> handledAt;
+    atomic<size_t> handled = 0;
+};
+
+struct Result {
+    vector<long long> latencies;
+    size_t yields = 0;
+};
+
+Result run(bool lanes, LanePolicy policy, bool cooperative, size_t threads, size_t workers, size_t backlog, long long workNs, size_t interactive, long intervalMs) {
+    Owns owns;
+    AgentRoleMap roles;
+    PackQueue<string> queue;
+    atomic<size_t> yields = 0;
+    Result result;
+    {
+        Agency<string> agency(owns, roles, queue, "agency");
+        agency.setThreads(threads);
+        queue.setLanePolicy(policy);
+        for (size_t i = 0; i < workers; i++)
+            agency.spawn<BusyWorker>(owns, &agency, queue, "busy" + to_string(i), workNs, cooperative, yields);
+        ChatWorker& chat = agency.spawn<ChatWorker>(owns, &agency, queue, "chat");
+        agency.start();
+
+        Priority background = lanes ? Priority::Background : Priority::Normal;
+        Priority urgent = lanes ? Priority::Interactive : Priority::Normal;
+        for (size_t i = 0; i < backlog; i++)
+            queue.Produce(Pack<string>("agent", "busy" + to_string(i % workers), "job", background));
+        vector<long long> producedAt;
+        for (size_t i = 0; i < interactive; i++) {
+            this_thread::sleep_for(chrono::milliseconds(intervalMs));
+            producedAt.push_back(now_ns());
+            queue.Produce(Pack<string>("user", "chat", "hello", urgent));
+        }
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(60);
+        while (chat.handled.load(memory_order_acquire) < interactive)
+            if (chrono::steady_clock::now() > deadline) throw ERROR("Interactive packs lost");
+            else this_thread::sleep_for(chrono::microseconds(100));
+        for (size_t i = 0; i < interactive; i++) result.latencies.push_back(chat.handledAt[i] - producedAt[i]);
+        for (size_t i = 0; i < workers; i++) queue.drop("busy" + to_string(i)); // the rest of the backlog
+        result.yields = yields;
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t threads = args.get<size_t>("threads", 2);
+        size_t workers = args.get<size_t>("workers", 8);
+        size_t backlog = args.get<size_t>("backlog", 4000);
+        long long workNs = args.get<long long>("work", 100) * 1000;
+        size_t interactive = args.get<size_t>("interactive", 50);
+        long intervalMs = args.get<long>("interval", 2);
+
+        struct Mode {
+            string name;
+            bool lanes;
+            LanePolicy policy;
+            bool cooperative;
+        };
+        for (const Mode& mode: vector<Mode>({
+            { "fifo", false, LanePolicy::Strict, false },
+            { "strict", true, LanePolicy::Strict, false },
+            { "fair", true, LanePolicy::WeightedFair, false },
+            { "preempt", true, LanePolicy::Strict, true },
+        })) {
+            Result result = run(mode.lanes, mode.policy, mode.cooperative, threads, workers, backlog, workNs, interactive, intervalMs);
+            report(mode.name, {
+                { "interactive p50 us", fmt(percentile(result.latencies, 50) / 1000.0, 1) },
+                { "p99 us", fmt(percentile(result.latencies, 99) / 1000.0, 1) },
+                { "max us", fmt(percentile(result.latencies, 100) / 1000.0, 1) },
+                { "yields", to_string(result.yields) },
+            });
+        }
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
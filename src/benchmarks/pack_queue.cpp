@@ -0,0 +1,147 @@
+// PackQueue benchmark: produce + consume throughput, the time of a drop()
+// with many packs queued, and the Produce() latency seen by a producer
+// while another thread keeps dropping a recipient.
+// Compared with the former std::queue based queue that filtered every pack
+// into a temporary queue under the lock on drop.
+//
+// usage: builds/benchmarks/pack_queue [--packs=1000000] [--queued=100000] [--recipients=100]
+
+#include <queue>
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/agency/PackQueue.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency;
+using namespace benchmarks;
+
+// The former queue (std::queue under a mutex, filtering drop)
+class LegacyPackQueue {
+public:
+    void Produce(Pack<string>&& pack) {
+        lock_guard<mutex> lock(mtx);
+        q.push(move(pack));
+    }
+
+    bool Consume(Pack<string>& pack) {
+        lock_guard<mutex> lock(mtx);
+        if (q.empty()) return false;
+        pack = move(q.front());
+        q.pop();
+        return true;
+    }
+
+    void drop(const WorkerId& recipient) {
+        lock_guard<mutex> lock(mtx);
+        queue<Pack<string>> temp;
+        while (!q.empty()) {
+            Pack<string> pack = move(q.front());
+            q.pop();
+            if (!(pack.recipient == recipient)) temp.push(move(pack));
+        }
+        q = move(temp);
+    }
+
+private:
+    mutex mtx;
+    queue<Pack<string>> q;
+};
+
+vector<WorkerId> makeRecipients(size_t count) {
+    vector<WorkerId> recipients;
+    for (size_t i = 0; i < count; i++) recipients.push_back(WorkerId("agent" + to_string(i)));
+    return recipients;
+}
+
+template<typename Queue>
+double throughput(size_t packs, const vector<WorkerId>& recipients) {
+    Queue queue;
+    WorkerId sender("user");
+    Pack<string> pack;
+    long long ns = measure_ns([&]() {
+        for (size_t i = 0; i < packs; i++) {
+            queue.Produce(Pack<string>(sender, recipients[i % recipients.size()], "hello"));
+            if (!queue.Consume(pack)) throw ERROR("Lost pack");
+        }
+    });
+    return per_sec(packs, ns);
+}
+
+template<typename Queue>
+long long dropTime(size_t queued, const vector<WorkerId>& recipients) {
+    Queue queue;
+    WorkerId sender("user");
+    for (size_t i = 0; i < queued; i++)
+        queue.Produce(Pack<string>(sender, recipients[i % recipients.size()], "hello"));
+    return measure_ns([&]() { queue.drop(recipients[0]); });
+}
+
+// Produce() latencies while another thread fills and drops a recipient
+template<typename Queue>
+vector<long long> producerStall(size_t packs, size_t queued, const vector<WorkerId>& recipients) {
+    Queue queue;
+    WorkerId sender("user");
+    for (size_t i = 0; i < queued; i++)
+        queue.Produce(Pack<string>(sender, recipients[1 + i % (recipients.size() - 1)], "keep"));
+    atomic<bool> running = true;
+    thread killer([&]() {
+        while (running) {
+            for (int i = 0; i < 100; i++) queue.Produce(Pack<string>(sender, recipients[0], "doomed"));
+            queue.drop(recipients[0]);
+        }
+    });
+    vector<long long> samples;
+    samples.reserve(packs);
+    for (size_t i = 0; i < packs; i++) {
+        samples.push_back(measure_ns([&]() {
+            queue.Produce(Pack<string>(sender, recipients[1 + i % (recipients.size() - 1)], "hello"));
+        }));
+    }
+    running = false;
+    killer.join();
+    return samples;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t packs = args.get<size_t>("packs", 1000000);
+        size_t queued = args.get<size_t>("queued", 100000);
+        size_t count = args.get<size_t>("recipients", 100);
+        if (count < 2) throw ERROR("At least 2 recipients needed");
+        vector<WorkerId> recipients = makeRecipients(count);
+
+        double legacyRate = throughput<LegacyPackQueue>(packs, recipients);
+        double rate = throughput<PackQueue<string>>(packs, recipients);
+        report("produce + consume", {
+            { "legacy packs/sec", fmt(legacyRate) },
+            { "segmented", fmt(rate) + " (" + fmt(rate / legacyRate, 1) + "x)" },
+        });
+
+        long long legacyDrop = dropTime<LegacyPackQueue>(queued, recipients);
+        long long drop = dropTime<PackQueue<string>>(queued, recipients);
+        report("drop of " + to_string(queued) + " queued (ns)", {
+            { "legacy", to_string(legacyDrop) },
+            { "segmented", to_string(drop) },
+        });
+
+        size_t stallPacks = min<size_t>(packs, 200000);
+        vector<long long> legacyStall = producerStall<LegacyPackQueue>(stallPacks, queued, recipients);
+        vector<long long> stall = producerStall<PackQueue<string>>(stallPacks, queued, recipients);
+        report("Produce() during drops (ns)", {
+            { "legacy p99.9", to_string(percentile(legacyStall, 99.9)) },
+            { "max", to_string(percentile(legacyStall, 100)) },
+            { "segmented p99.9", to_string(percentile(stall, 99.9)) },
+            { "max", to_string(percentile(stall, 100)) },
+        });
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
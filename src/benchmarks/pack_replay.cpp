@@ -0,0 +1,85 @@
+// Pack replay benchmark: feeds a pack log recorded with `/record start`
+// (or synthesized traffic) into a fresh agency with mock workers, at the
+// recorded timing or as fast as possible, and reports the throughput and
+// the produce-to-handle latency percentiles. The same log replays the
+// same traffic, so runs before and after a change compare like for like.
+// Also measures the recording overhead on the produce path.
+//
+// usage: builds/benchmarks/pack_replay [--log=packs.pklg] [--speed=0] [--threads=0]
+//                                      [--packs=100000] [--workers=8]
+
+#include <unistd.h>
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Owns.hpp"
+#include "../tools/utils/JSON.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/str/str_contains.hpp"
+#include "../tools/str/tpl_replace.hpp"
+#include "../tools/str/implode.hpp"
+#include "../tools/containers/in_array.hpp"
+#include "../tools/agency/PackReplay.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency;
+using namespace benchmarks;
+
+// Records round-robin traffic into a log, returns the produce rate
+double synthesize(const string& filename, size_t packs, size_t workers, bool recording) {
+    PackQueue<string> queue;
+    PackRecorder<string> recorder(filename);
+    if (recording) queue.setRecorder(&recorder);
+    Pack<string> pack;
+    long long ns = measure_ns([&]() {
+        for (size_t i = 0; i < packs; i++) {
+            queue.Produce(Pack<string>("user", "worker" + to_string(i % workers), "hello"));
+            if (!queue.Consume(pack)) throw ERROR("Packs lost");
+        }
+    });
+    queue.setRecorder(nullptr);
+    return per_sec(packs, ns);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        string log = args.has("log") ? args.get<string>("log") : "";
+        double speed = args.get<double>("speed", 0);
+        size_t threads = args.get<size_t>("threads", 0);
+
+        if (log.empty()) {
+            size_t packs = args.get<size_t>("packs", 100000);
+            size_t workers = args.get<size_t>("workers", 8);
+            log = "/tmp/pack_replay_" + to_string(getpid()) + ".pklg";
+            double plain = synthesize(log, packs, workers, false);
+            double recorded = synthesize(log, packs, workers, true);
+            report("recording " + to_string(packs) + " packs", {
+                { "produce+consume packs/sec", fmt(plain) },
+                { "recording", fmt(recorded) + " (" + fmt(recorded / plain, 2) + "x)" },
+            });
+        }
+
+        vector<RecordedPack<string>> packs = PackRecorder<string>::read(log);
+        PackReplay<string>::Result result = PackReplay<string>::run(packs, speed, threads);
+        if (log.rfind("/tmp/pack_replay_", 0) == 0) remove(log.c_str());
+
+        report("replay of " + to_string(result.packs) + " packs", {
+            { "skipped", to_string(result.skipped) },
+            { "speed", speed > 0 ? fmt(speed, 1) + "x" : string("max") },
+            { "threads", to_string(threads) },
+            { "packs/sec", fmt(result.throughput()) },
+            { "p50 latency ns", to_string(percentile(result.latencies, 50)) },
+            { "p90 latency ns", to_string(percentile(result.latencies, 90)) },
+            { "p99 latency ns", to_string(percentile(result.latencies, 99)) },
+            { "max latency ns", to_string(percentile(result.latencies, 100)) },
+        });
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
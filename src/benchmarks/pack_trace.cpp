@@ -0,0 +1,65 @@
+// Tracing overhead benchmark: PackQueue produce/consume round trips with
+// the tracer off (an atomic load per recording point) and on (an enqueue
+// span and flow event per pack into the per-thread ring), then the time
+// it takes to dump the recorded ring as Chrome trace JSON.
+//
+// usage: builds/benchmarks/pack_trace [--packs=1000000]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/utils/Tracer.hpp"
+#include "../tools/agency/PackQueue.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency;
+using namespace benchmarks;
+
+double run(PackQueue<string>& queue, size_t packs) {
+    Pack<string> pack;
+    size_t consumed = 0;
+    long long ns = measure_ns([&]() {
+        for (size_t i = 0; i < packs; i++) {
+            queue.Produce(Pack<string>("sender", "recipient", "hello"));
+            if (queue.Consume(pack)) consumed++;
+        }
+    });
+    if (consumed != packs) throw ERROR("Packs lost");
+    return per_sec(packs, ns);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t packs = args.get<size_t>("packs", 1000000);
+
+        PackQueue<string> queue;
+        Tracer& tracer = Tracer::instance();
+
+        tracer.enable(false);
+        double off = run(queue, packs);
+        tracer.enable();
+        double on = run(queue, packs);
+        tracer.enable(false);
+        report("produce + consume", {
+            { "tracing off packs/sec", fmt(off) },
+            { "tracing on", fmt(on) + " (" + fmt(on / off, 2) + "x)" },
+        });
+
+        string json;
+        size_t events = tracer.collect().size();
+        long long ns = measure_ns([&]() { json = tracer.dump(); });
+        report("dump", {
+            { "events", to_string(events) },
+            { "ms", fmt(ns / 1e6, 1) },
+            { "bytes", to_string(json.size()) },
+        });
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
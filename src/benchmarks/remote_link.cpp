@@ -0,0 +1,104 @@
+// Remote transport benchmark: small pack frames sent over a Unix domain
+// socket to another node. The Link appends to its outbox and its writer
+// thread writes the frames piled up meanwhile in one go (batching, no
+// waiting for replies); the baseline writes each frame with its own call.
+//
+// usage: builds/benchmarks/remote_link [--frames=200000] [--size=64]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/agency/remote/Link.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency::remote;
+using namespace benchmarks;
+
+// Counts the frames arriving at the other end
+class Counter {
+public:
+    void add() {
+        lock_guard<mutex> lock(mtx);
+        if (++count == expected) done.notify_one();
+    }
+
+    void expect(size_t frames) {
+        lock_guard<mutex> lock(mtx);
+        count = 0;
+        expected = frames;
+    }
+
+    void wait() {
+        unique_lock<mutex> lock(mtx);
+        if (!done.wait_for(lock, chrono::seconds(60), [&]() { return count >= expected; }))
+            throw ERROR("Frames lost");
+    }
+
+private:
+    mutex mtx;
+    condition_variable done;
+    size_t count = 0;
+    size_t expected = 0;
+};
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t frames = args.get<size_t>("frames", 200000);
+        size_t size = args.get<size_t>("size", 64);
+        Frame frame{ FrameType::Pack, { "sender", "recipient", string(size, 'x') } };
+
+        // one write per frame
+        double unbatched = 0;
+        {
+            auto [a, b] = UnixSocket::makePair();
+            Counter counter;
+            Link receiver(move(b));
+            receiver.start([&](Frame&) { counter.add(); }, []() {});
+            counter.expect(frames);
+            string bytes;
+            long long ns = measure_ns([&]() {
+                for (size_t i = 0; i < frames; i++) {
+                    bytes.clear();
+                    Wire::encode(frame, bytes);
+                    if (!a.write(bytes.data(), bytes.size())) throw ERROR("Peer gone");
+                }
+                counter.wait();
+            });
+            unbatched = per_sec(frames, ns);
+        }
+
+        // through the link
+        double batched = 0;
+        LinkStats stats;
+        {
+            auto [a, b] = UnixSocket::makePair();
+            Counter counter;
+            Link sender(move(a));
+            Link receiver(move(b));
+            sender.start([](Frame&) {}, []() {});
+            receiver.start([&](Frame&) { counter.add(); }, []() {});
+            counter.expect(frames);
+            long long ns = measure_ns([&]() {
+                for (size_t i = 0; i < frames; i++)
+                    if (!sender.send(frame)) throw ERROR("Link closed");
+                counter.wait();
+            });
+            batched = per_sec(frames, ns);
+            stats = sender.getStats();
+        }
+
+        report("pack frames of " + to_string(size) + " bytes", {
+            { "write per frame frames/sec", fmt(unbatched) },
+            { "link", fmt(batched) + " (" + fmt(batched / unbatched, 1) + "x)" },
+            { "frames per write", fmt((double)stats.sent / max<size_t>(1, stats.writes), 1) },
+        });
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// RingBuffer<float> block copy benchmark: write + read throughput at several
+// block sizes of the segmented memcpy RingBuffer (modulo and power of two
+// mask capacities) and the SpscRingBuffer, compared with the former element
+// by element copy (a modulo per sample). Single threaded, so it measures
+// the copies and the locking, not the contention.
+//
+// usage: builds/benchmarks/ring_buffer [--samples=50000000] [--capacity=80000]
+
+#include "../tools/utils/ERROR.hpp"
+#include "../tools/utils/Arguments.hpp"
+#include "../tools/utils/RingBuffer.hpp"
+#include "../tools/utils/SpscRingBuffer.hpp"
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace benchmarks;
+
+// The copy loops of the former RingBuffer (Rotate policy)
+class LegacyRingBuffer {
+public:
+    LegacyRingBuffer(size_t capacity): buffer(capacity), capacity(capacity) {}
+
+    bool write(const float* data, size_t count) {
+        {
+            lock_guard<mutex> lock(mtx);
+            size_t current_size = size.load(memory_order_acquire);
+            if (current_size + count > capacity) {
+                size_t excess = (current_size + count) - capacity;
+                readPos = (readPos + excess) % capacity;
+                current_size = current_size > excess ? current_size - excess : 0;
+            }
+            for (size_t i = 0; i < count; ++i)
+                buffer[(writePos + i) % capacity] = data[i];
+            writePos = (writePos + count) % capacity;
+            size.store(min(capacity, current_size + count), memory_order_release);
+        }
+        cv.notify_one();
+        return true;
+    }
+
+    size_t read(float* dest, size_t maxCount) {
+        unique_lock<mutex> lock(mtx);
+        size_t current_size = size.load(memory_order_acquire);
+        if (current_size == 0) return 0;
+        size_t toRead = min(current_size, maxCount);
+        for (size_t i = 0; i < toRead; ++i)
+            dest[i] = buffer[(readPos + i) % capacity];
+        readPos = (readPos + toRead) % capacity;
+        size.store(current_size - toRead, memory_order_release);
+        return toRead;
+    }
+
+private:
+    vector<float> buffer;
+    size_t capacity;
+    size_t readPos = 0;
+    size_t writePos = 0;
+    atomic<size_t> size = 0;
+    mutex mtx;
+    condition_variable cv;
+};
+
+// Samples/sec of writing then reading the samples block by block
+template<typename Ring>
+double bench(Ring& ring, size_t samples, size_t block) {
+    vector<float> in(block, 0.5f);
+    vector<float> out(block);
+    size_t blocks = max<size_t>(1, samples / block);
+    float sink = 0;
+    long long ns = measure_ns([&]() {
+        for (size_t i = 0; i < blocks; i++) {
+            in[0] = (float)i;
+            ring.write(in.data(), block);
+            ring.read(out.data(), block);
+            sink += out[0];
+        }
+    });
+    if (sink < 0) throw ERROR("Unexpected samples");
+    return per_sec(blocks * block, ns);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        Arguments args(argc, argv);
+        size_t samples = args.get<size_t>("samples", 50000000);
+        size_t capacity = args.get<size_t>("capacity", 80000);
+
+        for (size_t block: { 1, 64, 512, 1024, 4096 }) {
+            LegacyRingBuffer legacy(capacity);
+            RingBuffer<float> modulo(capacity, RingBuffer<float>::WritePolicy::Rotate);
+            RingBuffer<float> masked(capacity, RingBuffer<float>::WritePolicy::Rotate, true);
+            SpscRingBuffer<float> spsc(capacity);
+            double legacyRate = bench(legacy, samples, block);
+            double moduloRate = bench(modulo, samples, block);
+            double maskedRate = bench(masked, samples, block);
+            double spscRate = bench(spsc, samples, block);
+            report("block of " + to_string(block), {
+                { "legacy samples/sec", fmt(legacyRate) },
+                { "memcpy", fmt(moduloRate) + " (" + fmt(moduloRate / legacyRate, 1) + "x)" },
+                { "memcpy + mask", fmt(maskedRate) + " (" + fmt(maskedRate / legacyRate, 1) + "x)" },
+                { "spsc", fmt(spscRate) + " (" + fmt(spscRate / legacyRate, 1) + "x)" },
+            });
+        }
+
+    } catch (exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -4,6 +4,7 @@
 
 #include "../utils/ERROR.hpp"
 #include "EventBus.hpp"
+#include "EventHandlers.hpp"
 #include "EventAgent.hpp"
 
 using namespace std;
@@ -31,17 +32,15 @@ namespace tools::events {
         }
         
         bool canHandle(type_index eventType) const override {
-            return m_handlerMap.find(eventType) != m_handlerMap.end();
+            return m_handlers.has(event_type_id(eventType));
+        }
+
+        bool canHandleType(EventTypeId eventTypeId) const override {
+            return m_handlers.has(eventTypeId);
         }
         
         void handleEvent(Event& event) override {
-            lock_guard<mutex> lock(handlerMutex);
-            auto it = m_handlerMap.find(event.getType());
-            if (it != m_handlerMap.end()) {
-                for (const auto& handler : it->second) {
-                    handler(event); // Run all handlers
-                }
-            }
+            m_handlers.dispatch(event);
         }
 
         template<typename EventType, typename... Args>
@@ -52,14 +51,9 @@ namespace tools::events {
 
         template<typename EventType>
         void registerHandler(function<void(EventType&)> handler) {
-            type_index typeIdx(typeid(EventType));
-            auto eventHandler = [handler](Event& baseEvent) {
-                EventType& derivedEvent = (EventType&)baseEvent;
-                handler(derivedEvent);
-            };
-            m_handlerMap[typeIdx].push_back(eventHandler); // Append, don’t overwrite
+            EventTypeId eventTypeId = m_handlers.add<EventType>(handler);
             if (m_eventBus) {
-                m_eventBus->registerEventInterest(m_id, typeIdx);
+                m_eventBus->registerEventInterest(m_id, eventTypeId);
             }
         }
         
@@ -70,8 +64,7 @@ namespace tools::events {
     private:
         ComponentId m_id;
         EventBus* m_eventBus = nullptr;
-        unordered_map<type_index, vector<function<void(Event&)>>> m_handlerMap;
-        mutex handlerMutex;  // Added for thread safety
+        EventHandlers m_handlers;
     };    
 
 }
@@ -6,6 +6,7 @@
 
 #include "Event.hpp"
 #include "EventBus.hpp"
+#include "EventHandlers.hpp"
 #include "EventConsumer.hpp"
 
 using namespace std;
@@ -32,33 +33,22 @@ namespace tools::events {
         }
         
         bool canHandle(type_index eventType) const override {
-            return m_handlerMap.find(eventType) != m_handlerMap.end();
+            return m_handlers.has(event_type_id(eventType));
+        }
+
+        bool canHandleType(EventTypeId eventTypeId) const override {
+            return m_handlers.has(eventTypeId);
         }
         
         void handleEvent(Event& event) override {
-            lock_guard<mutex> lock(handlerMutex);
-            auto it = m_handlerMap.find(event.getType());
-            if (it != m_handlerMap.end()) {
-                for (auto& handler : it->second) {
-                    handler(event);
-                }
-            }
+            m_handlers.dispatch(event);
         }
 
         template<typename EventType>
         void registerHandler(function<void(EventType&)> handler) {
-            type_index typeIdx(typeid(EventType));
-            
-            auto wrapper = [handler](Event& baseEvent) {
-                EventType& derivedEvent = (EventType&)baseEvent;
-                handler(derivedEvent);
-            };
-            
-            // Just add the new handler
-            m_handlerMap[typeIdx].push_back(wrapper);
-            
+            EventTypeId eventTypeId = m_handlers.add<EventType>(handler);
             if (m_eventBus) {
-                m_eventBus->registerEventInterest(m_id, typeIdx);
+                m_eventBus->registerEventInterest(m_id, eventTypeId);
             }
         }
         
@@ -69,8 +59,7 @@ namespace tools::events {
     private:
         ComponentId m_id;
         EventBus* m_eventBus;
-        unordered_map<type_index, vector<function<void(Event&)>>> m_handlerMap;
-        mutex handlerMutex;  // Added for thread safety
+        EventHandlers m_handlers;
     };
 
 }
@@ -35,6 +35,13 @@ namespace tools::events {
             m_eventBus->createAndPublishEvent<EventType>(m_id, targetId, forward<Args>(args)...);
         }
 
+        // Collects a run of events (eg. audio frames, LLM chunks) to publish them
+        // at once, see EventBus::Batch
+        EventBus::Batch createBatch(size_t reserve = 0) {
+            NULLCHK(m_eventBus, "Cannot create batch, event bus is nullptr.");
+            return m_eventBus->createBatch(m_id, reserve);
+        }
+
     private:
         ComponentId m_id;
         EventBus* m_eventBus = nullptr;
@@ -175,10 +182,29 @@ void test_BaseEventProducer_publishEvent_multiple_types() {
     assert(receivedOther->sourceId == "producer1" && "OtherEvent should have producer's ID as source");
 }
 
+// Test publishing a batch with the producer's id
+void test_BaseEventProducer_createBatch() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue);
+    BaseEventProducer producer("producer1");
+    MockConsumer consumer("consumer1");
+    producer.registerWithEventBus(&bus);
+    consumer.registerWithEventBus(&bus);
+    {
+        EventBus::Batch batch = producer.createBatch();
+        batch.add<TestEvent>("consumer1", 1);
+        batch.add<TestEvent>("consumer1", 2);
+    }
+    assert(consumer.receivedEvents.size() == 2 && "Consumer should receive the batch");
+    assert(consumer.receivedEvents[1]->sourceId == "producer1" && "Batch events should have the producer's ID as source");
+}
+
 // Register tests
 TEST(test_BaseEventProducer_getId_basic);
 TEST(test_BaseEventProducer_publishEvent_with_bus);
 TEST(test_BaseEventProducer_publishEvent_no_bus);
 TEST(test_BaseEventProducer_publishEvent_concurrent);
 TEST(test_BaseEventProducer_publishEvent_multiple_types);
+TEST(test_BaseEventProducer_createBatch);
 #endif
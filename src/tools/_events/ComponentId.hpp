@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <ostream>
+#include <functional>
+
+#include "../utils/Interner.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::events {
+
+    /**
+     * Unique identifier for components in the system
+     *
+     * The names are interned (see Interner): an id is a pointer to the one
+     * shared copy of the name plus a dense integer index, so it is copied,
+     * compared and hashed without touching the string. Interning takes a
+     * lock, so keep ids around instead of building them from strings on
+     * hot paths.
+     */
+    class ComponentId {
+    public:
+        ComponentId(): entry(&getInterner().empty()) {}
+        ComponentId(const string& name): entry(&getInterner().intern(name)) {}
+        ComponentId(const char* name): entry(&getInterner().intern(name)) {}
+
+        // Dense index, 0 is the empty id
+        size_t getIndex() const { return entry->index; }
+
+        const string& str() const { return entry->text; }
+        operator const string&() const { return entry->text; }
+        bool empty() const { return entry->index == 0; }
+
+        bool operator==(const ComponentId& other) const { return entry == other.entry; }
+        bool operator<(const ComponentId& other) const { return entry->text < other.entry->text; }
+
+        // The id of an interned index (the empty id for unknown indexes)
+        static ComponentId fromIndex(size_t index) {
+            ComponentId id;
+            if (const Interner::Entry* entry = getInterner().at(index)) id.entry = entry;
+            return id;
+        }
+
+        // Number of interned ids (all the indexes are below)
+        static size_t getCount() {
+            return getInterner().size();
+        }
+
+    private:
+        static Interner& getInterner() {
+            static Interner interner;
+            return interner;
+        }
+
+        const Interner::Entry* entry;
+    };
+
+    inline string operator+(const string& lhs, const ComponentId& rhs) {
+        return lhs + rhs.str();
+    }
+
+    inline string operator+(const ComponentId& lhs, const string& rhs) {
+        return lhs.str() + rhs;
+    }
+
+    inline ostream& operator<<(ostream& os, const ComponentId& id) {
+        return os << id.str();
+    }
+
+}
+
+template<>
+struct std::hash<tools::events::ComponentId> {
+    size_t operator()(const tools::events::ComponentId& id) const noexcept {
+        return id.getIndex();
+    }
+};
+
+#ifdef TEST
+
+#include "../utils/Test.hpp"
+
+using namespace tools::events;
+
+void test_ComponentId_interned() {
+    ComponentId a = "component-a";
+    ComponentId b = string("component-a");
+    ComponentId c = "component-c";
+    assert(a == b && "Same names should give equal ids");
+    assert(a.getIndex() == b.getIndex() && "Same names should share the index");
+    assert(!(a == c) && "Different names should give different ids");
+    assert(a.str() == "component-a" && "Id should keep its name");
+    assert(a.getIndex() < ComponentId::getCount() && "Index should be below the interned count");
+    assert(ComponentId::fromIndex(a.getIndex()) == a && "Index should map back to the id");
+}
+
+void test_ComponentId_empty() {
+    ComponentId empty;
+    assert(empty.empty() && "Default id should be empty");
+    assert(empty.getIndex() == 0 && "Empty id should have index 0");
+    assert(ComponentId("") == empty && "Empty name should give the empty id");
+    assert(!ComponentId("x").empty() && "Named id should not be empty");
+}
+
+void test_ComponentId_string_interop() {
+    ComponentId id = "worker";
+    string name = id;
+    assert(name == "worker" && "Id should convert to its name");
+    assert("id: " + id == "id: worker" && "Id should concatenate with strings");
+    assert(hash<ComponentId>()(id) == id.getIndex() && "Id should hash to its index");
+}
+
+TEST(test_ComponentId_interned);
+TEST(test_ComponentId_empty);
+TEST(test_ComponentId_string_interop);
+
+#endif
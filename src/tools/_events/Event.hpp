@@ -1,46 +1,168 @@
 #pragma once
 
+#include <new>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
 #include <typeindex>
+#include <unordered_map>
+
+#include "ComponentId.hpp"
 
 using namespace std;
 
 namespace tools::events {
 
-    // Unique identifier for components in the system
-    using ComponentId = string;
+    // Dense integer id of an event type, given in order of first use
+    using EventTypeId = size_t;
+
+    struct EventTypeRegistry {
+        mutex mtx;
+        unordered_map<type_index, EventTypeId> ids;
+        vector<type_index> types;
+
+        static EventTypeRegistry& instance() {
+            static EventTypeRegistry registry;
+            return registry;
+        }
+    };
+
+    inline EventTypeId event_type_id(type_index type) {
+        EventTypeRegistry& registry = EventTypeRegistry::instance();
+        lock_guard<mutex> lock(registry.mtx);
+        auto [it, inserted] = registry.ids.emplace(type, registry.types.size());
+        if (inserted) registry.types.push_back(type);
+        return it->second;
+    }
+
+    // Resolved once per type, then it's a static read
+    template<typename EventType>
+    EventTypeId event_type_id() {
+        static const EventTypeId id = event_type_id(type_index(typeid(EventType)));
+        return id;
+    }
+
+    inline type_index event_type_index(EventTypeId id) {
+        EventTypeRegistry& registry = EventTypeRegistry::instance();
+        lock_guard<mutex> lock(registry.mtx);
+        if (id >= registry.types.size()) return type_index(typeid(void));
+        return registry.types[id];
+    }
+
+    // Queues that have priority lanes serve Control first and Background last
+    enum class EventPriority { Control, High, Normal, Background };
+
+    const size_t eventPriorityCount = 4;
+
+    template<typename EventType>
+    class EventPool;
+
+    class RingBufferEventQueue;
+    class LockFreeEventQueue;
+    class SharedMemoryEventQueue;
 
     /**
      * Base class for all events in the system
      */
     class Event {
+        template<typename EventType>
+        friend class EventPool;
+        friend class RingBufferEventQueue;
+        friend class LockFreeEventQueue;
+        friend class SharedMemoryEventQueue;
     public:
+        Event() = default;
+
+        // Copies the payload only, a copy starts its own lifetime (no holders, no pool)
+        Event(const Event& other):
+            sourceId(other.sourceId),
+            targetId(other.targetId),
+            timestamp(other.timestamp),
+            priority(other.priority),
+            deadline(other.deadline)
+        {}
+
+        Event& operator=(const Event& other) {
+            if (this == &other) return *this;
+            sourceId = other.sourceId;
+            targetId = other.targetId;
+            timestamp = other.timestamp;
+            priority = other.priority;
+            deadline = other.deadline;
+            return *this;
+        }
+
+        Event(Event&& other) noexcept:
+            sourceId(other.sourceId),
+            targetId(other.targetId),
+            timestamp(other.timestamp),
+            priority(other.priority),
+            deadline(other.deadline)
+        {}
+
+        Event& operator=(Event&& other) noexcept {
+            return *this = (const Event&)other;
+        }
+
         virtual ~Event() = default;
-        
+
         // Source component that created this event
-        ComponentId sourceId = "";
-        
-        // Optional target component (empty string means broadcast)
-        ComponentId targetId = "";
-        
+        ComponentId sourceId;
+
+        // Optional target component (empty id means broadcast)
+        ComponentId targetId;
+
         // Timestamp when the event was created
         chrono::time_point<chrono::system_clock> timestamp;
-        
+
+        // Lane of the event in the queues that support priorities
+        EventPriority priority = EventPriority::Normal;
+
+        // The event is stale after this and gets dropped instead of delivered (default never)
+        chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+
+        void expireAfter(chrono::milliseconds ttl) {
+            deadline = chrono::steady_clock::now() + ttl;
+        }
+
+        bool isExpired(chrono::steady_clock::time_point now = chrono::steady_clock::now()) const {
+            return now >= deadline;
+        }
+
         // Type information for runtime type checking
         virtual type_index getType() const { return type_index(typeid(Event)); }
 
+        // Dense type id for flat table dispatch (TypedEvent resolves it without lookup)
+        virtual EventTypeId getTypeId() const { return event_type_id(getType()); }
+
+        // Type-erased value semantics for storing events by value (without slicing),
+        // see TypedEvent for the overrides
+        virtual size_t getSize() const { return sizeof(Event); }
+        virtual size_t getAlignment() const { return alignof(Event); }
+        virtual Event* copyTo(void* storage) const { return new (storage) Event(*this); }
+        virtual Event* moveTo(void* storage) { return new (storage) Event(move(*this)); }
+        virtual void assignTo(Event& target) const { target = *this; }
+
+        // Intrusive reference counting: anyone who keeps the event
+        // beyond the handler call has to hold it and release it later.
+        // When the last holder releases a pooled event it goes back to its pool.
         void hold() {
-            holders++;
+            holders.fetch_add(1, memory_order_relaxed);
         }
         void release() {
-            holders--;
+            if (holders.fetch_sub(1, memory_order_acq_rel) == 1 && recycler)
+                recycler(this);
         }
-        bool isHolded() {
-            return !!holders;
+        bool isHolded() const {
+            return holders.load(memory_order_acquire) > 0;
         }
     private:
-        size_t holders = 0;
+        atomic<size_t> holders{0};
+        void (*recycler)(Event*) = nullptr; // set by the owner pool or queue
+        void* owner = nullptr; // storage of the event in the owner queue
     };
 
 }
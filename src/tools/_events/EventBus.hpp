@@ -1,15 +1,19 @@
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <shared_mutex>
 
 #include "../utils/system.hpp"
 #include "../utils/Logger.hpp"
 #include "../utils/RingBuffer.hpp"
+#include "../utils/RcuPointer.hpp"
 #include "../utils/SharedPtrFactory.hpp"
 
 #include "Event.hpp"
+#include "EventPool.hpp"
 #include "EventQueue.hpp"
+#include "EventBusMetrics.hpp"
 #include "EventProducer.hpp"
 #include "EventConsumer.hpp"
 #include "RingBufferEventQueue.hpp"
@@ -22,18 +26,91 @@ namespace tools::events
 
     /**
     * Central event bus that manages event distribution
+    *
+    * In Sync mode (default) every event is delivered on the publisher's thread.
+    * In Async mode (after start()) the publisher only delivers to the Inline
+    * consumers, the rest is handed over to the EventQueue: a router thread drains
+    * the queue into per-consumer mailboxes and a pool of dispatcher threads runs
+    * the mailboxes, one dispatcher per consumer at a time, so every consumer
+    * still sees its events in publishing order (within a priority: higher
+    * priority events go ahead in the mailboxes and the expired ones are dropped).
+    *
+    * Delivery reads an immutable snapshot of the subscriptions (RCU style)
+    * that is rebuilt and swapped on every registration change, so publishers
+    * don't take locks and don't allocate. unregisterConsumer() waits until the
+    * deliveries still using the previous snapshot are done (except when it's
+    * called from a handler).
+    *
+    * Delivery latency, handler durations, queue depths and drops are recorded
+    * in getMetrics() (see EventBusMetrics, can be compiled out).
     */
     class EventBus {
     public:
+        enum class DeliveryMode { Sync, Async };
+
+        // How a consumer is invoked in Async mode
+        enum class ConsumerDispatch {
+            Inline,  // on the publisher's thread (cheap handlers)
+            Pooled   // on a dispatcher thread (slow handlers eg. TTS, network)
+        };
+
         EventBus(
             Logger &logger,
-            EventQueue &eventQueue
+            EventQueue &eventQueue,
+            DeliveryMode mode = DeliveryMode::Sync,
+            size_t dispatchers = 1
         ):
             m_logger(logger),
+            m_dispatchers(dispatchers),
             m_eventQueue(eventQueue)
-        {}
+        {
+            if constexpr (EventBusMetrics::enabled) {
+                m_dropCallbackId = m_eventQueue.addDropCallback([this](size_t count, EventQueue::DropReason reason) {
+                    m_metrics.recordDrop(count, reason);
+                });
+            }
+            if (mode == DeliveryMode::Async) start();
+        }
+
+        virtual ~EventBus() {
+            stop();
+            if constexpr (EventBusMetrics::enabled) m_eventQueue.removeDropCallback(m_dropCallbackId);
+        }
 
-        ~EventBus() {}
+        // Starts the router and the dispatcher threads (Async mode)
+        void start(size_t dispatchers = 0) {
+            lock_guard<mutex> lock(m_lifecycleMutex);
+            if (m_running) return;
+            if (dispatchers) m_dispatchers = dispatchers;
+            if (m_dispatchers < 1) throw ERROR("At least one dispatcher thread is needed");
+            m_dispatching = true;
+            m_routing = true;
+            m_running = true;
+            for (size_t i = 0; i < m_dispatchers; i++)
+                m_dispatcherThreads.emplace_back([this]() { dispatch(); });
+            m_processingThread = thread([this]() { route(); });
+        }
+
+        // Delivers everything already published then joins the threads
+        void stop() {
+            lock_guard<mutex> lock(m_lifecycleMutex);
+            if (!m_running) return;
+            m_running = false;
+            m_routing = false; // publishers deliver on their own thread from here
+            if (m_processingThread.joinable()) m_processingThread.join();
+            {
+                lock_guard<mutex> lock(m_queueMutex);
+                m_dispatching = false;
+            }
+            m_queueCondition.notify_all();
+            for (thread& dispatcher: m_dispatcherThreads)
+                if (dispatcher.joinable()) dispatcher.join();
+            m_dispatcherThreads.clear();
+        }
+
+        DeliveryMode getDeliveryMode() const {
+            return m_running ? DeliveryMode::Async : DeliveryMode::Sync;
+        }
 
         // Register a producer with the event bus
         void registerProducer(EventProducer& producer) {
@@ -48,72 +125,278 @@ namespace tools::events
         }
 
         // Register a consumer with the event bus
-        void registerConsumer(EventConsumer& consumer) {
-            unique_lock<shared_mutex> lock(m_mutex);
-            m_consumers[consumer.getId()] = &consumer;
+        void registerConsumer(EventConsumer& consumer, ConsumerDispatch dispatch = ConsumerDispatch::Pooled) {
+            {
+                unique_lock<shared_mutex> lock(m_mutex);
+                m_consumers[consumer.getId()] = &consumer;
+                m_dispatches[consumer.getId()] = dispatch;
+                if (!m_mailboxes.count(consumer.getId()))
+                    m_mailboxes[consumer.getId()] = make_shared<ConsumerMailbox>(consumer.getId());
+                publishSubscriptions();
+            }
+            m_subscriptions.synchronize();
         }
 
-        // Unregister a consumer from the event bus
+        // Unregister a consumer from the event bus, returns when no delivery uses it anymore
         void unregisterConsumer(const ComponentId &consumerId) {
-            unique_lock<shared_mutex> lock(m_mutex);
-            m_consumers.erase(consumerId);
+            {
+                unique_lock<shared_mutex> lock(m_mutex);
+                m_consumers.erase(consumerId);
+                m_dispatches.erase(consumerId);
+                m_mailboxes.erase(consumerId); // pending events are released by the dispatcher
+                publishSubscriptions();
+            }
+            m_subscriptions.synchronize(); // doesn't wait when called from a handler
+        }
+
+        // Choose between Inline and Pooled invocation of a consumer (Async mode)
+        void setConsumerDispatch(const ComponentId &consumerId, ConsumerDispatch dispatch) {
+            {
+                unique_lock<shared_mutex> lock(m_mutex);
+                if (!m_consumers.count(consumerId)) throw ERROR("Consumer is not registered: " + consumerId);
+                m_dispatches[consumerId] = dispatch;
+                publishSubscriptions();
+            }
+            m_subscriptions.synchronize();
         }
 
         // Register a specific event type that a consumer is interested in
+        void registerEventInterest(const ComponentId &consumerId, EventTypeId eventTypeId) {
+            {
+                unique_lock<shared_mutex> lock(m_mutex);
+                m_eventInterests[eventTypeId].push_back(consumerId);
+                publishSubscriptions();
+            }
+            m_subscriptions.synchronize();
+        }
+
         void registerEventInterest(const ComponentId &consumerId, type_index eventType) {
-            unique_lock<shared_mutex> lock(m_mutex);
-            m_eventInterests[eventType].push_back(consumerId);
+            registerEventInterest(consumerId, event_type_id(eventType));
+        }
+
+        template<typename EventType>
+        void registerEventInterest(const ComponentId &consumerId) {
+            registerEventInterest(consumerId, event_type_id<EventType>());
         }
 
         // Publish an event to the event bus
         template <typename EventType, typename... Args>
         void createAndPublishEvent(const ComponentId &sourceId, const ComponentId &targetId, Args &&...args) {
-            EventType* event = new EventType(forward<Args>(args)...);
+            EventType* event = EventPool<EventType>::instance().acquire(forward<Args>(args)...);
             event->sourceId = sourceId;
             event->targetId = targetId;
             event->timestamp = chrono::system_clock::now();
-            deliverEventInternal(this, *event); // Call the new virtual function
-            thread([&]() {
-                while (event->isHolded()) sleep_ms(1); 
-                delete event;  
-            }).detach();
+            event->hold(); // the publisher holds the event while delivering it
+            m_metrics.recordPublish(*event);
+            try {
+                if (!m_routing || !publishAsync(*event)) deliverEventInternal(*event);
+            } catch (...) {
+                event->release();
+                throw;
+            }
+            event->release(); // goes back to the pool unless a consumer still holds it
+        }
+
+        // Publishes the events in order and releases the caller's hold of each (see Batch).
+        // Async mode delivers the Inline consumers on one subscriptions snapshot
+        // and hands the events over to the queue in one go.
+        void publishBatch(const vector<Event*>& events) {
+            try {
+                for (Event* event: events) m_metrics.recordPublish(*event);
+                if (!m_routing || !publishBatchAsync(events))
+                    for (Event* event: events) deliverEventInternal(*event);
+            } catch (...) {
+                for (Event* event: events) event->release();
+                throw;
+            }
+            for (Event* event: events) event->release();
+        }
+
+        /**
+         * Scoped batch builder: collects pooled events and publishes them with
+         * publishBatch() when publish() is called or when it goes out of scope.
+         * Not thread safe, one batch belongs to one producer thread.
+         */
+        class Batch {
+        public:
+            Batch(EventBus& bus, const ComponentId& sourceId, size_t reserve = 0): bus(&bus), sourceId(sourceId) {
+                events.reserve(reserve);
+            }
+
+            Batch(const Batch&) = delete;
+            Batch& operator=(const Batch&) = delete;
+
+            Batch(Batch&& other): bus(other.bus), sourceId(other.sourceId), events(move(other.events)) {
+                other.events.clear();
+            }
+
+            ~Batch() {
+                try {
+                    publish();
+                } catch (exception& e) {
+                    bus->m_logger.error("Batch publish failed: " + string(e.what()));
+                }
+            }
+
+            // Creates the next event of the batch, returned to set it up further (eg. priority)
+            template<typename EventType, typename... Args>
+            EventType& add(const ComponentId& targetId, Args&&... args) {
+                EventType* event = EventPool<EventType>::instance().acquire(forward<Args>(args)...);
+                event->sourceId = sourceId;
+                event->targetId = targetId;
+                event->timestamp = chrono::system_clock::now();
+                event->hold(); // released by publishBatch()
+                events.push_back(event);
+                return *event;
+            }
+
+            size_t size() const {
+                return events.size();
+            }
+
+            void publish() {
+                if (events.empty()) return;
+                try {
+                    bus->publishBatch(events);
+                } catch (...) {
+                    events.clear(); // released by publishBatch() anyway
+                    throw;
+                }
+                events.clear();
+            }
+
+        private:
+            EventBus* bus;
+            ComponentId sourceId;
+            vector<Event*> events;
+        };
+
+        Batch createBatch(const ComponentId& sourceId, size_t reserve = 0) {
+            return Batch(*this, sourceId, reserve);
         }
 
         EventQueue &getEventQueueRef() {
             return m_eventQueue;
         }
 
+        EventBusMetrics &getMetrics() {
+            return m_metrics;
+        }
+
     protected:
 
+        // Pending events of a pooled consumer, run by one dispatcher at a time
+        struct ConsumerMailbox {
+            ConsumerMailbox(const ComponentId& consumerId): consumerId(consumerId) {}
+            ComponentId consumerId;
+            mutex mtx;
+            deque<Event*> events;
+            bool scheduled = false;
+        };
+
+        struct Subscriber {
+            ComponentId id;
+            EventConsumer* consumer = nullptr;
+            ConsumerDispatch dispatch = ConsumerDispatch::Pooled;
+            shared_ptr<ConsumerMailbox> mailbox;
+        };
+
+        // Immutable view of the registrations, replaced on every change.
+        // Flat tables: consumers by ComponentId index, interests by EventTypeId.
+        struct Subscriptions {
+            Subscriptions() = default;
+            Subscriptions(const Subscriptions&) = delete; // interests point into consumers
+
+            const Subscriber* findConsumer(const ComponentId& consumerId) const {
+                size_t index = consumerId.getIndex();
+                if (index >= consumers.size() || !consumers[index].consumer) return nullptr;
+                return &consumers[index];
+            }
+
+            vector<Subscriber> consumers;
+            vector<vector<const Subscriber*>> interests;
+        };
+
         // Deliver an event to appropriate consumers
-        function<void(EventBus*, Event&)> deliverEventInternal = [](EventBus* that, Event& event) {
-            shared_lock<shared_mutex> lock(that->m_mutex);
+        virtual void deliverEventInternal(Event& event) {
+            forEachRecipient(event, [this, &event](const ComponentId&, const Subscriber& subscriber) {
+                deliverTo(subscriber, event);
+            });
+        }
+
+        // Calls the consumer (and measures it)
+        void deliverTo(const Subscriber& subscriber, Event& event) {
+            m_metrics.measureDelivery(subscriber.id, event, [&subscriber, &event]() {
+                subscriber.consumer->handleEvent(event);
+            });
+        }
+
+        // Filters the recipients of an event, see FilteredEventBus
+        virtual bool shouldDeliverEvent(const ComponentId& /*consumerId*/, Event& /*event*/) {
+            return true;
+        }
+
+        // Visits the consumers the event has to be delivered to (lock-free, on the current snapshot)
+        template<typename Visitor>
+        void forEachRecipient(Event& event, Visitor visit) {
+            RcuPointer<Subscriptions>::Reader subscriptions = m_subscriptions.read();
+            forEachRecipient(*subscriptions, event, visit);
+        }
+
+        template<typename Visitor>
+        void forEachRecipient(const Subscriptions& subscriptions, Event& event, Visitor visit) {
+            EventTypeId eventTypeId = event.getTypeId();
+
             if (!event.targetId.empty()) {
-                auto it = that->m_consumers.find(event.targetId);
-                if (it != that->m_consumers.end()) {
-                    if (it->second->canHandle(event.getType())) {
-                        it->second->handleEvent(event);
-                    }
+                const Subscriber* subscriber = subscriptions.findConsumer(event.targetId);
+                if (subscriber && subscriber->consumer->canHandleType(eventTypeId) && shouldDeliverEvent(subscriber->id, event)) {
+                    visit(subscriber->id, *subscriber);
                 }
                 return;
             }
 
-            auto typeIt = that->m_eventInterests.find(event.getType());
-            if (typeIt != that->m_eventInterests.end()) {
-                for (const ComponentId& consumerId : typeIt->second) {
-                    auto consumerIt = that->m_consumers.find(consumerId);
-                    if (consumerIt != that->m_consumers.end()) {
-                        consumerIt->second->handleEvent(event);
-                    }
+            if (eventTypeId >= subscriptions.interests.size()) return;
+            for (const Subscriber* subscriber: subscriptions.interests[eventTypeId]) {
+                if (shouldDeliverEvent(subscriber->id, event)) {
+                    visit(subscriber->id, *subscriber);
                 }
             }
-        };
+        }
+
+        // Rebuilds and swaps the subscriptions snapshot (caller holds m_mutex),
+        // the previous one is freed by the next synchronize()
+        void publishSubscriptions() {
+            unique_ptr<Subscriptions> subscriptions = make_unique<Subscriptions>();
+            size_t consumerCount = 0;
+            for (const auto& [consumerId, consumer]: m_consumers)
+                consumerCount = max(consumerCount, consumerId.getIndex() + 1);
+            subscriptions->consumers.resize(consumerCount);
+            for (const auto& [consumerId, consumer]: m_consumers) {
+                auto dispatchIt = m_dispatches.find(consumerId);
+                auto mailboxIt = m_mailboxes.find(consumerId);
+                subscriptions->consumers[consumerId.getIndex()] = Subscriber{
+                    consumerId,
+                    consumer,
+                    dispatchIt == m_dispatches.end() ? ConsumerDispatch::Pooled : dispatchIt->second,
+                    mailboxIt == m_mailboxes.end() ? nullptr : mailboxIt->second
+                };
+            }
+            for (const auto& [eventTypeId, consumerIds]: m_eventInterests) {
+                if (subscriptions->interests.size() <= eventTypeId) subscriptions->interests.resize(eventTypeId + 1);
+                vector<const Subscriber*>& subscribers = subscriptions->interests[eventTypeId];
+                for (const ComponentId& consumerId: consumerIds) {
+                    const Subscriber* subscriber = subscriptions->findConsumer(consumerId);
+                    if (subscriber) subscribers.push_back(subscriber);
+                }
+            }
+            m_subscriptions.replace(move(subscriptions));
+        }
 
     public:
         // Synchronization
         shared_mutex m_mutex;
         // Map of event types to interested consumers
-        unordered_map<type_index, vector<ComponentId>> m_eventInterests;
+        unordered_map<EventTypeId, vector<ComponentId>> m_eventInterests;
         // Collections of producers and consumers
         unordered_map<ComponentId, EventProducer*> m_producers;
         unordered_map<ComponentId, EventConsumer*> m_consumers;
@@ -125,9 +408,156 @@ namespace tools::events
         condition_variable m_queueCondition;
 
     private:
+
+        // Max events a dispatcher takes from one mailbox before it gives turn to the others
+        static const size_t dispatchBatch = 64;
+        // Router wake up interval to notice stop()
+        static const int routeTimeoutMs = 10;
+
+        // Counts the publishers between their m_routing check and their push,
+        // the router doesn't exit while any of them may still push (see route())
+        struct Publishing {
+            atomic<size_t>& count;
+            Publishing(atomic<size_t>& count): count(count) { count++; }
+            ~Publishing() { count--; }
+        };
+
+        // Returns false if the router is stopped (nothing delivered)
+        bool publishAsync(Event& event) {
+            {
+                Publishing publishing(m_publishing);
+                if (!m_routing) return false;
+                event.hold(); // the queue keeps it until the router is done
+                if (!m_eventQueue.push(&event)) {
+                    event.release();
+                    m_logger.warn("Event queue rejected an event from " + event.sourceId);
+                }
+                if constexpr (EventBusMetrics::enabled) m_metrics.recordQueueDepth(m_eventQueue.available());
+            }
+            forEachRecipient(event, [this, &event](const ComponentId&, const Subscriber& subscriber) {
+                if (subscriber.dispatch == ConsumerDispatch::Inline) deliverTo(subscriber, event);
+            });
+            return true;
+        }
+
+        bool publishBatchAsync(const vector<Event*>& events) {
+            {
+                Publishing publishing(m_publishing);
+                if (!m_routing) return false;
+                for (Event* event: events) event->hold(); // the queue keeps them until the router is done
+                size_t pushed = m_eventQueue.pushBatch(events.data(), events.size());
+                if (pushed < events.size())
+                    m_logger.warn("Event queue rejected " + to_string(events.size() - pushed) + " event(s) of a batch");
+                if constexpr (EventBusMetrics::enabled) m_metrics.recordQueueDepth(m_eventQueue.available());
+            }
+            RcuPointer<Subscriptions>::Reader subscriptions = m_subscriptions.read();
+            for (Event* event: events) {
+                forEachRecipient(*subscriptions, *event, [this, event](const ComponentId&, const Subscriber& subscriber) {
+                    if (subscriber.dispatch == ConsumerDispatch::Inline) deliverTo(subscriber, *event);
+                });
+            }
+            return true;
+        }
+
+        // Router thread: drains the event queue into the consumer mailboxes
+        void route() {
+            while (m_routing || m_publishing.load() || m_eventQueue.available()) {
+                Event* event = nullptr;
+                if (!m_eventQueue.pop(event, true, routeTimeoutMs)) continue;
+                // the publisher may sample the depth after the pop
+                if constexpr (EventBusMetrics::enabled) m_metrics.recordQueueDepth(m_eventQueue.available() + 1);
+                vector<shared_ptr<ConsumerMailbox>> ready;
+                forEachRecipient(*event, [&](const ComponentId&, const Subscriber& subscriber) {
+                    if (subscriber.dispatch != ConsumerDispatch::Pooled || !subscriber.mailbox) return;
+                    ConsumerMailbox& mailbox = *subscriber.mailbox;
+                    lock_guard<mutex> lock(mailbox.mtx);
+                    event->hold();
+                    // ahead of the lower priority events, behind the same priority ones
+                    auto pos = mailbox.events.end();
+                    while (pos != mailbox.events.begin() && (*prev(pos))->priority > event->priority) pos--;
+                    mailbox.events.insert(pos, event);
+                    m_metrics.recordMailboxDepth(mailbox.consumerId, mailbox.events.size());
+                    if (!mailbox.scheduled) {
+                        mailbox.scheduled = true;
+                        ready.push_back(subscriber.mailbox);
+                    }
+                });
+                event->release();
+                if (ready.empty()) continue;
+                {
+                    lock_guard<mutex> lock(m_queueMutex);
+                    for (const shared_ptr<ConsumerMailbox>& mailbox: ready) m_readyMailboxes.push_back(mailbox);
+                }
+                if (ready.size() > 1) m_queueCondition.notify_all();
+                else m_queueCondition.notify_one();
+            }
+        }
+
+        // Dispatcher thread: runs the scheduled mailboxes
+        void dispatch() {
+            while (true) {
+                shared_ptr<ConsumerMailbox> mailbox;
+                {
+                    unique_lock<mutex> lock(m_queueMutex);
+                    m_queueCondition.wait(lock, [this]() { return !m_readyMailboxes.empty() || !m_dispatching; });
+                    if (m_readyMailboxes.empty()) return;
+                    mailbox = m_readyMailboxes.front();
+                    m_readyMailboxes.pop_front();
+                }
+                if (runMailbox(*mailbox)) {
+                    lock_guard<mutex> lock(m_queueMutex);
+                    m_readyMailboxes.push_back(mailbox);
+                    m_queueCondition.notify_one();
+                }
+            }
+        }
+
+        // Returns true if the mailbox still has events and needs another turn
+        bool runMailbox(ConsumerMailbox& mailbox) {
+            for (size_t i = 0; i < dispatchBatch; i++) {
+                Event* event = nullptr;
+                {
+                    lock_guard<mutex> lock(mailbox.mtx);
+                    if (mailbox.events.empty()) {
+                        mailbox.scheduled = false;
+                        return false;
+                    }
+                    event = mailbox.events.front();
+                    mailbox.events.pop_front();
+                }
+                if (event->isExpired()) {
+                    event->release(); // stale by now, dropped instead of delivered
+                    continue;
+                }
+                try {
+                    RcuPointer<Subscriptions>::Reader subscriptions = m_subscriptions.read();
+                    const Subscriber* subscriber = subscriptions->findConsumer(mailbox.consumerId);
+                    if (subscriber) deliverTo(*subscriber, *event);
+                } catch (exception& e) {
+                    m_logger.error("Consumer '" + mailbox.consumerId + "' failed to handle event: " + e.what());
+                }
+                event->release();
+            }
+            return true;
+        }
+
+        size_t m_dispatchers;
+        unordered_map<ComponentId, ConsumerDispatch> m_dispatches;
+        unordered_map<ComponentId, shared_ptr<ConsumerMailbox>> m_mailboxes;
+        deque<shared_ptr<ConsumerMailbox>> m_readyMailboxes;
+        bool m_dispatching = false;
+        vector<thread> m_dispatcherThreads;
+        mutex m_lifecycleMutex;
+
+        RcuPointer<Subscriptions> m_subscriptions;
+
+        EventBusMetrics m_metrics;
+        size_t m_dropCallbackId = 0;
+
         // Async delivery
-        // bool m_asyncDelivery;
-        bool m_running = false;
+        atomic<bool> m_running = false;
+        atomic<bool> m_routing = false;
+        atomic<size_t> m_publishing = 0;
         thread m_processingThread;
         EventQueue &m_eventQueue; // Use abstracted EventQueue
         SharedPtrFactory eventFactory; // Factory for events
@@ -137,6 +567,8 @@ namespace tools::events
 
 #ifdef TEST
 
+#include <map>
+
 #include "../utils/Test.hpp"
 #include "../utils/tests/MockLogger.hpp"
 #include "tests/TestEvent.hpp"
@@ -279,9 +711,10 @@ void test_EventBus_register_and_publish_concurrent() {
     vector<MockConsumer> consumers;
     vector<thread> registrars;
 
+    consumers.reserve(numConsumers); // registrar threads keep references into the vector
     for (int i = 0; i < numConsumers; ++i) {
-        MockConsumer consumer("consumer" + to_string(i));
-        consumers.push_back(consumer);
+        consumers.emplace_back("consumer" + to_string(i));
+        MockConsumer& consumer = consumers.back();
         registrars.emplace_back([&consumer, &bus]() {
             consumer.registerWithEventBus(&bus);
         });
@@ -329,6 +762,272 @@ void test_EventBus_destructor_sync_cleanup() {
     assert(destructedWithoutHang == true && "Destructor should cleanly stop async thread");
 }
 
+// Test asynchronous delivery through the dispatcher pool
+void test_EventBus_async_delivery_pooled() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue, EventBus::DeliveryMode::Async, 2);
+    MockConsumer consumer("consumer1");
+    consumer.registerWithEventBus(&bus);
+    assert(bus.getDeliveryMode() == EventBus::DeliveryMode::Async && "Bus should be in async mode");
+    for (int i = 0; i < 100; i++)
+        bus.createAndPublishEvent<TestEvent>("test-source", "consumer1", i);
+    bus.stop(); // delivers the pending events
+    assert(consumer.receivedEvents.size() == 100 && "Consumer should receive all events after stop");
+    assert(bus.getDeliveryMode() == EventBus::DeliveryMode::Sync && "Bus should fall back to sync mode after stop");
+}
+
+// Test that every consumer sees its events in publishing order
+void test_EventBus_async_per_consumer_ordering() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue, EventBus::DeliveryMode::Async, 4);
+    vector<MockConsumer> consumers;
+    consumers.reserve(3);
+    for (int i = 0; i < 3; i++) {
+        consumers.emplace_back("consumer" + to_string(i));
+        consumers.back().registerWithEventBus(&bus);
+    }
+    const int numEvents = 300;
+    for (int i = 0; i < numEvents; i++) {
+        bus.createAndPublishEvent<TestEvent>("test-source", "", i); // Broadcast
+        if (eventQueue.available() > 900) this_thread::yield(); // don't rotate events out
+    }
+    bus.stop();
+    for (const MockConsumer& consumer: consumers) {
+        assert(consumer.receivedEvents.size() == numEvents && "Each consumer should receive every event");
+        for (int i = 0; i < numEvents; i++)
+            assert(((TestEvent*)consumer.receivedEvents[i])->value == i && "Events should arrive in publishing order");
+    }
+}
+
+// Test inline consumers are called on the publisher's thread
+void test_EventBus_async_inline_consumer() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue, EventBus::DeliveryMode::Async);
+    MockConsumer inlineConsumer("inline");
+    MockConsumer pooledConsumer("pooled");
+    inlineConsumer.registerWithEventBus(&bus);
+    pooledConsumer.registerWithEventBus(&bus);
+    bus.setConsumerDispatch("inline", EventBus::ConsumerDispatch::Inline);
+    bus.createAndPublishEvent<TestEvent>("test-source", "", 42);
+    assert(inlineConsumer.receivedEvents.size() == 1 && "Inline consumer should receive the event before publish returns");
+    bus.stop();
+    assert(pooledConsumer.receivedEvents.size() == 1 && "Pooled consumer should receive the event too");
+    assert(inlineConsumer.receivedEvents.size() == 1 && "Inline consumer should receive the event only once");
+}
+
+// Test dispatch mode can not be set for an unknown consumer
+void test_EventBus_setConsumerDispatch_unknown_consumer() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue);
+    bool thrown = false;
+    try {
+        bus.setConsumerDispatch("nobody", EventBus::ConsumerDispatch::Inline);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Setting dispatch of an unregistered consumer should throw");
+}
+
+// Test events of an unregistered consumer are released, not delivered
+void test_EventBus_async_unregister_pending() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue);
+    MockConsumer consumer("consumer1");
+    consumer.registerWithEventBus(&bus);
+    bus.start();
+    bus.unregisterConsumer("consumer1");
+    bus.createAndPublishEvent<TestEvent>("test-source", "consumer1", 42);
+    bus.stop();
+    assert(consumer.receivedEvents.empty() && "Unregistered consumer should not receive events");
+    assert(eventQueue.available() == 0 && "Queue should be drained after stop");
+}
+
+// Counts the deliveries, from any thread
+class CountingConsumer: public MockConsumer {
+public:
+    using MockConsumer::MockConsumer;
+    atomic<size_t> count = 0;
+    void handleEvent(Event&) override { count++; }
+};
+
+// Test events published while stop() runs are still delivered
+void test_EventBus_async_publish_during_stop() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(100000, logger);
+    EventBus bus(logger, eventQueue, EventBus::DeliveryMode::Async, 2);
+    CountingConsumer consumer("consumer1");
+    consumer.registerWithEventBus(&bus);
+    atomic<size_t> published = 0;
+    atomic<bool> publishing = true;
+    vector<thread> publishers;
+    for (int i = 0; i < 4; i++)
+        publishers.emplace_back([&]() {
+            while (publishing) {
+                bus.createAndPublishEvent<TestEvent>("test-source", "consumer1", 1);
+                published++;
+            }
+        });
+    while (published < 1000) this_thread::yield();
+    bus.stop();
+    publishing = false;
+    for (thread& publisher: publishers) publisher.join();
+    assert(consumer.count == published && "Events published during stop() should be delivered");
+    assert(eventQueue.available() == 0 && "Queue should be drained after stop");
+}
+
+// Stops the bus from its handler
+class StoppingConsumer: public MockConsumer {
+public:
+    StoppingConsumer(const ComponentId& id, EventBus& bus): MockConsumer(id), bus(bus) {}
+    atomic<bool> stopped = false;
+    void handleEvent(Event&) override {
+        bus.stop();
+        stopped = true;
+    }
+private:
+    EventBus& bus;
+};
+
+// Test an inline consumer can stop the bus from its handler
+void test_EventBus_async_inline_consumer_stops_bus() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue, EventBus::DeliveryMode::Async);
+    StoppingConsumer consumer("stopper", bus);
+    consumer.registerWithEventBus(&bus);
+    bus.setConsumerDispatch("stopper", EventBus::ConsumerDispatch::Inline);
+    bus.createAndPublishEvent<TestEvent>("test-source", "stopper", 1);
+    assert(consumer.stopped && "Handler should return from stop()");
+    assert(bus.getDeliveryMode() == EventBus::DeliveryMode::Sync && "Bus should be stopped");
+}
+
+// Test clean shutdown of the async threads in the destructor
+void test_EventBus_destructor_async_cleanup() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    MockConsumer consumer("consumer1");
+    {
+        EventBus bus(logger, eventQueue, EventBus::DeliveryMode::Async, 3);
+        consumer.registerWithEventBus(&bus);
+        for (int i = 0; i < 10; i++)
+            bus.createAndPublishEvent<TestEvent>("test-source", "consumer1", i);
+    }  // Destructor called here
+    assert(consumer.receivedEvents.size() == 10 && "Destructor should deliver pending events before joining");
+}
+
+// Test delivery latency and handler duration are recorded per type and per consumer
+void test_EventBus_metrics_delivery() {
+    if constexpr (!EventBusMetrics::enabled) return;
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue);
+    MockConsumer consumer("metrics-consumer");
+    consumer.registerWithEventBus(&bus);
+    for (int i = 0; i < 5; i++) bus.createAndPublishEvent<TestEvent>("test-source", "", i);
+
+    EventBusMetrics::Snapshot snapshot = bus.getMetrics().snapshot();
+    EventBusMetrics::StatsSnapshot& type = snapshot.types[event_type_id<TestEvent>()];
+    assert(type.published == 5 && "Published events should be counted per type");
+    assert(type.latency.count == 5 && type.handling.count == 5 && "Deliveries should be recorded per type");
+    EventBusMetrics::StatsSnapshot& consumerStats = snapshot.consumers["metrics-consumer"];
+    assert(consumerStats.handling.count == 5 && "Deliveries should be recorded per consumer");
+    assert(consumerStats.failed == 0 && "No handler should have failed");
+}
+
+// Test the queue drops and depths show up in the metrics (Async mode)
+void test_EventBus_metrics_queue_drops_and_depth() {
+    if constexpr (!EventBusMetrics::enabled) return;
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(2, logger);
+    EventBus bus(logger, eventQueue);
+    MockConsumer consumer("metrics-consumer");
+    consumer.registerWithEventBus(&bus);
+    size_t dropped = 0;
+    eventQueue.setDropCallback([&dropped](size_t count) { dropped += count; });
+    eventQueue.setDropCallback([&dropped](size_t count) { dropped += count; }); // replaces the first one only
+    for (int i = 0; i < 5; i++) eventQueue.emplace<TestEvent>(i); // rotates 3 out
+    bus.start();
+    bus.createAndPublishEvent<TestEvent>("test-source", "metrics-consumer", 42);
+    bus.stop();
+
+    EventBusMetrics::Snapshot snapshot = bus.getMetrics().snapshot();
+    assert(snapshot.drops[(size_t)EventQueue::DropReason::Overflow] >= 3 && "Queue drops should be counted"); // the publish may rotate one more
+    assert(dropped == snapshot.drops[(size_t)EventQueue::DropReason::Overflow] && "setDropCallback() should keep the bus callback and replace its own");
+    assert(snapshot.queueHighWater >= 1 && "Queue depth should be recorded");
+    assert(snapshot.consumers["metrics-consumer"].highWater >= 1 && "Mailbox depth should be recorded");
+}
+
+// Test a batch is delivered in order when published (Sync mode)
+void test_EventBus_batch_sync_delivery() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue);
+    MockConsumer consumer("consumer1");
+    consumer.registerWithEventBus(&bus);
+    EventBus::Batch batch = bus.createBatch("test-source");
+    for (int i = 0; i < 3; i++) batch.add<TestEvent>("", i);
+    assert(batch.size() == 3 && "Batch should collect the events");
+    assert(consumer.receivedEvents.empty() && "Nothing should be delivered before publish");
+    batch.publish();
+    assert(batch.size() == 0 && "Batch should be empty after publish");
+    assert(consumer.receivedEvents.size() == 3 && "Every event of the batch should be delivered");
+    for (int i = 0; i < 3; i++) {
+        TestEvent* event = (TestEvent*)consumer.receivedEvents[i];
+        assert(event->value == i && "Batch should be delivered in order");
+        assert(event->sourceId == "test-source" && "Batch events should have the batch source");
+    }
+}
+
+// Test a scoped batch publishes when it goes out of scope
+void test_EventBus_batch_scoped_publish() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue);
+    MockConsumer consumer("consumer1");
+    consumer.registerWithEventBus(&bus);
+    {
+        EventBus::Batch batch(bus, "test-source");
+        batch.add<TestEvent>("consumer1", 7);
+    }
+    assert(consumer.receivedEvents.size() == 1 && "Batch should be published at the end of its scope");
+}
+
+// Test batches keep the per-source order in Async mode
+void test_EventBus_batch_async_per_source_ordering() {
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    EventBus bus(logger, eventQueue, EventBus::DeliveryMode::Async, 2);
+    MockConsumer consumer("consumer1");
+    consumer.registerWithEventBus(&bus);
+    const int numBatches = 20;
+    const int batchSize = 16;
+    vector<thread> producers;
+    for (int p = 0; p < 2; p++) {
+        producers.emplace_back([&bus, p]() {
+            EventBus::Batch batch = bus.createBatch("source" + to_string(p), batchSize);
+            for (int b = 0; b < numBatches; b++) {
+                for (int i = 0; i < batchSize; i++) batch.add<TestEvent>("", b * batchSize + i);
+                batch.publish();
+            }
+        });
+    }
+    for (thread& producer: producers) producer.join();
+    bus.stop();
+    assert(consumer.receivedEvents.size() == 2 * numBatches * batchSize && "Every batched event should be delivered");
+    map<string, int> last;
+    for (Event* event: consumer.receivedEvents) {
+        int value = ((TestEvent*)event)->value;
+        auto it = last.find(event->sourceId);
+        assert((it == last.end() || it->second < value) && "Events of a source should arrive in order");
+        last[event->sourceId] = value;
+    }
+}
+
 // Register tests
 TEST(test_EventBus_publishEvent_sync_delivery);
 TEST(test_EventBus_publishEvent_sync_no_consumers);
@@ -339,5 +1038,18 @@ TEST(test_EventBus_registerEventInterest_basic);
 TEST(test_EventBus_publishEvent_concurrent_sync);
 TEST(test_EventBus_register_and_publish_concurrent);
 TEST(test_EventBus_destructor_sync_cleanup);
+TEST(test_EventBus_async_delivery_pooled);
+TEST(test_EventBus_async_per_consumer_ordering);
+TEST(test_EventBus_async_inline_consumer);
+TEST(test_EventBus_setConsumerDispatch_unknown_consumer);
+TEST(test_EventBus_async_unregister_pending);
+TEST(test_EventBus_async_publish_during_stop);
+TEST(test_EventBus_async_inline_consumer_stops_bus);
+TEST(test_EventBus_destructor_async_cleanup);
+TEST(test_EventBus_metrics_delivery);
+TEST(test_EventBus_metrics_queue_drops_and_depth);
+TEST(test_EventBus_batch_sync_delivery);
+TEST(test_EventBus_batch_scoped_publish);
+TEST(test_EventBus_batch_async_per_source_ordering);
 
 #endif
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+
+#include "../utils/Histogram.hpp"
+
+#include "Event.hpp"
+#include "EventQueue.hpp"
+
+// Build with -DEVENT_METRICS=0 to compile the EventBus instrumentation out
+#ifndef EVENT_METRICS
+#define EVENT_METRICS 1
+#endif
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::events {
+
+    /**
+     * Delivery metrics of an EventBus, per event type and per consumer:
+     * publish to deliver latency and handler duration histograms (in ns),
+     * publish and failure counts, mailbox and event queue depth high-water
+     * marks and the drops reported by the queue.
+     *
+     * Recording is lock-free, one delivery updates the histograms of its
+     * consumer and type pair only (allocated at the first such delivery).
+     * With EVENT_METRICS=0 recording is a no-op.
+     */
+    class EventBusMetrics {
+    public:
+        static constexpr bool enabled = EVENT_METRICS;
+
+        struct StatsSnapshot {
+            Histogram::Snapshot latency;  // publish to handler call
+            Histogram::Snapshot handling; // handler call duration
+            uint64_t published = 0; // (types)
+            uint64_t failed = 0;
+            size_t highWater = 0; // mailbox depth (consumers)
+        };
+
+        struct Snapshot {
+            unordered_map<EventTypeId, StatsSnapshot> types; // see event_type_index()
+            unordered_map<ComponentId, StatsSnapshot> consumers;
+            size_t queueHighWater = 0;
+            uint64_t drops[EventQueue::dropReasonCount] = {};
+        };
+
+        void recordPublish(const Event& event) {
+            if constexpr (!enabled) return;
+            TypeStats* stats = types.get(event.getTypeId());
+            if (stats) stats->published.fetch_add(1, memory_order_relaxed);
+        }
+
+        // Calls the handler and records its latency and duration
+        template<typename Handler>
+        void measureDelivery(const ComponentId& consumerId, Event& event, Handler handler) {
+            if constexpr (!enabled) {
+                handler();
+            } else {
+                chrono::system_clock::time_point start = chrono::system_clock::now();
+                try {
+                    handler();
+                } catch (...) {
+                    recordDelivery(consumerId, event, start, true);
+                    throw;
+                }
+                recordDelivery(consumerId, event, start, false);
+            }
+        }
+
+        void recordMailboxDepth(const ComponentId& consumerId, size_t depth) {
+            if constexpr (!enabled) return;
+            ConsumerStats* stats = consumers.get(consumerId.getIndex());
+            if (stats) raise(stats->highWater, depth);
+        }
+
+        void recordQueueDepth(size_t depth) {
+            if constexpr (!enabled) return;
+            raise(queueHighWater, depth);
+        }
+
+        void recordDrop(size_t count, EventQueue::DropReason reason) {
+            if constexpr (!enabled) return;
+            drops[(size_t)reason].fetch_add(count, memory_order_relaxed);
+        }
+
+        // Not atomic as a whole, records running meanwhile may be partly in it
+        Snapshot snapshot() const {
+            Snapshot snapshot;
+            types.forEach([&snapshot](size_t typeId, const TypeStats& stats) {
+                snapshot.types[typeId].published = stats.published.load(memory_order_relaxed);
+            });
+            consumers.forEach([&snapshot](size_t index, const ConsumerStats& consumerStats) {
+                StatsSnapshot& consumer = snapshot.consumers[ComponentId::fromIndex(index)];
+                consumer.highWater = consumerStats.highWater.load(memory_order_relaxed);
+                consumerStats.types.forEach([&](size_t typeId, const DeliveryStats& stats) {
+                    Histogram::Snapshot latency = stats.latency.snapshot();
+                    Histogram::Snapshot handling = stats.handling.snapshot();
+                    uint64_t failed = stats.failed.load(memory_order_relaxed);
+                    StatsSnapshot& type = snapshot.types[typeId];
+                    for (StatsSnapshot* target: { &consumer, &type }) {
+                        target->latency.add(latency);
+                        target->handling.add(handling);
+                        target->failed += failed;
+                    }
+                });
+            });
+            snapshot.queueHighWater = queueHighWater.load(memory_order_relaxed);
+            for (size_t i = 0; i < EventQueue::dropReasonCount; i++)
+                snapshot.drops[i] = drops[i].load(memory_order_relaxed);
+            return snapshot;
+        }
+
+    private:
+
+        // Entries by dense index, created at first use, lock-free
+        template<typename T>
+        class Table {
+        public:
+            static const size_t chunkSize = 256;
+            static const size_t chunkCount = 256;
+
+            Table() {
+                for (atomic<atomic<T*>*>& chunk: chunks) chunk.store(nullptr, memory_order_relaxed);
+            }
+
+            Table(const Table&) = delete;
+            Table& operator=(const Table&) = delete;
+
+            ~Table() {
+                for (atomic<atomic<T*>*>& chunk: chunks) {
+                    atomic<T*>* entries = chunk.load();
+                    if (!entries) continue;
+                    for (size_t i = 0; i < chunkSize; i++) delete entries[i].load();
+                    delete[] entries;
+                }
+            }
+
+            // Null above the table size
+            T* get(size_t index) {
+                if (index >= chunkSize * chunkCount) return nullptr;
+                atomic<T*>& entry = getChunk(index / chunkSize)[index % chunkSize];
+                T* found = entry.load(memory_order_acquire);
+                if (found) return found;
+                T* created = new T;
+                if (entry.compare_exchange_strong(found, created, memory_order_acq_rel)) return created;
+                delete created;
+                return found;
+            }
+
+            template<typename Visitor>
+            void forEach(Visitor visit) const {
+                for (size_t c = 0; c < chunkCount; c++) {
+                    atomic<T*>* entries = chunks[c].load(memory_order_acquire);
+                    if (!entries) continue;
+                    for (size_t i = 0; i < chunkSize; i++) {
+                        T* found = entries[i].load(memory_order_acquire);
+                        if (found) visit(c * chunkSize + i, *found);
+                    }
+                }
+            }
+
+        private:
+            atomic<T*>* getChunk(size_t index) {
+                atomic<T*>* entries = chunks[index].load(memory_order_acquire);
+                if (entries) return entries;
+                atomic<T*>* created = new atomic<T*>[chunkSize];
+                for (size_t i = 0; i < chunkSize; i++) created[i].store(nullptr, memory_order_relaxed);
+                if (chunks[index].compare_exchange_strong(entries, created, memory_order_acq_rel)) return created;
+                delete[] created;
+                return entries;
+            }
+
+            atomic<atomic<T*>*> chunks[chunkCount];
+        };
+
+        // Deliveries of one type to one consumer, the per type and
+        // per consumer figures are summed up in the snapshot
+        struct DeliveryStats {
+            Histogram latency;
+            Histogram handling;
+            atomic<uint64_t> failed = 0;
+        };
+
+        struct ConsumerStats {
+            atomic<size_t> highWater = 0;
+            Table<DeliveryStats> types;
+        };
+
+        struct TypeStats {
+            atomic<uint64_t> published = 0;
+        };
+
+        void recordDelivery(const ComponentId& consumerId, const Event& event, chrono::system_clock::time_point start, bool failed) {
+            chrono::system_clock::time_point end = chrono::system_clock::now();
+            ConsumerStats* consumer = consumers.get(consumerId.getIndex());
+            DeliveryStats* stats = consumer ? consumer->types.get(event.getTypeId()) : nullptr;
+            if (!stats) return;
+            stats->latency.record(nanoseconds(start - event.timestamp));
+            stats->handling.record(nanoseconds(end - start));
+            if (failed) stats->failed.fetch_add(1, memory_order_relaxed);
+        }
+
+        // The system clock may step back, negative spans count as zero
+        static uint64_t nanoseconds(chrono::system_clock::duration span) {
+            return max<int64_t>(0, chrono::duration_cast<chrono::nanoseconds>(span).count());
+        }
+
+        static void raise(atomic<size_t>& highWater, size_t value) {
+            size_t current = highWater.load(memory_order_relaxed);
+            while (value > current && !highWater.compare_exchange_weak(current, value, memory_order_relaxed));
+        }
+
+        Table<TypeStats> types;
+        Table<ConsumerStats> consumers;
+        atomic<size_t> queueHighWater = 0;
+        atomic<uint64_t> drops[EventQueue::dropReasonCount] = {};
+    };
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <shared_mutex>
+#include <type_traits>
+#include <unordered_map>
+
+#include "../utils/ERROR.hpp"
+
+#include "Event.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::events {
+
+    // Appends plain values and strings to a byte buffer (host byte order)
+    class BinaryWriter {
+    public:
+        BinaryWriter(vector<unsigned char>& buffer): buffer(buffer) {}
+
+        template<typename T>
+        void write(const T& value) {
+            static_assert(is_trivially_copyable<T>::value, "BinaryWriter writes trivially copyable values only");
+            append(&value, sizeof(T));
+        }
+
+        void write(const string& value) {
+            write<uint32_t>((uint32_t)value.size());
+            append(value.data(), value.size());
+        }
+
+        void append(const void* data, size_t size) {
+            size_t offset = buffer.size();
+            buffer.resize(offset + size);
+            if (size) memcpy(buffer.data() + offset, data, size);
+        }
+
+    private:
+        vector<unsigned char>& buffer;
+    };
+
+    // Reads back what BinaryWriter wrote, throws on truncated input
+    class BinaryReader {
+    public:
+        BinaryReader(const unsigned char* data, size_t size): data(data), size(size) {}
+
+        template<typename T>
+        T read() {
+            static_assert(is_trivially_copyable<T>::value, "BinaryReader reads trivially copyable values only");
+            T value;
+            extract(&value, sizeof(T));
+            return value;
+        }
+
+        string readString() {
+            uint32_t length = read<uint32_t>();
+            if (length > remaining()) throw ERROR("Truncated string in binary event");
+            string value((const char*)data + offset, length);
+            offset += length;
+            return value;
+        }
+
+        void extract(void* target, size_t length) {
+            if (length > remaining()) throw ERROR("Truncated binary event");
+            if (length) memcpy(target, data + offset, length);
+            offset += length;
+        }
+
+        size_t remaining() const { return size - offset; }
+
+    private:
+        const unsigned char* data;
+        size_t size;
+        size_t offset = 0;
+    };
+
+    /**
+     * Binary serialization of events for the transports between processes
+     *
+     * Every event type that crosses the process boundary is registered with
+     * a name (the same on both sides) and its payload encoder and decoder.
+     * The base fields (source, target, timestamp, priority, deadline) are
+     * encoded here, the type goes over as a 64 bit hash of the name, so the
+     * dense EventTypeIds (which differ between processes) never leave.
+     * Register the codecs before the transport is in use.
+     */
+    class EventCodecs {
+    public:
+        using TypeKey = uint64_t;
+
+        template<typename EventType>
+        void add(
+            const string& name,
+            function<void(BinaryWriter&, const EventType&)> encode,
+            function<EventType(BinaryReader&)> decode
+        ) {
+            Codec codec;
+            codec.name = name;
+            codec.key = getTypeKey(name);
+            codec.encode = [encode](BinaryWriter& writer, const Event& event) {
+                encode(writer, static_cast<const EventType&>(event));
+            };
+            codec.decode = [decode](BinaryReader& reader) -> Event* {
+                return new EventType(decode(reader));
+            };
+            EventTypeId id = event_type_id<EventType>();
+            unique_lock<shared_mutex> lock(mtx);
+            auto keyIt = byKey.find(codec.key);
+            if (keyIt != byKey.end() && keyIt->second != id)
+                throw ERROR("Event codec name collides with another type: " + name);
+            byKey[codec.key] = id;
+            byType[id] = codec;
+        }
+
+        bool has(EventTypeId id) const {
+            shared_lock<shared_mutex> lock(mtx);
+            return byType.count(id);
+        }
+
+        // Appends the encoded event to the buffer
+        void encode(const Event& event, vector<unsigned char>& buffer) const {
+            shared_lock<shared_mutex> lock(mtx);
+            auto it = byType.find(event.getTypeId());
+            if (it == byType.end())
+                throw ERROR("No codec for event type: " + string(event.getType().name()));
+            BinaryWriter writer(buffer);
+            writer.write(it->second.key);
+            writer.write(event.sourceId.str());
+            writer.write(event.targetId.str());
+            writer.write<int64_t>(chrono::duration_cast<chrono::nanoseconds>(event.timestamp.time_since_epoch()).count());
+            writer.write<uint8_t>((uint8_t)event.priority);
+            writer.write<int64_t>(encodeDeadline(event.deadline));
+            it->second.encode(writer, event);
+        }
+
+        // New heap event (delete it or set a recycler that does)
+        Event* decode(const unsigned char* data, size_t size) const {
+            BinaryReader reader(data, size);
+            TypeKey key = reader.read<TypeKey>();
+            shared_lock<shared_mutex> lock(mtx);
+            auto keyIt = byKey.find(key);
+            if (keyIt == byKey.end()) throw ERROR("No codec for event type key: " + to_string(key));
+            const Codec& codec = byType.at(keyIt->second);
+            ComponentId sourceId = reader.readString();
+            ComponentId targetId = reader.readString();
+            chrono::system_clock::time_point timestamp(chrono::duration_cast<chrono::system_clock::duration>(
+                chrono::nanoseconds(reader.read<int64_t>())));
+            uint8_t priority = reader.read<uint8_t>();
+            if (priority >= eventPriorityCount) throw ERROR("Invalid event priority: " + to_string(priority));
+            chrono::steady_clock::time_point deadline = decodeDeadline(reader.read<int64_t>());
+            Event* event = codec.decode(reader);
+            event->sourceId = sourceId;
+            event->targetId = targetId;
+            event->timestamp = timestamp;
+            event->priority = (EventPriority)priority;
+            event->deadline = deadline;
+            return event;
+        }
+
+        // FNV-1a of the name
+        static TypeKey getTypeKey(const string& name) {
+            TypeKey hash = 14695981039346656037ull;
+            for (unsigned char c: name) {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+    private:
+        struct Codec {
+            string name;
+            TypeKey key;
+            function<void(BinaryWriter&, const Event&)> encode;
+            function<Event*(BinaryReader&)> decode;
+        };
+
+        // The steady clock is the system-wide monotonic clock (on Linux),
+        // so deadlines are comparable between processes of the same host
+        static int64_t encodeDeadline(chrono::steady_clock::time_point deadline) {
+            if (deadline == chrono::steady_clock::time_point::max()) return INT64_MAX;
+            return chrono::duration_cast<chrono::nanoseconds>(deadline.time_since_epoch()).count();
+        }
+
+        static chrono::steady_clock::time_point decodeDeadline(int64_t ns) {
+            if (ns == INT64_MAX) return chrono::steady_clock::time_point::max();
+            return chrono::steady_clock::time_point(chrono::duration_cast<chrono::steady_clock::duration>(chrono::nanoseconds(ns)));
+        }
+
+        mutable shared_mutex mtx;
+        unordered_map<EventTypeId, Codec> byType;
+        unordered_map<TypeKey, EventTypeId> byKey;
+    };
+
+}
+
+#ifdef TEST
+
+#include "../utils/Test.hpp"
+#include "tests/TestEvent.hpp"
+
+using namespace tools::events;
+
+void test_EventCodecs_round_trip() {
+    EventCodecs codecs;
+    codecs.add<TestEvent>("TestEvent",
+        [](BinaryWriter& writer, const TestEvent& event) { writer.write(event.value); },
+        [](BinaryReader& reader) { return TestEvent(reader.read<int>()); }
+    );
+    TestEvent event(42);
+    event.sourceId = "source";
+    event.targetId = "target";
+    event.timestamp = chrono::system_clock::now();
+    event.priority = EventPriority::High;
+    event.expireAfter(chrono::milliseconds(1000));
+    vector<unsigned char> buffer;
+    codecs.encode(event, buffer);
+    Event* decoded = codecs.decode(buffer.data(), buffer.size());
+    assert(decoded->getTypeId() == event_type_id<TestEvent>() && "Decoded event should have the registered type");
+    assert(static_cast<TestEvent*>(decoded)->value == 42 && "Decoded event should keep the payload");
+    assert(decoded->sourceId == "source" && decoded->targetId == "target" && "Decoded event should keep the ids");
+    assert(decoded->timestamp == event.timestamp && "Decoded event should keep the timestamp");
+    assert(decoded->priority == EventPriority::High && "Decoded event should keep the priority");
+    assert(decoded->deadline == event.deadline && "Decoded event should keep the deadline");
+    delete decoded;
+}
+
+void test_EventCodecs_unknown_and_truncated() {
+    class UnregisteredEvent : public TypedEvent<UnregisteredEvent> {};
+    EventCodecs codecs;
+    codecs.add<TestEvent>("TestEvent",
+        [](BinaryWriter& writer, const TestEvent& event) { writer.write(event.value); },
+        [](BinaryReader& reader) { return TestEvent(reader.read<int>()); }
+    );
+    vector<unsigned char> buffer;
+    bool thrown = false;
+    try {
+        codecs.encode(UnregisteredEvent(), buffer);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Unregistered event type should not be encoded");
+
+    codecs.encode(TestEvent(1), buffer);
+    thrown = false;
+    try {
+        codecs.decode(buffer.data(), buffer.size() - 1);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Truncated event should not be decoded");
+}
+
+TEST(test_EventCodecs_round_trip);
+TEST(test_EventCodecs_unknown_and_truncated);
+
+#endif
@@ -20,16 +20,21 @@ namespace tools::events {
         virtual ~EventConsumer() = default;
         
         // Handle an incoming event
-        virtual void handleEvent(Event& event) UNIMP_NEED
+        virtual void handleEvent(Event& event) = 0;
         
         // Register this consumer with the event bus
-        virtual void registerWithEventBus(EventBus* bus) UNIMP_NEED
+        virtual void registerWithEventBus(EventBus* bus) = 0;
         
         // Get unique identifier for this consumer
-        virtual ComponentId getId() const UNIMP_NEED
+        virtual ComponentId getId() const = 0;
         
         // Check if this consumer can handle a specific event type
-        virtual bool canHandle(type_index eventType) const UNIMP_NEED
+        virtual bool canHandle(type_index eventType) const = 0;
+
+        // Same by dense type id, used on the dispatch path
+        virtual bool canHandleType(EventTypeId eventTypeId) const {
+            return canHandle(event_type_index(eventTypeId));
+        }
     };
     
 }
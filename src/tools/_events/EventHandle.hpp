@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Event.hpp"
+
+using namespace std;
+
+namespace tools::events {
+
+    /**
+     * Move-only owner of one hold() of an event, the event is released
+     * (and recycled by its pool or queue) when the handle goes away.
+     */
+    class EventHandle {
+    public:
+        EventHandle(Event* event = nullptr): event(event) {}
+
+        EventHandle(const EventHandle&) = delete;
+        EventHandle& operator=(const EventHandle&) = delete;
+
+        EventHandle(EventHandle&& other) noexcept: event(other.event) {
+            other.event = nullptr;
+        }
+
+        EventHandle& operator=(EventHandle&& other) noexcept {
+            if (this == &other) return *this;
+            reset(other.event);
+            other.event = nullptr;
+            return *this;
+        }
+
+        ~EventHandle() {
+            reset();
+        }
+
+        // Takes over an already held event (releases the previous one)
+        void reset(Event* event = nullptr) {
+            if (this->event) this->event->release();
+            this->event = event;
+        }
+
+        Event* get() const { return event; }
+        Event* operator->() const { return event; }
+        Event& operator*() const { return *event; }
+        explicit operator bool() const { return event; }
+
+        // Typed access, nullptr if the event is an other type
+        template<typename EventType>
+        EventType* as() const {
+            return dynamic_cast<EventType*>(event);
+        }
+
+    private:
+        Event* event = nullptr;
+    };
+
+}
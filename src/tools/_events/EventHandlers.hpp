@@ -0,0 +1,91 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <functional>
+
+#include "Event.hpp"
+
+using namespace std;
+
+namespace tools::events {
+
+    /**
+     * Typed event handlers of a consumer, in a flat table indexed by EventTypeId.
+     * Dispatch is an index into the table and a static cast, no hashing or
+     * RTTI lookups per event.
+     */
+    class EventHandlers {
+    public:
+        using Handler = function<void(Event&)>;
+
+        template<typename EventType>
+        EventTypeId add(function<void(EventType&)> handler) {
+            EventTypeId id = event_type_id<EventType>();
+            lock_guard<mutex> lock(mtx);
+            if (table.size() <= id) table.resize(id + 1);
+            table[id].push_back([handler](Event& event) {
+                handler(static_cast<EventType&>(event));
+            });
+            return id;
+        }
+
+        bool has(EventTypeId id) const {
+            lock_guard<mutex> lock(mtx);
+            return id < table.size() && !table[id].empty();
+        }
+
+        // Handlers of one consumer are serialized
+        void dispatch(Event& event) {
+            EventTypeId id = event.getTypeId();
+            lock_guard<mutex> lock(mtx);
+            if (id >= table.size()) return;
+            for (Handler& handler: table[id]) handler(event);
+        }
+
+    private:
+        mutable mutex mtx;
+        vector<vector<Handler>> table;
+    };
+
+}
+
+#ifdef TEST
+
+#include "../utils/Test.hpp"
+#include "tests/TestEvent.hpp"
+
+using namespace tools::events;
+
+void test_EventHandlers_dispatch_by_type_id() {
+    class OtherTypedEvent : public TypedEvent<OtherTypedEvent> {};
+    EventHandlers handlers;
+    int received = 0;
+    EventTypeId id = handlers.add<TestEvent>([&](TestEvent& event) { received += event.value; });
+    assert(id == event_type_id<TestEvent>() && "add() should return the type id of the event");
+    assert(handlers.has(id) && "Handler table should have the registered type");
+    assert(!handlers.has(event_type_id<OtherTypedEvent>()) && "Handler table should not have other types");
+
+    TestEvent event(5);
+    OtherTypedEvent other;
+    handlers.dispatch(event);
+    handlers.dispatch(event);
+    handlers.dispatch(other);
+    assert(received == 10 && "Only the handlers of the event type should be called");
+}
+
+void test_EventHandlers_type_ids_are_dense_and_stable() {
+    class FirstEvent : public TypedEvent<FirstEvent> {};
+    class SecondEvent : public TypedEvent<SecondEvent> {};
+    EventTypeId first = event_type_id<FirstEvent>();
+    EventTypeId second = event_type_id<SecondEvent>();
+    assert(first != second && "Different types should get different ids");
+    assert(first == event_type_id(type_index(typeid(FirstEvent))) && "Template and runtime lookup should agree");
+    assert(FirstEvent().getTypeId() == first && "Event should report its type id");
+    assert(event_type_index(second) == type_index(typeid(SecondEvent)) && "Id should map back to the type");
+}
+
+TEST(test_EventHandlers_dispatch_by_type_id);
+TEST(test_EventHandlers_type_ids_are_dense_and_stable);
+
+#endif
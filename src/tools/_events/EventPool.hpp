@@ -0,0 +1,198 @@
+#pragma once
+
+#include <new>
+#include <mutex>
+#include <vector>
+#include <utility>
+
+#include "Event.hpp"
+
+using namespace std;
+
+namespace tools::events {
+
+    /**
+     * Per-type free-list of event storage.
+     *
+     * Events are constructed in place into recycled storage and the
+     * pool registers itself as the recycler of the event, so the event
+     * is destructed and its storage goes back to the free-list
+     * deterministically when the last holder calls release().
+     */
+    template<typename EventType>
+    class EventPool {
+        static_assert(is_base_of<Event, EventType>::value, "EventType must be derived from Event");
+    public:
+        // Never destructed: events released during static destruction
+        // (held by other statics) still have a pool to go back to
+        static EventPool& instance() {
+            static EventPool* pool = new EventPool();
+            return *pool;
+        }
+
+        // Constructs a new event in recycled (or freshly allocated) storage
+        template<typename... Args>
+        EventType* acquire(Args&&... args) {
+            void* storage = nullptr;
+            {
+                lock_guard<mutex> lock(mtx);
+                if (!freeList.empty()) {
+                    storage = freeList.back();
+                    freeList.pop_back();
+                } else allocated++;
+                live++;
+            }
+            if (!storage) storage = allocate();
+            EventType* event = nullptr;
+            try {
+                event = new (storage) EventType(forward<Args>(args)...);
+            } catch (...) {
+                giveBack(storage);
+                throw;
+            }
+            event->recycler = &EventPool::recycle;
+            return event;
+        }
+
+        // Maximum number of idle storage blocks kept for reuse, the rest is freed
+        void setMaxFree(size_t maxFree) {
+            lock_guard<mutex> lock(mtx);
+            this->maxFree = maxFree;
+            while (freeList.size() > maxFree) {
+                deallocate(freeList.back());
+                freeList.pop_back();
+            }
+        }
+
+        size_t getAllocatedCount() const {
+            lock_guard<mutex> lock(mtx);
+            return allocated;
+        }
+
+        size_t getLiveCount() const {
+            lock_guard<mutex> lock(mtx);
+            return live;
+        }
+
+        size_t getFreeCount() const {
+            lock_guard<mutex> lock(mtx);
+            return freeList.size();
+        }
+
+    private:
+        EventPool() = default;
+
+        static void recycle(Event* event) {
+            EventType* derived = (EventType*)event;
+            derived->~EventType();
+            instance().giveBack(derived);
+        }
+
+        void giveBack(void* storage) {
+            lock_guard<mutex> lock(mtx);
+            live--;
+            if (freeList.size() < maxFree) {
+                freeList.push_back(storage);
+                return;
+            }
+            allocated--;
+            deallocate(storage);
+        }
+
+        static void* allocate() {
+            return ::operator new(sizeof(EventType), align_val_t(alignof(EventType)));
+        }
+
+        static void deallocate(void* storage) {
+            ::operator delete(storage, align_val_t(alignof(EventType)));
+        }
+
+        mutable mutex mtx;
+        vector<void*> freeList;
+        size_t maxFree = 1024;
+        size_t allocated = 0;
+        size_t live = 0;
+    };
+
+}
+
+#ifdef TEST
+
+#include "../utils/Test.hpp"
+#include "tests/TestEvent.hpp"
+
+using namespace tools::events;
+
+void test_EventPool_acquire_constructs_event() {
+    TestEvent* event = EventPool<TestEvent>::instance().acquire(42);
+    assert(event->value == 42 && "Pooled event should be constructed with the given arguments");
+    event->hold();
+    event->release();
+}
+
+void test_EventPool_release_recycles_storage() {
+    EventPool<TestEvent>& pool = EventPool<TestEvent>::instance();
+    size_t liveBefore = pool.getLiveCount();
+    TestEvent* event = pool.acquire(1);
+    assert(pool.getLiveCount() == liveBefore + 1 && "Acquired event should be counted as live");
+    event->hold();
+    event->release();
+    assert(pool.getLiveCount() == liveBefore && "Released event should not be live anymore");
+    size_t allocatedBefore = pool.getAllocatedCount();
+    TestEvent* reused = pool.acquire(2);
+    assert(pool.getAllocatedCount() == allocatedBefore && "Storage should be reused from the free-list");
+    assert(reused->value == 2 && "Reused storage should hold the new event");
+    reused->hold();
+    reused->release();
+}
+
+void test_EventPool_multiple_holders() {
+    EventPool<TestEvent>& pool = EventPool<TestEvent>::instance();
+    size_t liveBefore = pool.getLiveCount();
+    TestEvent* event = pool.acquire(3);
+    event->hold();
+    event->hold();
+    event->release();
+    assert(event->isHolded() && "Event should stay alive while any holder keeps it");
+    assert(pool.getLiveCount() == liveBefore + 1 && "Held event should still be live");
+    event->release();
+    assert(pool.getLiveCount() == liveBefore && "Event should be reclaimed when the last holder releases");
+}
+
+void test_EventPool_setMaxFree_limits_idle_storage() {
+    EventPool<TestEvent>& pool = EventPool<TestEvent>::instance();
+    vector<TestEvent*> events;
+    for (int i = 0; i < 5; i++) {
+        events.push_back(pool.acquire(i));
+        events.back()->hold();
+    }
+    pool.setMaxFree(2);
+    for (TestEvent* event: events) event->release();
+    assert(pool.getFreeCount() == 2 && "Free-list should not grow over the limit");
+    pool.setMaxFree(1024);
+}
+
+void test_EventPool_concurrent_acquire_release() {
+    EventPool<TestEvent>& pool = EventPool<TestEvent>::instance();
+    size_t liveBefore = pool.getLiveCount();
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&pool]() {
+            for (int i = 0; i < 1000; i++) {
+                TestEvent* event = pool.acquire(i);
+                event->hold();
+                event->release();
+            }
+        });
+    }
+    for (thread& t: threads) t.join();
+    assert(pool.getLiveCount() == liveBefore && "All events should be reclaimed after concurrent use");
+}
+
+TEST(test_EventPool_acquire_constructs_event);
+TEST(test_EventPool_release_recycles_storage);
+TEST(test_EventPool_multiple_holders);
+TEST(test_EventPool_setMaxFree_limits_idle_storage);
+TEST(test_EventPool_concurrent_acquire_release);
+
+#endif
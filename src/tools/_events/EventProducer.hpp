@@ -20,10 +20,10 @@ namespace tools::events {
         virtual ~EventProducer() = default;
         
         // Register this producer with the event bus
-        virtual void registerWithEventBus(EventBus* bus) UNIMP_NEED
+        virtual void registerWithEventBus(EventBus* bus) = 0;
         
         // Get unique identifier for this producer
-        virtual ComponentId getId() const UNIMP_NEED
+        virtual ComponentId getId() const = 0;
     };
 
 }
\ No newline at end of file
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
+#include <functional>
 
 #include "../utils/ERROR.hpp"
 
 #include "Event.hpp"
+#include "EventHandle.hpp"
 
 using namespace std;
 using namespace tools::utils;
@@ -16,11 +20,90 @@ namespace tools::events {
      */
     class EventQueue {
     public:
+        enum class DropReason {
+            Expired,  // deadline or queue expiry passed before it was read
+            Overflow, // oldest of the same priority, rotated out by a full queue
+            Evicted,  // lower priority event, made room for a higher priority one
+            Rejected, // incoming event, the queue is full (of higher priority ones)
+        };
+
+        static const size_t dropReasonCount = 4;
+
+        static string getDropReasonName(DropReason reason) {
+            switch (reason) {
+                case DropReason::Expired: return "expired";
+                case DropReason::Overflow: return "overflow";
+                case DropReason::Evicted: return "evicted";
+                case DropReason::Rejected: return "rejected";
+            }
+            return "unknown";
+        }
+
+        using DropCallback = function<void(size_t count, DropReason reason)>;
+
         virtual ~EventQueue() = default;
-        virtual bool write(Event& event) UNIMP_THROWS  // Add an event to the queue
-        virtual size_t read(Event& event, bool blocking, int timeoutMs) UNIMP_THROWS // Retrieve an event
-        virtual size_t available() const UNIMP_THROWS  // Check number of available events
-        virtual size_t getCapacity() const UNIMP_THROWS
+        virtual bool write(Event& event) = 0; // Add an event to the queue
+        virtual size_t read(Event& event, bool blocking, int timeoutMs) = 0; // Retrieve an event
+        // Zero-copy hand over: the queue takes over one hold() of the event on success
+        // and the reader takes it over from the queue (and has to release() it)
+        virtual bool push(Event* event) = 0;
+        virtual size_t pop(Event*& event, bool blocking, int timeoutMs) = 0;
+        // Pushes the events in order, takes over one hold of each like push()
+        // but releases the rejected ones itself. Returns the number queued.
+        virtual size_t pushBatch(Event* const* events, size_t count) {
+            size_t pushed = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (push(events[i])) pushed++;
+                else events[i]->release();
+            }
+            return pushed;
+        }
+        virtual size_t available() const = 0; // Check number of available events
+        virtual size_t getCapacity() const = 0;
+
+        // Zero-copy read, the handle keeps the event until it goes away
+        size_t read(EventHandle& handle, bool blocking, int timeoutMs) {
+            Event* event = nullptr;
+            if (!pop(event, blocking, timeoutMs)) return 0;
+            handle.reset(event);
+            return 1;
+        }
+
+        // Replaces the callback set here before (the added ones stay), called from
+        // the writer (or reader) that drops. Set it up before the queue is in use.
+        void setDropCallback(DropCallback callback) {
+            removeDropCallback(setDropCallbackId);
+            setDropCallbackId = addDropCallback(callback);
+        }
+
+        // For the callers that only count the drops
+        void setDropCallback(function<void(size_t)> callback) {
+            setDropCallback([callback](size_t count, DropReason) { callback(count); });
+        }
+
+        // Keeps the other callbacks (e.g. for the EventBus metrics), returns an id for removeDropCallback()
+        size_t addDropCallback(DropCallback callback) {
+            dropCallbacks.push_back({ ++lastDropCallbackId, callback });
+            return lastDropCallbackId;
+        }
+
+        void removeDropCallback(size_t id) {
+            for (auto it = dropCallbacks.begin(); it != dropCallbacks.end(); it++) {
+                if (it->first != id) continue;
+                dropCallbacks.erase(it);
+                return;
+            }
+        }
+
+    protected:
+        void notifyDrop(size_t count, DropReason reason) {
+            for (const auto& [id, callback]: dropCallbacks) callback(count, reason);
+        }
+
+    private:
+        vector<pair<size_t, DropCallback>> dropCallbacks;
+        size_t lastDropCallbackId = 0;
+        size_t setDropCallbackId = 0; // 0: none
     };
     
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "../utils/Logger.hpp"
+#include "../utils/RcuPointer.hpp"
 
 #include "Event.hpp"
 #include "EventBus.hpp"
@@ -14,6 +15,7 @@ using namespace tools::utils;
 namespace tools::events {
 
     // Enhanced event bus with filtering support (thread safe)
+    // The filters are kept in a copy-on-write list, delivery reads it without locking
     class FilteredEventBus : public EventBus {
     public:
         FilteredEventBus(
@@ -24,17 +26,29 @@ namespace tools::events {
             m_logger(logger),
             m_selfMessageFilter(false)
         {}
+
+        ~FilteredEventBus() {
+            stop(); // the dispatchers call back to the filters
+        }
         
         // Add a custom event filter
         void addEventFilter(EventFilter& filter) {
-            lock_guard<mutex> lock(m_filterMutex);
-            m_filters.push_back(&filter);
+            {
+                lock_guard<mutex> lock(m_filterMutex);
+                unique_ptr<vector<EventFilter*>> filters = make_unique<vector<EventFilter*>>(*m_filters.read());
+                filters->push_back(&filter);
+                m_filters.replace(move(filters));
+            }
+            m_filters.synchronize();
         }
         
-        // Remove all filters
+        // Remove all filters, returns when no delivery uses them anymore (unless called from a handler)
         void clearFilters() {
-            lock_guard<mutex> lock(m_filterMutex);
-            m_filters.clear();
+            {
+                lock_guard<mutex> lock(m_filterMutex);
+                m_filters.replace(make_unique<vector<EventFilter*>>());
+            }
+            m_filters.synchronize();
         }
         
         // Get the self-message filter (for enabling/disabling)
@@ -43,29 +57,19 @@ namespace tools::events {
         }
         
     protected:
-        // Override the deliverEvent method to apply filters
-        function<void(EventBus*, Event&)> deliverEventInternal = [](EventBus* that, Event& event) {
-            that->m_logger.debug("Delivering event from " + event.sourceId + (event.targetId.empty() ? " (broadcast)" : " to " + event.targetId));
-            ((FilteredEventBus*)that)->deliverEventToInterestedConsumers(event);
-        };
-        
-        // Access to parent class protected members
-        using EventBus::m_mutex;
-        using EventBus::m_consumers;
-        using EventBus::m_eventInterests;
-        
-    private:
-        // Deliver an event to a specific target with filtering
-        bool shouldDeliverEvent(const ComponentId& consumerId, Event& event) {
-            // Get a copy of filters to avoid holding the lock during filter evaluation
-            vector<EventFilter*> filtersCopy;
-            {
-                lock_guard<mutex> lock(m_filterMutex);
-                filtersCopy = m_filters;
-            }
-            
-            // Check if any filter rejects the event
-            for (EventFilter* filter: filtersCopy) {
+        void deliverEventInternal(Event& event) override {
+            bool debug = m_logger.getMinLogLevel() <= Logger::Level::DEBUG; // don't build the messages for nothing
+            if (debug) m_logger.debug("Delivering event from " + event.sourceId + (event.targetId.empty() ? " (broadcast)" : " to " + event.targetId));
+            forEachRecipient(event, [this, &event, debug](const ComponentId& consumerId, const Subscriber& subscriber) {
+                if (debug) m_logger.debug("Delivering event to " + consumerId);
+                deliverTo(subscriber, event);
+            });
+        }
+
+        // Check if any filter rejects the event
+        bool shouldDeliverEvent(const ComponentId& consumerId, Event& event) override {
+            RcuPointer<vector<EventFilter*>>::Reader filters = m_filters.read();
+            for (EventFilter* filter: *filters) {
                 if (!filter->shouldDeliverEvent(consumerId, event)) {
                     return false;
                 }
@@ -75,31 +79,12 @@ namespace tools::events {
             return m_selfMessageFilter.shouldDeliverEvent(consumerId, event);
         }
         
-        // Deliver an event to all interested consumers with filtering
-        void deliverEventToInterestedConsumers(Event& event) {
-            unique_lock<shared_mutex> lock(m_mutex);
-        
-            auto typeIt = m_eventInterests.find(event.getType());
-            if (typeIt != m_eventInterests.end()) {
-                for (const ComponentId& consumerId : typeIt->second) {
-                    auto consumerIt = m_consumers.find(consumerId);
-                    if (consumerIt != m_consumers.end()) {
-                        if (shouldDeliverEvent(consumerId, event)) {
-                            m_logger.debug("Delivering broadcast event to " + consumerId);
-                            consumerIt->second->handleEvent(event);
-                        } else {
-                            m_logger.debug("Filtered out broadcast event to " + consumerId);
-                        }
-                    }
-                }
-            }
-        }
-        
+    private:
         // Filtering
-        mutex m_filterMutex;
-        vector<EventFilter*> m_filters;
-        SelfMessageFilter m_selfMessageFilter;
+        mutex m_filterMutex; // serializes the writers only
+        RcuPointer<vector<EventFilter*>> m_filters;
         Logger& m_logger;
+        SelfMessageFilter m_selfMessageFilter;
     };    
 
 }
@@ -110,6 +95,7 @@ namespace tools::events {
 #include "../utils/tests/MockLogger.hpp"
 #include "tests/TestEvent.hpp"
 #include "tests/MockConsumer.hpp"
+#include "BaseEventConsumer.hpp"
 
 // Test FilteredEventBus default behavior (self-filter off)
 void test_FilteredEventBus_deliverEvent_self_allowed_default() {
@@ -198,10 +184,51 @@ void test_FilteredEventBus_clearFilters_restores_delivery() {
     assert(afterClearCount == 1 && "Agent should receive event after clearing filters and resetting self-filter");
 }
 
+// Test publishing concurrently while consumers and filters are changing
+void test_FilteredEventBus_concurrent_publish_and_registration() {
+    class CountingFilter : public EventFilter {
+    public:
+        atomic<int> calls = 0;
+        bool shouldDeliverEvent(const ComponentId&, Event&) override { calls++; return true; }
+    };
+    class CountingConsumer : public BaseEventConsumer {
+    public:
+        using BaseEventConsumer::BaseEventConsumer;
+        atomic<int> received = 0;
+    protected:
+        void registerEventInterests() override {
+            registerHandler<TestEvent>([this](TestEvent&) { received++; });
+        }
+    };
+    MockLogger logger;
+    RingBufferEventQueue eventQueue(1000, logger);
+    FilteredEventBus bus(logger, eventQueue);
+    CountingFilter filter;
+    bus.addEventFilter(filter);
+    atomic<bool> publishing = true;
+    vector<thread> publishers;
+    for (int i = 0; i < 4; i++) {
+        publishers.emplace_back([&bus, &publishing]() {
+            while (publishing) bus.createAndPublishEvent<TestEvent>("publisher", "", 1);
+        });
+    }
+    for (int i = 0; i < 20; i++) {
+        CountingConsumer consumer("consumer" + to_string(i));
+        consumer.registerWithEventBus(&bus);
+        while (consumer.received < 10) this_thread::yield();
+        bus.unregisterConsumer(consumer.getId()); // must not return while a publisher is still delivering to it
+    }
+    publishing = false;
+    for (thread& publisher: publishers) publisher.join();
+    assert(filter.calls > 0 && "Filter should be called while consumers are registered");
+    bus.clearFilters();
+}
+
 // Register tests
 TEST(test_FilteredEventBus_deliverEvent_self_allowed_default);
 TEST(test_FilteredEventBus_deliverEvent_self_filtered);
 TEST(test_FilteredEventBus_deliverEvent_custom_filter_blocks);
 TEST(test_FilteredEventBus_deliverEvent_targeted_self_filtered);
 TEST(test_FilteredEventBus_clearFilters_restores_delivery);
+TEST(test_FilteredEventBus_concurrent_publish_and_registration);
 #endif
\ No newline at end of file
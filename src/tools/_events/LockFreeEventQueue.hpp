@@ -0,0 +1,430 @@
+#pragma once
+
+#include <new>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <climits>
+#include <functional>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include "../utils/ERROR.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/RingBuffer.hpp"
+
+#include "EventQueue.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::events {
+
+    /**
+     * Bounded lock-free multi-producer/multi-consumer EventQueue
+     *
+     * Sequence numbered cells (D. Vyukov's bounded MPMC queue) with cache-line
+     * padded indices, the capacity is rounded up to a power of two.
+     * Events are passed by reference (push/pop), write() copies the event
+     * to the heap first. Blocking reads spin for a while then sleep on a futex.
+     * Overflow policies are the RingBuffer ones, applied per event, so
+     * under contention Rotate/Reset may drop events written concurrently.
+     */
+    class LockFreeEventQueue : public EventQueue {
+    public:
+        using WritePolicy = RingBuffer<Event*>::WritePolicy;
+
+        static const size_t cacheLineSize = 64;
+        static const int spinCount = 256;
+
+        LockFreeEventQueue(
+            size_t capacity,
+            Logger& logger,
+            WritePolicy policy = WritePolicy::Rotate
+        ):
+            capacity(roundUp(capacity)),
+            mask(this->capacity - 1),
+            cells(make_unique<Cell[]>(this->capacity)),
+            policy(policy),
+            logger(logger)
+        {
+            for (size_t i = 0; i < this->capacity; i++)
+                cells[i].sequence.store(i, memory_order_relaxed);
+        }
+
+        virtual ~LockFreeEventQueue() {
+            Event* event = nullptr;
+            while (tryPop(event)) event->release();
+        }
+
+        using EventQueue::read;
+
+        // Copies the event to the heap and queues the copy
+        bool write(Event& event) override {
+            Event* copy = event.copyTo(::operator new(event.getSize(), align_val_t(event.getAlignment())));
+            copy->recycler = &LockFreeEventQueue::destroy;
+            copy->hold();
+            if (push(copy)) return true;
+            copy->release();
+            return false;
+        }
+
+        size_t read(Event& event, bool blocking, int timeoutMs) override {
+            Event* stored = nullptr;
+            if (!pop(stored, blocking, timeoutMs)) return 0;
+            stored->assignTo(event);
+            stored->release();
+            return 1;
+        }
+
+        bool push(Event* event) override {
+            NULLCHK(event);
+            if (!enqueue(event)) return false;
+            wake();
+            return true;
+        }
+
+        // Wakes the readers once for the whole batch
+        size_t pushBatch(Event* const* events, size_t count) override {
+            for (size_t i = 0; i < count; i++) NULLCHK(events[i]);
+            size_t pushed = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (enqueue(events[i])) pushed++;
+                else events[i]->release();
+            }
+            if (pushed) wake();
+            return pushed;
+        }
+
+        size_t pop(Event*& event, bool blocking, int timeoutMs) override {
+            if (tryPop(event)) return 1;
+            if (!blocking) return 0;
+            for (int i = 0; i < spinCount; i++) {
+                if (tryPop(event)) return 1;
+                if (i % 16 == 15) this_thread::yield();
+            }
+            auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+            while (true) {
+                sleepers.fetch_add(1, memory_order_seq_cst);
+                uint32_t seen = signal.load(memory_order_seq_cst);
+                if (tryPop(event)) {
+                    sleepers.fetch_sub(1, memory_order_relaxed);
+                    return 1;
+                }
+                auto now = chrono::steady_clock::now();
+                if (now >= deadline) {
+                    sleepers.fetch_sub(1, memory_order_relaxed);
+                    return 0;
+                }
+                wait(seen, chrono::duration_cast<chrono::nanoseconds>(deadline - now));
+                sleepers.fetch_sub(1, memory_order_relaxed);
+                if (tryPop(event)) return 1;
+            }
+        }
+
+        // Approximate under concurrent use
+        size_t available() const override {
+            size_t enqueued = enqueuePos.load(memory_order_acquire);
+            size_t dequeued = dequeuePos.load(memory_order_acquire);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        size_t getCapacity() const override {
+            return capacity;
+        }
+
+    private:
+
+        struct alignas(cacheLineSize) Cell {
+            atomic<size_t> sequence;
+            Event* event = nullptr;
+        };
+
+        static size_t roundUp(size_t capacity) {
+            if (capacity < 1) throw ERROR("Capacity must be at least 1");
+            size_t rounded = 1;
+            while (rounded < capacity) rounded <<= 1;
+            return rounded;
+        }
+
+        bool tryPush(Event* event) {
+            Cell* cell;
+            size_t pos = enqueuePos.load(memory_order_relaxed);
+            while (true) {
+                cell = &cells[pos & mask];
+                size_t sequence = cell->sequence.load(memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    if (pos - dequeuePos.load(memory_order_acquire) >= capacity) return false; // full
+                    pos = enqueuePos.load(memory_order_relaxed); // a reader is still freeing the cell
+                } else pos = enqueuePos.load(memory_order_relaxed);
+            }
+            cell->event = event;
+            cell->sequence.store(pos + 1, memory_order_release);
+            return true;
+        }
+
+        bool tryPop(Event*& event) {
+            Cell* cell;
+            size_t pos = dequeuePos.load(memory_order_relaxed);
+            while (true) {
+                cell = &cells[pos & mask];
+                size_t sequence = cell->sequence.load(memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+                if (diff == 0) {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+                } else if (diff < 0) return false; // empty
+                else pos = dequeuePos.load(memory_order_relaxed);
+            }
+            event = cell->event;
+            cell->sequence.store(pos + mask + 1, memory_order_release);
+            return true;
+        }
+
+        // Wakes up the sleeping readers (if any)
+        void wake() {
+            if (!sleepers.load(memory_order_seq_cst)) return;
+            signal.fetch_add(1, memory_order_seq_cst);
+#ifdef __linux__
+            syscall(SYS_futex, (uint32_t*)&signal, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+        }
+
+        void wait(uint32_t seen, chrono::nanoseconds timeout) {
+#ifdef __linux__
+            static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t), "futex needs a plain 32 bit word");
+            struct timespec ts;
+            ts.tv_sec = timeout.count() / 1000000000;
+            ts.tv_nsec = timeout.count() % 1000000000;
+            syscall(SYS_futex, (uint32_t*)&signal, FUTEX_WAIT_PRIVATE, seen, &ts, nullptr, 0);
+#else
+            (void)seen;
+            this_thread::sleep_for(min(timeout, chrono::nanoseconds(1000000)));
+#endif
+        }
+
+        void reportDrop(size_t count, DropReason reason) {
+            logger.warn("Dropped " + to_string(count) + " event(s) due to full queue");
+            notifyDrop(count, reason);
+        }
+
+        // Applies the write policy when full
+        bool enqueue(Event* event) {
+            while (!tryPush(event)) {
+                if (policy == WritePolicy::Reject) {
+                    reportDrop(1, DropReason::Rejected);
+                    return false;
+                }
+                size_t dropped = 0;
+                Event* oldest = nullptr;
+                do {
+                    if (!tryPop(oldest)) break;
+                    oldest->release();
+                    dropped++;
+                } while (policy == WritePolicy::Reset);
+                if (dropped) reportDrop(dropped, DropReason::Overflow);
+            }
+            return true;
+        }
+
+        // Recycler of the events copied by write()
+        static void destroy(Event* event) {
+            size_t alignment = event->getAlignment();
+            event->~Event();
+            ::operator delete((void*)event, align_val_t(alignment));
+        }
+
+        const size_t capacity;
+        const size_t mask;
+        unique_ptr<Cell[]> cells;
+        alignas(cacheLineSize) atomic<size_t> enqueuePos = 0;
+        alignas(cacheLineSize) atomic<size_t> dequeuePos = 0;
+        alignas(cacheLineSize) atomic<uint32_t> signal = 0;
+        atomic<uint32_t> sleepers = 0;
+        WritePolicy policy;
+        Logger& logger;
+    };
+
+}
+
+#ifdef TEST
+
+#include "../utils/Test.hpp"
+#include "../utils/tests/MockLogger.hpp"
+#include "tests/TestEvent.hpp"
+
+void test_LockFreeEventQueue_write_read_keeps_payload() {
+    MockLogger logger;
+    LockFreeEventQueue queue(4, logger);
+    TestEvent event(42);
+    event.sourceId = "source";
+    bool success = queue.write(event);
+    assert(success && "Write should succeed with empty queue");
+    assert(queue.available() == 1 && "Queue should have 1 event after write");
+    EventHandle handle;
+    size_t readCount = queue.read(handle, false, 0);
+    assert(readCount == 1 && "Read should return 1 event");
+    assert(handle.as<TestEvent>() && handle.as<TestEvent>()->value == 42 && "Read event should keep the payload");
+    assert(handle->sourceId == "source" && "Read event should keep the base fields");
+    assert(queue.available() == 0 && "Queue should be empty after read");
+}
+
+void test_LockFreeEventQueue_capacity_rounded_up() {
+    MockLogger logger;
+    LockFreeEventQueue queue(5, logger);
+    assert(queue.getCapacity() == 8 && "Capacity should be rounded up to a power of two");
+    bool thrown = false;
+    try {
+        LockFreeEventQueue invalid(0, logger);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Zero capacity should throw");
+}
+
+void test_LockFreeEventQueue_push_pop_reference() {
+    MockLogger logger;
+    LockFreeEventQueue queue(2, logger);
+    TestEvent event(1);
+    event.hold();
+    queue.push(&event);
+    Event* popped = nullptr;
+    assert(queue.pop(popped, false, 0) == 1 && popped == &event && "Pop should return the pushed event itself");
+    assert(queue.pop(popped, false, 0) == 0 && "Pop from empty queue should return 0");
+    event.release();
+}
+
+void test_LockFreeEventQueue_policy_reject() {
+    MockLogger logger;
+    LockFreeEventQueue queue(2, logger, LockFreeEventQueue::WritePolicy::Reject);
+    size_t dropped = 0;
+    queue.setDropCallback([&dropped](size_t count) { dropped += count; });
+    TestEvent event(0);
+    assert(queue.write(event) && queue.write(event) && "Writes should succeed until full");
+    assert(!queue.write(event) && "Write to full queue should be rejected");
+    assert(dropped == 1 && "Rejected event should be reported as dropped");
+    assert(queue.available() == 2 && "Rejected write should keep the queue");
+}
+
+void test_LockFreeEventQueue_pushBatch() {
+    MockLogger logger;
+    LockFreeEventQueue queue(2, logger, LockFreeEventQueue::WritePolicy::Reject);
+    TestEvent events[3] = { TestEvent(1), TestEvent(2), TestEvent(3) };
+    Event* batch[3] = { &events[0], &events[1], &events[2] };
+    for (Event* event: batch) event->hold();
+    assert(queue.pushBatch(batch, 3) == 2 && "Batch should fill the queue");
+    assert(!events[2].isHolded() && "Rejected event of a batch should be released");
+    Event* popped = nullptr;
+    for (int i = 1; i <= 2; i++) {
+        assert(queue.pop(popped, false, 0) == 1 && ((TestEvent*)popped)->value == i && "Batch should be queued in order");
+        popped->release();
+    }
+}
+
+void test_LockFreeEventQueue_policy_rotate() {
+    MockLogger logger;
+    LockFreeEventQueue queue(2, logger, LockFreeEventQueue::WritePolicy::Rotate);
+    size_t dropped = 0;
+    queue.setDropCallback([&dropped](size_t count) { dropped += count; });
+    for (int i = 0; i < 5; i++) {
+        TestEvent event(i);
+        assert(queue.write(event) && "Write should succeed with Rotate policy");
+    }
+    assert(dropped == 3 && "Rotated out events should be reported");
+    assert(logger.hasMessageContaining("Dropped 1 event(s) due to full queue") && "Drop should be logged");
+    TestEvent readEvent(0);
+    queue.read(readEvent, false, 0);
+    assert(readEvent.value == 3 && "Oldest remaining event should be read first");
+}
+
+void test_LockFreeEventQueue_policy_reset() {
+    MockLogger logger;
+    LockFreeEventQueue queue(4, logger, LockFreeEventQueue::WritePolicy::Reset);
+    size_t dropped = 0;
+    queue.setDropCallback([&dropped](size_t count) { dropped += count; });
+    for (int i = 0; i < 5; i++) {
+        TestEvent event(i);
+        queue.write(event);
+    }
+    assert(dropped == 4 && "Reset should drop every unread event");
+    assert(queue.available() == 1 && "Only the new event should remain after reset");
+}
+
+void test_LockFreeEventQueue_read_blocking_timeout() {
+    MockLogger logger;
+    LockFreeEventQueue queue(4, logger);
+    auto start = chrono::steady_clock::now();
+    TestEvent readEvent(0);
+    size_t readCount = queue.read(readEvent, true, 100);
+    auto durationMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    assert(readCount == 0 && "Blocking read should return 0 with no data");
+    assert(durationMs >= 100 && "Blocking read should wait for the timeout");
+}
+
+void test_LockFreeEventQueue_read_blocking_wakeup() {
+    MockLogger logger;
+    LockFreeEventQueue queue(4, logger);
+    thread writer([&queue]() {
+        sleep_ms(50);
+        TestEvent event(99);
+        queue.write(event);
+    });
+    TestEvent readEvent(0);
+    size_t readCount = queue.read(readEvent, true, 5000);
+    writer.join();
+    assert(readCount == 1 && "Blocking read should be woken up by a write");
+    assert(readEvent.value == 99 && "Read event should match written event");
+}
+
+void test_LockFreeEventQueue_concurrent_mpmc() {
+    MockLogger logger;
+    LockFreeEventQueue queue(64, logger, LockFreeEventQueue::WritePolicy::Reject);
+    const int numProducers = 4;
+    const int numConsumers = 4;
+    const int eventsPerProducer = 2000;
+    atomic<long long> sum = 0;
+    atomic<int> received = 0;
+    vector<thread> threads;
+    for (int p = 0; p < numProducers; p++) {
+        threads.emplace_back([&queue, p]() {
+            for (int i = 0; i < eventsPerProducer; i++) {
+                TestEvent event(p * eventsPerProducer + i);
+                while (!queue.write(event)) this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < numConsumers; c++) {
+        threads.emplace_back([&]() {
+            while (received < numProducers * eventsPerProducer) {
+                EventHandle handle;
+                if (!queue.read(handle, true, 10)) continue;
+                sum += handle.as<TestEvent>()->value;
+                received++;
+            }
+        });
+    }
+    for (thread& t: threads) t.join();
+    long long total = numProducers * eventsPerProducer;
+    assert(received == total && "Every event should be received exactly once");
+    assert(sum == total * (total - 1) / 2 && "Every event should be received exactly once");
+}
+
+TEST(test_LockFreeEventQueue_write_read_keeps_payload);
+TEST(test_LockFreeEventQueue_capacity_rounded_up);
+TEST(test_LockFreeEventQueue_push_pop_reference);
+TEST(test_LockFreeEventQueue_policy_reject);
+TEST(test_LockFreeEventQueue_policy_rotate);
+TEST(test_LockFreeEventQueue_policy_reset);
+TEST(test_LockFreeEventQueue_read_blocking_timeout);
+TEST(test_LockFreeEventQueue_read_blocking_wakeup);
+TEST(test_LockFreeEventQueue_concurrent_mpmc);
+TEST(test_LockFreeEventQueue_pushBatch);
+
+#endif
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <new>
+#include <deque>
+#include <mutex>
 #include <memory>
+#include <vector>
+#include <chrono>
+#include <unordered_map>
+#include <condition_variable>
 
 #include "../utils/Logger.hpp"
-#include "../utils/RingBuffer.hpp"
 
 #include "EventQueue.hpp"
 
@@ -13,50 +19,391 @@ using namespace tools::utils;
 namespace tools::events {
     
     /**
-     * Implementation of EventQueue using RingBuffer
+     * Implementation of EventQueue as a ring of priority lanes
+     *
+     * Events are stored by value in type-erased slots: small events are
+     * constructed in the slot itself, bigger ones in pooled heap blocks, so
+     * the derived payload is kept (no slicing). The lanes only pass slot
+     * pointers around and slots are recycled, readers can take the stored
+     * event without copy through pop() or read(EventHandle&).
+     * Outstanding handles must not outlive the queue.
+     *
+     * Readers get the oldest event of the highest priority lane, so control
+     * events never wait behind bulk traffic. Events past their deadline (or
+     * the queue expiry) are dropped instead of delivered. When the queue is
+     * full the expired events go first, then the oldest of the lowest
+     * priority lane, an incoming event is rejected only if everything queued
+     * has higher priority.
      */
     class RingBufferEventQueue : public EventQueue {
     public:
+        // Events up to this size are stored in the slot without heap allocation
+        static const size_t slotInlineSize = 192;
+
+        static constexpr chrono::milliseconds noExpiry = chrono::milliseconds::max();
+
         RingBufferEventQueue(
             size_t capacity, 
-            Logger& logger
-             // TODO: add expiry default NEVER, and remove expired evens periodically or when the buffer is full!!!
+            Logger& logger,
+            chrono::milliseconds expiry = noExpiry // max time an event waits in the queue
         ):
-            ringBuffer(capacity, RingBuffer<Event>::WritePolicy::Rotate),
+            capacity(capacity),
+            expiry(expiry),
             logger(logger)
         {
-            ringBuffer.set_drop_callback([this, &logger](size_t count) {
-                logger.warn("Dropped " + to_string(count) + " event(s) due to full queue");
-                if (dropCallback) dropCallback(count);
-            });
+            if (capacity < 1) throw ERROR("Capacity must be at least 1");
+            grow(capacity);
         }
 
+        virtual ~RingBufferEventQueue() {
+            for (deque<Slot*>& lane: lanes)
+                for (Slot* slot: lane) discard(slot);
+            for (auto& block: heapBlocks)
+                for (void* storage: block.second) deallocate(storage);
+        }
+
+        using EventQueue::read;
+
+        // Copies the event into the queue
         bool write(Event& event) override {
-            return ringBuffer.write(&event, 1);
+            Slot* slot = acquire();
+            store(slot, event, false);
+            return enqueue(slot);
+        }
+
+        // Moves the event into the queue
+        bool write(Event&& event) {
+            Slot* slot = acquire();
+            store(slot, event, true);
+            return enqueue(slot);
+        }
+
+        // Constructs the event right in the queue
+        template<typename EventType, typename... Args>
+        bool emplace(Args&&... args) {
+            static_assert(is_base_of<Event, EventType>::value, "EventType must be derived from Event");
+            Slot* slot = acquire();
+            void* storage = allocate(slot, sizeof(EventType), alignof(EventType));
+            try {
+                slot->event = new (storage) EventType(forward<Args>(args)...);
+            } catch (...) {
+                giveBack(slot);
+                throw;
+            }
+            return enqueue(slot);
         }
 
+        // Assigns the next event to the given one (the payload as well if the types match)
         size_t read(Event& event, bool blocking, int timeoutMs) override {
-            return ringBuffer.read(&event, 1, blocking, timeoutMs);
+            Slot* slot = dequeue(blocking, timeoutMs);
+            if (!slot) return 0;
+            slot->event->assignTo(event);
+            discard(slot);
+            return 1;
         }
 
-        size_t available() const override {
-            return ringBuffer.available();
+        // Pushed events are queued by reference, the queue keeps the caller's hold
+        // (and releases it if the event gets dropped later, a rejected push keeps it)
+        bool push(Event* event) override {
+            NULLCHK(event);
+            Slot* slot = acquire();
+            slot->event = event;
+            slot->external = true;
+            return enqueue(slot);
         }
 
-        using DropCallback = function<void(size_t)>;
+        // Takes the queue lock once for the whole batch
+        size_t pushBatch(Event* const* events, size_t count) override {
+            for (size_t i = 0; i < count; i++) NULLCHK(events[i]);
+            vector<Slot*> slots(count);
+            {
+                lock_guard<mutex> lock(poolMutex);
+                for (size_t i = 0; i < count; i++) {
+                    if (freeSlots.empty()) grow(capacity);
+                    slots[i] = freeSlots.back();
+                    freeSlots.pop_back();
+                    slots[i]->event = events[i];
+                    slots[i]->external = true;
+                }
+            }
+            return enqueue(slots.data(), count, true);
+        }
 
-        void setDropCallback(DropCallback callback) {
-            dropCallback = callback;
+        size_t pop(Event*& event, bool blocking, int timeoutMs) override {
+            Slot* slot = dequeue(blocking, timeoutMs);
+            if (!slot) return 0;
+            event = slot->event;
+            if (slot->external) {
+                giveBack(slot);
+                return 1;
+            }
+            // the slot is recycled when the reader releases the event
+            event->recycler = &RingBufferEventQueue::recycle;
+            event->owner = slot;
+            event->hold();
+            return 1;
         }
 
-        size_t getCapacity() const {
-            return ringBuffer.getCapacity();
+        size_t available() const override {
+            lock_guard<mutex> lock(queueMutex);
+            return queued;
+        }
+
+        // Drops the expired events now (they are dropped on the way anyway), returns the count
+        size_t purgeExpired() {
+            vector<Slot*> expired;
+            {
+                lock_guard<mutex> lock(queueMutex);
+                takeExpired(chrono::steady_clock::now(), expired);
+            }
+            for (Slot* stale: expired) discard(stale);
+            if (!expired.empty()) reportDrop(DropReason::Expired, expired.size());
+            return expired.size();
+        }
+
+        size_t getCapacity() const override {
+            return capacity;
         }
 
     private:
-        RingBuffer<Event> ringBuffer;
+
+        struct Slot {
+            alignas(max_align_t) unsigned char storage[slotInlineSize];
+            RingBufferEventQueue* queue = nullptr;
+            Event* event = nullptr;
+            void* heap = nullptr; // heap block if the event doesn't fit in the storage
+            size_t heapSize = 0;
+            bool external = false; // pushed event, only referenced by the slot
+            size_t lane = 0;
+            chrono::steady_clock::time_point deadline;
+        };
+
+        void grow(size_t count) {
+            unique_ptr<Slot[]> chunk = make_unique<Slot[]>(count);
+            for (size_t i = 0; i < count; i++) {
+                chunk[i].queue = this;
+                freeSlots.push_back(&chunk[i]);
+            }
+            slotChunks.push_back(move(chunk));
+        }
+
+        Slot* acquire() {
+            lock_guard<mutex> lock(poolMutex);
+            if (freeSlots.empty()) grow(capacity); // readers still hold slots
+            Slot* slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+
+        // Storage for an event of the given size in the slot (or in a pooled heap block)
+        void* allocate(Slot* slot, size_t size, size_t alignment) {
+            if (alignment > alignof(max_align_t))
+                throw ERROR("Over-aligned events are not supported: " + to_string(alignment));
+            if (size <= slotInlineSize) return slot->storage;
+            size_t blockSize = slotInlineSize;
+            while (blockSize < size) blockSize <<= 1;
+            slot->heapSize = blockSize;
+            {
+                lock_guard<mutex> lock(poolMutex);
+                vector<void*>& blocks = heapBlocks[blockSize];
+                if (!blocks.empty()) {
+                    slot->heap = blocks.back();
+                    blocks.pop_back();
+                    return slot->heap;
+                }
+            }
+            slot->heap = ::operator new(blockSize, align_val_t(alignof(max_align_t)));
+            return slot->heap;
+        }
+
+        static void deallocate(void* storage) {
+            ::operator delete(storage, align_val_t(alignof(max_align_t)));
+        }
+
+        void store(Slot* slot, Event& event, bool moving) {
+            void* storage = allocate(slot, event.getSize(), event.getAlignment());
+            try {
+                slot->event = moving ? event.moveTo(storage) : event.copyTo(storage);
+            } catch (...) {
+                giveBack(slot);
+                throw;
+            }
+        }
+
+        bool enqueue(Slot* slot) {
+            return enqueue(&slot, 1, false) == 1;
+        }
+
+        // Queues the slots in order, each in its lane, and makes room when the queue
+        // is full (see the class notes). Returns the number queued, the refused pushed
+        // events are released if releaseRefused, else they are left with the caller.
+        size_t enqueue(Slot* const* slots, size_t count, bool releaseRefused) {
+            chrono::steady_clock::time_point now = chrono::steady_clock::now();
+            for (size_t i = 0; i < count; i++) {
+                Slot* slot = slots[i];
+                slot->lane = min((size_t)slot->event->priority, eventPriorityCount - 1);
+                slot->deadline = slot->event->deadline;
+                if (expiry != noExpiry && now + expiry < slot->deadline) slot->deadline = now + expiry;
+            }
+
+            Drops drops;
+            size_t accepted = 0;
+            {
+                lock_guard<mutex> lock(queueMutex);
+                for (size_t i = 0; i < count; i++)
+                    if (insert(slots[i], now, drops)) accepted++;
+            }
+            if (accepted > 1) readable.notify_all();
+            else if (accepted) readable.notify_one();
+
+            for (size_t reason = 0; reason < dropReasonCount; reason++) {
+                for (Slot* slot: drops.queued[reason]) discard(slot);
+                for (Slot* slot: drops.refused[reason]) {
+                    if (releaseRefused) discard(slot);
+                    else reject(slot);
+                }
+                size_t dropped = drops.queued[reason].size() + drops.refused[reason].size();
+                if (dropped) reportDrop((DropReason)reason, dropped);
+            }
+            return accepted;
+        }
+
+        // Slots dropped by enqueue(), by reason
+        struct Drops {
+            vector<Slot*> queued[dropReasonCount];  // taken out of the lanes
+            vector<Slot*> refused[dropReasonCount]; // never got in
+        };
+
+        // Caller holds queueMutex
+        bool insert(Slot* slot, chrono::steady_clock::time_point now, Drops& drops) {
+            if (slot->deadline <= now) {
+                drops.refused[(size_t)DropReason::Expired].push_back(slot);
+                return false;
+            }
+            if (queued >= capacity) takeExpired(now, drops.queued[(size_t)DropReason::Expired]);
+            if (queued >= capacity) {
+                size_t lane = eventPriorityCount - 1;
+                while (lanes[lane].empty()) lane--; // queued > 0, one of them has events
+                if (lane < slot->lane) {
+                    drops.refused[(size_t)DropReason::Rejected].push_back(slot);
+                    return false;
+                }
+                DropReason reason = lane == slot->lane ? DropReason::Overflow : DropReason::Evicted;
+                drops.queued[(size_t)reason].push_back(lanes[lane].front());
+                lanes[lane].pop_front();
+                queued--;
+            }
+            lanes[slot->lane].push_back(slot);
+            queued++;
+            return true;
+        }
+
+        // Takes the oldest event of the highest priority lane, drops the expired ones on the way
+        Slot* dequeue(bool blocking, int timeoutMs) {
+            vector<Slot*> expired;
+            Slot* slot = nullptr;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                chrono::steady_clock::time_point until = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+                while (true) {
+                    slot = takeNext(chrono::steady_clock::now(), expired);
+                    if (slot || !blocking) break;
+                    if (readable.wait_until(lock, until) == cv_status::timeout) {
+                        slot = takeNext(chrono::steady_clock::now(), expired);
+                        break;
+                    }
+                }
+            }
+            for (Slot* stale: expired) discard(stale);
+            if (!expired.empty()) reportDrop(DropReason::Expired, expired.size());
+            return slot;
+        }
+
+        // Caller holds queueMutex
+        Slot* takeNext(chrono::steady_clock::time_point now, vector<Slot*>& expired) {
+            for (deque<Slot*>& lane: lanes) {
+                while (!lane.empty()) {
+                    Slot* slot = lane.front();
+                    lane.pop_front();
+                    queued--;
+                    if (slot->deadline > now) return slot;
+                    expired.push_back(slot);
+                }
+            }
+            return nullptr;
+        }
+
+        // Caller holds queueMutex
+        void takeExpired(chrono::steady_clock::time_point now, vector<Slot*>& expired) {
+            for (deque<Slot*>& lane: lanes) {
+                size_t kept = 0;
+                for (Slot* slot: lane) {
+                    if (slot->deadline > now) lane[kept++] = slot;
+                    else expired.push_back(slot);
+                }
+                queued -= lane.size() - kept;
+                lane.resize(kept);
+            }
+        }
+
+        // Destroys (or releases) a queued event and recycles its slot
+        void discard(Slot* slot) {
+            if (slot->external) slot->event->release();
+            else slot->event->~Event();
+            giveBack(slot);
+        }
+
+        // Gives back a slot that never got queued, a pushed event stays with the caller
+        void reject(Slot* slot) {
+            if (slot->external) giveBack(slot);
+            else discard(slot);
+        }
+
+        static void recycle(Event* event) {
+            Slot* slot = (Slot*)event->owner;
+            event->~Event();
+            slot->queue->giveBack(slot);
+        }
+
+        void giveBack(Slot* slot) {
+            lock_guard<mutex> lock(poolMutex);
+            if (slot->heap) heapBlocks[slot->heapSize].push_back(slot->heap);
+            slot->event = nullptr;
+            slot->heap = nullptr;
+            slot->heapSize = 0;
+            slot->external = false;
+            freeSlots.push_back(slot);
+        }
+
+        void reportDrop(DropReason reason, size_t count) {
+            switch (reason) {
+                case DropReason::Expired:
+                    logger.debug("Dropped " + to_string(count) + " expired event(s)");
+                    break;
+                case DropReason::Overflow:
+                    logger.warn("Dropped " + to_string(count) + " event(s) due to full queue");
+                    break;
+                case DropReason::Evicted:
+                    logger.warn("Dropped " + to_string(count) + " lower priority event(s) due to full queue");
+                    break;
+                case DropReason::Rejected:
+                    logger.warn("Rejected " + to_string(count) + " event(s), the queue is full of higher priority events");
+                    break;
+            }
+            notifyDrop(count, reason);
+        }
+
+        size_t capacity;
+        chrono::milliseconds expiry;
+        deque<Slot*> lanes[eventPriorityCount];
+        size_t queued = 0; // events in all the lanes
+        mutable mutex queueMutex;
+        condition_variable readable;
+        mutex poolMutex;
+        vector<unique_ptr<Slot[]>> slotChunks;
+        vector<Slot*> freeSlots;
+        unordered_map<size_t, vector<void*>> heapBlocks; // pooled heap storage by block size
         Logger& logger;
-        DropCallback dropCallback;
     };    
 
 }
@@ -65,6 +412,7 @@ namespace tools::events {
 
 #include "../utils/Test.hpp"
 #include "../utils/tests/MockLogger.hpp"
+#include "../utils/system.hpp"
 #include "tests/TestEvent.hpp"
 
 // Test basic write operation
@@ -252,7 +600,223 @@ void test_RingBufferEventQueue_read_write_concurrent() {
     assert(readCount <= writeCount && "Reads should not exceed writes");
     assert(readCount <= numReads && "Reads should not exceed requested number");
     size_t finalAvailable = queue.available();
-    assert(finalAvailable == (writeCount - readCount) && "Remaining events should match writes minus reads");
+    assert(finalAvailable == (size_t)(writeCount - readCount) && "Remaining events should match writes minus reads");
+}
+
+// Test reading through a handle gives the stored event itself (no slicing, no copy)
+void test_RingBufferEventQueue_read_handle() {
+    MockLogger logger;
+    RingBufferEventQueue queue(3, logger);
+    TestEvent event(7);
+    event.sourceId = "source";
+    queue.write(event);
+
+    EventHandle handle;
+    size_t readCount = queue.read(handle, false, 0);
+    assert(readCount == 1 && "Read should return 1 event");
+    TestEvent* readEvent = handle.as<TestEvent>();
+    assert(readEvent != nullptr && "Handle should keep the derived type");
+    assert(readEvent->value == 7 && "Handle should hold the written payload");
+    assert(readEvent->sourceId == "source" && "Handle should hold the base fields");
+    assert(queue.available() == 0 && "Queue should be empty after read");
+}
+
+// Test emplacing an event directly into the queue
+void test_RingBufferEventQueue_emplace() {
+    MockLogger logger;
+    RingBufferEventQueue queue(3, logger);
+    bool success = queue.emplace<TestEvent>(11);
+    assert(success && "Emplace should succeed");
+    TestEvent readEvent(0);
+    queue.read(readEvent, false, 0);
+    assert(readEvent.value == 11 && "Emplaced event should be read back");
+}
+
+class LargeTestEvent : public TypedEvent<LargeTestEvent> {
+public:
+    LargeTestEvent(char fill, string text = ""): text(text) {
+        for (char& c: payload) c = fill;
+    }
+    char payload[1024];
+    string text;
+};
+
+// Test events bigger than a slot go to (pooled) heap storage
+void test_RingBufferEventQueue_large_event_heap_storage() {
+    MockLogger logger;
+    RingBufferEventQueue queue(2, logger);
+    for (int round = 0; round < 3; round++) {
+        LargeTestEvent event('a' + round, "moved text");
+        queue.write(move(event));
+        assert(event.text.empty() && "Written rvalue event should be moved from");
+        EventHandle handle;
+        queue.read(handle, false, 0);
+        LargeTestEvent* readEvent = handle.as<LargeTestEvent>();
+        assert(readEvent != nullptr && "Large event should keep its type");
+        assert(readEvent->payload[0] == 'a' + round && readEvent->payload[1023] == 'a' + round && "Large payload should be intact");
+        assert(readEvent->text == "moved text" && "Moved payload should arrive");
+    }
+}
+
+// Test pushed events are passed by reference and released when dropped
+void test_RingBufferEventQueue_push_pop_reference() {
+    MockLogger logger;
+    RingBufferEventQueue queue(1, logger);
+    TestEvent event1(1);
+    TestEvent event2(2);
+    event1.hold();
+    event2.hold();
+    queue.push(&event1);
+    queue.push(&event2); // rotates event1 out
+    assert(!event1.isHolded() && "Dropped pushed event should be released");
+    Event* popped = nullptr;
+    size_t readCount = queue.pop(popped, false, 0);
+    assert(readCount == 1 && popped == &event2 && "Pop should return the pushed event itself");
+    popped->release();
+    assert(!event2.isHolded() && "Reader should own the hold of the popped event");
+}
+
+// Test the drop callback is called when the oldest event is rotated out
+void test_RingBufferEventQueue_drop_callback() {
+    MockLogger logger;
+    RingBufferEventQueue queue(2, logger);
+    size_t dropped = 0;
+    queue.setDropCallback([&dropped](size_t count) { dropped += count; });
+    for (int i = 0; i < 5; i++) queue.emplace<TestEvent>(i);
+    assert(dropped == 3 && "Drop callback should report every rotated out event");
+    TestEvent readEvent(0);
+    queue.read(readEvent, false, 0);
+    assert(readEvent.value == 3 && "Oldest remaining event should be read first");
+}
+
+TestEvent makeTestEvent(int value, EventPriority priority, int ttlMs = -1) {
+    TestEvent event(value);
+    event.priority = priority;
+    if (ttlMs >= 0) event.expireAfter(chrono::milliseconds(ttlMs));
+    return event;
+}
+
+// Test higher priority lanes are read first, FIFO within a lane
+void test_RingBufferEventQueue_priority_order() {
+    MockLogger logger;
+    RingBufferEventQueue queue(5, logger);
+    queue.write(makeTestEvent(1, EventPriority::Background));
+    queue.write(makeTestEvent(2, EventPriority::Normal));
+    queue.write(makeTestEvent(3, EventPriority::Control));
+    queue.write(makeTestEvent(4, EventPriority::Normal));
+    queue.write(makeTestEvent(5, EventPriority::Control));
+    vector<int> order;
+    TestEvent readEvent(0);
+    while (queue.read(readEvent, false, 0)) order.push_back(readEvent.value);
+    assert((order == vector<int>{ 3, 5, 2, 4, 1 }) && "Events should be read by priority, then in order");
+}
+
+// Test expired events are dropped on read and reported
+void test_RingBufferEventQueue_deadline_dropped_on_read() {
+    MockLogger logger;
+    RingBufferEventQueue queue(3, logger);
+    vector<RingBufferEventQueue::DropReason> reasons;
+    queue.setDropCallback([&reasons](size_t count, RingBufferEventQueue::DropReason reason) {
+        for (size_t i = 0; i < count; i++) reasons.push_back(reason);
+    });
+    queue.write(makeTestEvent(1, EventPriority::Normal, 20));
+    queue.write(makeTestEvent(2, EventPriority::Normal));
+    sleep_ms(40);
+    TestEvent readEvent(0);
+    size_t readCount = queue.read(readEvent, false, 0);
+    assert(readCount == 1 && readEvent.value == 2 && "Expired event should be skipped");
+    assert(reasons.size() == 1 && reasons[0] == RingBufferEventQueue::DropReason::Expired && "Expired drop should be reported");
+    assert(!queue.write(makeTestEvent(3, EventPriority::Normal, 0)) && "Already expired event should not be queued");
+    assert(queue.available() == 0 && "Queue should be empty");
+}
+
+// Test the queue expiry applies to events without a deadline
+void test_RingBufferEventQueue_queue_expiry() {
+    MockLogger logger;
+    RingBufferEventQueue queue(3, logger, chrono::milliseconds(20));
+    queue.write(makeTestEvent(1, EventPriority::Normal));
+    queue.write(makeTestEvent(2, EventPriority::Normal));
+    sleep_ms(40);
+    assert(queue.purgeExpired() == 2 && "Purge should drop the events older than the expiry");
+    assert(queue.available() == 0 && "Queue should be empty after purge");
+}
+
+// Test a full queue drops expired events first, then the lowest priority ones
+void test_RingBufferEventQueue_full_drops_expired_then_lowest_priority() {
+    MockLogger logger;
+    RingBufferEventQueue queue(3, logger);
+    size_t drops[RingBufferEventQueue::dropReasonCount] = {};
+    queue.setDropCallback([&drops](size_t count, RingBufferEventQueue::DropReason reason) {
+        drops[(size_t)reason] += count;
+    });
+    queue.write(makeTestEvent(1, EventPriority::Normal, 20));
+    queue.write(makeTestEvent(2, EventPriority::Background));
+    queue.write(makeTestEvent(3, EventPriority::Normal));
+    sleep_ms(40);
+    queue.write(makeTestEvent(4, EventPriority::Background)); // takes the expired one's place
+    assert(drops[(size_t)RingBufferEventQueue::DropReason::Expired] == 1 && "Expired event should go first");
+    queue.write(makeTestEvent(5, EventPriority::Control)); // evicts the oldest background event
+    assert(drops[(size_t)RingBufferEventQueue::DropReason::Evicted] == 1 && "Lowest priority event should be evicted");
+    assert(logger.hasMessageContaining("lower priority event(s)") && "Eviction should be logged");
+
+    vector<int> order;
+    TestEvent readEvent(0);
+    while (queue.read(readEvent, false, 0)) order.push_back(readEvent.value);
+    assert((order == vector<int>{ 5, 3, 4 }) && "Remaining events should be read by priority");
+}
+
+// Test a queue full of higher priority events rejects a lower priority one
+void test_RingBufferEventQueue_full_rejects_lower_priority() {
+    MockLogger logger;
+    RingBufferEventQueue queue(2, logger);
+    size_t rejected = 0;
+    queue.setDropCallback([&rejected](size_t count, RingBufferEventQueue::DropReason reason) {
+        if (reason == RingBufferEventQueue::DropReason::Rejected) rejected += count;
+    });
+    queue.write(makeTestEvent(1, EventPriority::Control));
+    queue.write(makeTestEvent(2, EventPriority::Control));
+    TestEvent chunk = makeTestEvent(3, EventPriority::Background);
+    chunk.hold();
+    assert(!queue.push(&chunk) && "Lower priority event should be rejected");
+    assert(rejected == 1 && "Rejection should be reported");
+    assert(chunk.isHolded() && "Rejected push should leave the hold with the caller");
+    chunk.release();
+    assert(queue.available() == 2 && "Queued control events should be kept");
+}
+
+// Test a control event is not held up by a burst of stale chunks
+void test_RingBufferEventQueue_control_ahead_of_burst() {
+    MockLogger logger;
+    RingBufferEventQueue queue(8, logger);
+    for (int i = 0; i < 20; i++) queue.write(makeTestEvent(i, EventPriority::Background, 10));
+    queue.write(makeTestEvent(100, EventPriority::Control));
+    TestEvent readEvent(0);
+    queue.read(readEvent, false, 0);
+    assert(readEvent.value == 100 && "Control event should be read first");
+    sleep_ms(20);
+    assert(queue.read(readEvent, false, 0) == 0 && "Stale chunks should not be delivered");
+}
+
+// Test a pushed batch is queued in order and the refused events are released
+void test_RingBufferEventQueue_pushBatch() {
+    MockLogger logger;
+    RingBufferEventQueue queue(3, logger);
+    queue.write(makeTestEvent(0, EventPriority::Control));
+    queue.write(makeTestEvent(0, EventPriority::Control));
+    TestEvent events[3] = { makeTestEvent(1, EventPriority::Normal), makeTestEvent(2, EventPriority::Background), makeTestEvent(3, EventPriority::Normal) };
+    Event* batch[3] = { &events[0], &events[1], &events[2] };
+    for (Event* event: batch) event->hold();
+    size_t pushed = queue.pushBatch(batch, 3);
+    assert(pushed == 2 && "Background event should be refused by the full queue");
+    assert(!events[1].isHolded() && "Refused event of a batch should be released");
+    Event* popped = nullptr;
+    vector<int> order;
+    while (queue.pop(popped, false, 0)) {
+        order.push_back(((TestEvent*)popped)->value);
+        popped->release();
+    }
+    assert((order == vector<int>{ 0, 0, 3 }) && "Newer normal event should rotate out the older one");
+    assert(!events[0].isHolded() && !events[2].isHolded() && "Every hold should be released");
 }
 
 // Register tests
@@ -266,6 +830,18 @@ TEST(test_RingBufferEventQueue_read_blocking_success);
 TEST(test_RingBufferEventQueue_constructor_invalid_capacity);
 TEST(test_RingBufferEventQueue_write_concurrent);
 TEST(test_RingBufferEventQueue_read_write_concurrent);
+TEST(test_RingBufferEventQueue_read_handle);
+TEST(test_RingBufferEventQueue_emplace);
+TEST(test_RingBufferEventQueue_large_event_heap_storage);
+TEST(test_RingBufferEventQueue_push_pop_reference);
+TEST(test_RingBufferEventQueue_drop_callback);
+TEST(test_RingBufferEventQueue_priority_order);
+TEST(test_RingBufferEventQueue_deadline_dropped_on_read);
+TEST(test_RingBufferEventQueue_queue_expiry);
+TEST(test_RingBufferEventQueue_full_drops_expired_then_lowest_priority);
+TEST(test_RingBufferEventQueue_full_rejects_lower_priority);
+TEST(test_RingBufferEventQueue_control_ahead_of_burst);
+TEST(test_RingBufferEventQueue_pushBatch);
 #endif
 
 /* TODO:
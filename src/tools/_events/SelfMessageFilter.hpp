@@ -122,19 +122,18 @@ void test_SelfMessageFilter_shouldDeliverEvent_sync_delivery() {
 
     protected:
 
-        // void deliverEventInternal(Event& event) override {
-        function<void(EventBus*, Event&)> deliverEventInternal = [](EventBus* that, Event& event) {
-            unique_lock<shared_mutex> lock(that->m_mutex);
-            auto typeIt = that->m_eventInterests.find(event.getType());
-            if (typeIt != that->m_eventInterests.end()) {
+        void deliverEventInternal(Event& event) override {
+            unique_lock<shared_mutex> lock(m_mutex);
+            auto typeIt = m_eventInterests.find(event.getTypeId());
+            if (typeIt != m_eventInterests.end()) {
                 for (const ComponentId& consumerId : typeIt->second) {
-                    auto consumerIt = that->m_consumers.find(consumerId);
-                    if (consumerIt != that->m_consumers.end() && ((FilteredEventBusWrapper*)that)->m_filter.shouldDeliverEvent(consumerId, event)) {
+                    auto consumerIt = m_consumers.find(consumerId);
+                    if (consumerIt != m_consumers.end() && m_filter.shouldDeliverEvent(consumerId, event)) {
                         consumerIt->second->handleEvent(event);
                     }
                 }
             }
-        };
+        }
 
     public:
         SelfMessageFilter& m_filter;
@@ -185,14 +184,14 @@ void test_SelfMessageFilter_setFilterSelfMessages_concurrent() {
     TestEvent event(42);
     event.sourceId = "agent1";
     bool shouldDeliver = filter.shouldDeliverEvent("agent1", event);
-    assert((finalState && !shouldDeliver) || (!finalState && shouldDeliver) && "Filter state should be consistent after concurrent toggling");
+    assert(((finalState && !shouldDeliver) || (!finalState && shouldDeliver)) && "Filter state should be consistent after concurrent toggling");
 }
 
 // Test interaction with multiple filters
 void test_SelfMessageFilter_shouldDeliverEvent_multiple_filters() {
     class OtherFilter : public EventFilter {
     public:
-        bool shouldDeliverEvent(const ComponentId& consumerId, Event& event) override {
+        bool shouldDeliverEvent(const ComponentId& /*consumerId*/, Event& event) override {
             return event.sourceId != "blockedSource";  // Blocks a specific source
         }
     };
@@ -219,20 +218,20 @@ void test_SelfMessageFilter_shouldDeliverEvent_multiple_filters() {
         
     protected:
 
-        function<void(EventBus*, Event&)> deliverEventInternal = [](EventBus* that, Event& event) {
-            unique_lock<shared_mutex> lock(that->m_mutex);
-            auto typeIt = that->m_eventInterests.find(event.getType());
-            if (typeIt != that->m_eventInterests.end()) {
+        void deliverEventInternal(Event& event) override {
+            unique_lock<shared_mutex> lock(m_mutex);
+            auto typeIt = m_eventInterests.find(event.getTypeId());
+            if (typeIt != m_eventInterests.end()) {
                 for (const ComponentId& consumerId : typeIt->second) {
-                    auto consumerIt = that->m_consumers.find(consumerId);
-                    if (consumerIt != that->m_consumers.end() &&
-                        ((MultiFilterBus*)that)->m_selfFilter.shouldDeliverEvent(consumerId, event) &&
-                        ((MultiFilterBus*)that)->m_otherFilter.shouldDeliverEvent(consumerId, event)) {
+                    auto consumerIt = m_consumers.find(consumerId);
+                    if (consumerIt != m_consumers.end() &&
+                        m_selfFilter.shouldDeliverEvent(consumerId, event) &&
+                        m_otherFilter.shouldDeliverEvent(consumerId, event)) {
                         consumerIt->second->handleEvent(event);
                     }
                 }
             }
-        };
+        }
 
     private:
         SelfMessageFilter& m_selfFilter;
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <type_traits>
+
+#include "../utils/ERROR.hpp"
+
 #include "Event.hpp"
 
 using namespace std;
@@ -15,6 +19,41 @@ namespace tools::events {
         type_index getType() const override {
             return type_index(typeid(T));
         }
+
+        EventTypeId getTypeId() const override {
+            return event_type_id<T>();
+        }
+
+        size_t getSize() const override {
+            return sizeof(T);
+        }
+
+        size_t getAlignment() const override {
+            return alignof(T);
+        }
+
+        Event* copyTo(void* storage) const override {
+            if constexpr (is_copy_constructible<T>::value)
+                return new (storage) T(static_cast<const T&>(*this));
+            else throw ERROR("Event is not copyable: " + string(typeid(T).name()));
+        }
+
+        Event* moveTo(void* storage) override {
+            if constexpr (is_move_constructible<T>::value)
+                return new (storage) T(move(static_cast<T&>(*this)));
+            else return copyTo(storage);
+        }
+
+        // Assigns the whole payload if the target has the same type, the base fields only otherwise
+        void assignTo(Event& target) const override {
+            if constexpr (is_copy_assignable<T>::value) {
+                if (typeid(target) == typeid(T)) {
+                    static_cast<T&>(target) = static_cast<const T&>(*this);
+                    return;
+                }
+            }
+            Event::assignTo(target);
+        }
     };
 
 }
@@ -3,14 +3,22 @@
 #include "BaseEventAgent.hpp"
 #include "BaseEventConsumer.hpp"
 #include "BaseEventProducer.hpp"
+#include "ComponentId.hpp"
 #include "Event.hpp"
 #include "EventAgent.hpp"
 #include "EventBus.hpp"
+#include "EventBusMetrics.hpp"
+#include "EventCodecs.hpp"
 #include "EventConsumer.hpp"
 #include "EventFilter.hpp"
+#include "EventHandle.hpp"
+#include "EventHandlers.hpp"
+#include "EventPool.hpp"
 #include "EventProducer.hpp"
 #include "EventQueue.hpp"
 #include "FilteredEventBus.hpp"
+#include "LockFreeEventQueue.hpp"
 #include "RingBufferEventQueue.hpp"
 #include "SelfMessageFilter.hpp"
+#include "SharedMemoryEventQueue.hpp"
 #include "TypedEvent.hpp"
\ No newline at end of file
@@ -18,6 +18,7 @@ public:
     using Callback = function<void(Event&)>;
 
     void handleEvent(Event& event) override {
+        event.hold(); // keeps the event alive (out of the pool) for the assertions
         receivedEvents.push_back(&event);
         if (callback) {
             callback(event); // Invoke callback if set
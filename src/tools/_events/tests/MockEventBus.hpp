@@ -23,12 +23,11 @@ public:
 
 protected:
 
-    // Override the new virtual function
-    function<void(EventBus*, Event&)> deliverEventInternal = [](EventBus* that, Event& event) {
-        ((MockEventBus*)that)->publishedEvents.push_back(&event);
+    void deliverEventInternal(Event& event) override {
+        publishedEvents.push_back(&event);
         // Simulate immediate handling
-        for (EventConsumer* consumer: ((MockEventBus*)that)->consumers) consumer->handleEvent(event);
-    };
+        for (EventConsumer* consumer: consumers) consumer->handleEvent(event);
+    }
 
 private:
     vector<EventProducer*> producers;
@@ -18,6 +18,7 @@ public:
 protected:
     void registerEventInterests() override {
         registerHandler<TestEvent>([this](TestEvent& event) {
+            event.hold(); // keeps the event alive (out of the pool) for the assertions
             receivedEvents.push_back(&event);
         });
     }
@@ -1,13 +1,12 @@
 
 #pragma once
 
-#include "../Event.hpp"
+#include "../TypedEvent.hpp"
 
 using namespace tools::events;
 
-class TestEvent : public Event {
+class TestEvent : public TypedEvent<TestEvent> {
 public:
-    type_index getType() const override { return type_index(typeid(TestEvent)); }
     int value;
     TestEvent(int v) : value(v) {}
 };
\ No newline at end of file
@@ -9,7 +9,7 @@ namespace tools::abstracts {
     class Closable {
     public:
         virtual ~Closable() { if (!isClosing()) close(); }
-        void close() { closing = true; }
+        virtual void close() { closing = true; }
         bool isClosing() const { return closing; }        
     protected:
         atomic<bool> closing = false;
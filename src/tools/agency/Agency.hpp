@@ -1,23 +1,38 @@
 #pragma once
 
 #include "../containers/array_key_exists.hpp"
+#include "../utils/Tracer.hpp"
 // #include "../utils/Streamable.hpp"
 // #include "chat/Chatbot.hpp"
 // // #include "chat/Talkbot.hpp"
 
 #include "Worker.hpp"
+#include "WorkerRegistry.hpp"
+#include "Scheduler.hpp"
+#include "Backpressure.hpp"
+#include "Checkpointer.hpp"
+#include "remote/RemoteWorker.hpp"
+#include "remote/Nodes.hpp"
 // #include "PackQueue.hpp"
 #include "AgentRoleMap.hpp"
 
 using namespace tools::utils;
+using namespace tools::agency::remote;
 // using namespace tools::agency;
 // using namespace tools::agency::chat;
 
 namespace tools::agency {
 
+    /**
+     * Routes the packs of the queue into the mailboxes of its workers.
+     * The workers run on the Scheduler, the send()s are held back by the
+     * Backpressure, the Checkpointer saves them and the Nodes link them
+     * to the other agency processes.
+     */
     template<typename T>
     class Agency: public Worker<T> {
         static_assert(Streamable<T>, "T must support ostream output for dump()");
+        friend class remote::Nodes<T>;
     public:
 
         static const string worker_list_tpl;
@@ -30,15 +45,23 @@ namespace tools::agency {
         ):
             Worker<T>(owns, nullptr, queue, name),
             owns(owns),
-            roles(roles)
+            roles(roles),
+            scheduler(workers_mtx, [this](const string& errmsg) { this->hoops(errmsg); }),
+            backpressure(workers, workers_mtx, scheduler, *this),
+            checkpointer(*this, workers, workers_mtx, [this](const string& errmsg) { this->hoops(errmsg); }),
+            nodes(*this)
         {}
 
         virtual ~Agency() {
+            record("");
+            listen("");
+            disconnect(); // the links call back into the agency
+            setAutosave("", 0);
+            this->stop();
+            setThreads(0); // the pool finishes the queued runs first
             lock_guard<mutex> lock(workers_mtx);
-            for (Worker<T>* worker : workers) {
+            for (Worker<T>* worker : workers.all())
                 owns.release(this, worker); // delete worker
-                worker = nullptr;
-            }
             workers.clear();
         }
 
@@ -51,81 +74,203 @@ namespace tools::agency {
         void handle(const string& sender, const T& item) override {
 
             // TODO: these are deprecated: (commands and workers has/can have access to the agency so they can do it by themself)
-            if (item == "exit") {
-                cout << "Exit indicated by worker '" + sender + "'..." << endl;
+            optional<Control> control = control_of(item); // see Message
+            if (!control) return;
+            switch (*control) {
+                case Control::Exit:
+                    cout << "Exit indicated by worker '" + sender + "'..." << endl;
 
-                // closing workers and the agency itself
-                for (Worker<T>* worker: workers) worker->close();
-                this->close();
+                    // closing workers and the agency itself
+                    for (Worker<T>* worker: workers.all()) worker->close();
+                    this->close();
 
-                // swallowing packages from queue (TODO: perhaps we want to proceed all - with a timeout - before close)
-                while (this->queue.Consume(pack));
-            }
+                    // swallowing packages from queue (TODO: perhaps we want to proceed all - with a timeout - before close)
+                    while (this->queue.Consume(pack));
+                    break;
 
-            if (item == "list") {
-                cout << "Workers in the agency:" << endl;
-                for (Worker<T>* worker: workers) cout << worker->getName() << endl;
+                case Control::List:
+                    cout << "Workers in the agency:" << endl;
+                    for (Worker<T>* worker: workers.all()) cout << worker->getName() << endl;
+                    break;
             }
         }
         
         template<typename WorkerT, typename... Args>
         WorkerT& spawn(Args&&... args) { // TODO: forward Args
-            lock_guard<mutex> lock(workers_mtx);
-            // WorkerT* worker = new WorkerT(forward<Args>(args)...); // Direct construction
-            WorkerT* worker = owns.allocate<WorkerT>(forward<Args>(args)...);
-            owns.reserve<void>(this, worker, FILELN);
-            // WorkerT* worker = new WorkerT(/*this->queue, name, recipients,*/ forward<Args>(args)...);
-            for (const Worker<T>* a: workers)
-                if (worker->getName() == a->getName()) {
+            WorkerT* worker = nullptr;
+            string created;
+            {
+                lock_guard<mutex> lock(workers_mtx);
+                // WorkerT* worker = new WorkerT(forward<Args>(args)...); // Direct construction
+                worker = owns.allocate<WorkerT>(forward<Args>(args)...);
+                owns.reserve<void>(this, worker, FILELN);
+                // WorkerT* worker = new WorkerT(/*this->queue, name, recipients,*/ forward<Args>(args)...);
+                try {
+                    workers.add(worker);
+                } catch (exception&) {
                     owns.release(this, worker); // delete worker;
-                    throw ERROR("Worker '" + a->getName() + "' already exists.");
+                    throw;
                 }
-            workers.push_back(worker);
+                worker->getMailboxRef().setLimit(backpressure.mailboxLimit(worker->getId()));
+                created = "Worker '" + worker->getName() + "' created as '" + worker->type() + "'.";
+            }
             // worker->start();
-            this->send("Worker '" + worker->getName() + "' created as '" + worker->type() + "'.");
+            this->send(created); // unlocked, send() may wait (see admit())
+            if constexpr (!is_same_v<WorkerT, RemoteWorker<T>>)
+                nodes.announce({ FrameType::Joined, { worker->getName() } });
             return *(WorkerT*)worker;
         }
 
+        // Waits for the running handle() of the worker (if any) to return,
+        // a remote worker is killed in its node
         [[nodiscard]]
-        bool kill(const string& name) {        
-            lock_guard<mutex> lock(workers_mtx);
-            bool found = false;   
-            for (size_t i = 0; i < workers.size(); i++)
-                if (workers[i]->getName() == name) {
-                    found = true;
-                    //workers[i]->close();
-                    owns.release(this, workers[i]); // delete workers[i];
-                    workers[i] = nullptr;
-                    workers.erase(workers.begin() + i);
-                    i--;  // Back up to recheck the shifted element
-                }
-            this->queue.drop(name);
-            return found;
+        bool kill(const string& name) {
+            shared_ptr<Link> link = nodes.linkOf(name);
+            bool killed = dismiss(name); // before its Left could come back
+            if (!killed) return false;
+            if (link) link->send({ FrameType::Kill, { name } });
+            else nodes.announce({ FrameType::Left, { name } });
+            return true;
         }
-        
+
+        // Routes the queued packs into the mailboxes of the workers, the
+        // packs of the agency itself are handled here. An interactive pack
+        // preempts the lower priority handle()s running (see Worker::isPreempted())
         void tick() {
             while (this->queue.Consume(pack)) {
-                if (this->name == pack.recipient) 
+                if (this->id == pack.recipient) {
+                    TraceSpan span("pack", "handle", this->id.name().c_str(), pack.trace);
+                    if (pack.trace) Tracer::instance().flow('f', pack.trace);
                     handle(pack.sender, pack.item);
-                else {
+                    continue;
+                }
+                TraceSpan span("pack", "dequeue", pack.recipient.name().c_str(), pack.trace);
+                if (pack.trace) Tracer::instance().flow('t', pack.trace);
+                Worker<T>* inlined = nullptr;
+                {
                     lock_guard<mutex> lock(workers_mtx);
-                    for (Worker<T>* worker: workers)
-                        if (worker && worker->getName() == pack.recipient) 
-                            worker->handle(pack.sender, pack.item);    
+                    Worker<T>* worker = workers.find(pack.recipient);
+                    if (!worker) continue;
+                    if (pack.priority == Priority::Interactive)
+                        for (Worker<T>* running: workers.all()) running->preempt(Priority::Interactive);
+                    bool urgent = pack.priority == Priority::Interactive;
+                    if (worker->getMailboxRef().post(move(pack)) && !scheduler.schedule(worker, urgent)) inlined = worker;
                 }
+                // unlocked, handle() may send (see admit()) or look up workers,
+                // the scheduled mailbox keeps the worker alive (see dismiss())
+                if (inlined) while (scheduler.drain(inlined, SIZE_MAX));
             }
         }
 
+        // ---- concurrency ----
+
+        // Runs the handle() calls of the workers on a work-stealing pool
+        // (see Scheduler), 0 threads: inline, in tick(). cpus: binds the
+        // threads.
+        void setThreads(size_t threads, const vector<int>& cpus = {}) {
+            scheduler.setThreads(threads, cpus);
+        }
+
+        size_t getThreads() const { return scheduler.getThreads(); }
+
+        // Keeps the worker on one pool thread (lane % threads), -1 lets
+        // it run on any
+        void setAffinity(const string& name, int lane) { scheduler.setAffinity(name, lane); }
+
+        // Blocks until the workers handled the packs routed so far
+        void wait() { scheduler.wait(); }
+
+        // ---- backpressure ----
+
+        // Bounds the mailbox of the worker ("*": of every worker without
+        // its own bound), capacity 0: unbounded (see MailboxPolicy)
+        void setMailboxLimit(const string& name, size_t capacity, MailboxPolicy policy = MailboxPolicy::Block) {
+            backpressure.setMailboxLimit(name, capacity, policy);
+        }
+
+        // Token bucket for each sender => recipient pair ("*": any), the
+        // recipient's mailbox policy tells if an over the limit send()
+        // waits or throws, perSecond <= 0 lifts the limit
+        void setRateLimit(const string& sender, const string& recipient, double perSecond, double burst = 1) {
+            backpressure.setRateLimit(sender, recipient, perSecond, burst);
+        }
+
+        // The workers held back so far
+        map<string, ThrottleStats> getThrottleStats() const { return backpressure.getThrottleStats(); }
+
+        string dumpThrottles() const { return backpressure.dump(); }
+
+        // ---- checkpoints ----
+
+        // Saves the agency into filename and a segment file per worker next
+        // to it, rewriting the workers changed since the last checkpoint
+        // only (see Checkpointer)
+        Checkpoint::Stats checkpoint(const string& filename) { return checkpointer.checkpoint(filename); }
+
+        // Loads a checkpoint (or a former full save), the loaded workers
+        // count as saved
+        void restore(const string& filename) { checkpointer.restore(filename); }
+
+        // Checkpoints into filename every ms on a background thread (0:
+        // stops), errors go to hoops()
+        void setAutosave(const string& filename, long ms) { checkpointer.setAutosave(filename, ms); }
+
+        // ---- recording ----
+
+        // Logs the packs produced into the queue from now on ("": stops),
+        // see PackQueue::record() and PackReplay
+        void record(const string& filename) { this->queue.record(filename); }
+
+        // Packs logged by the running recording
+        size_t getRecorded() const { return this->queue.getRecorded(); }
+
+        // ---- remote ----
+
+        // Name of this agency for the other nodes, set it before listen()
+        // or connect(), defaults to <agency name>@<pid>
+        string getNode() const { return nodes.getNode(); }
+
+        void setNode(const string& node) { nodes.setNode(node); }
+
+        // Accepts the connect() of other nodes over a Unix domain socket at
+        // path ("": stops listening)
+        void listen(const string& path) { nodes.listen(path); }
+
+        // Joins the node listening at path, returns its name. The workers
+        // of each node show up in the other as RemoteWorkers, so packs are
+        // routed across and kill(), findWorkers() and dumpWorkers() see
+        // them (spawnAt() spawns there).
+        string connect(const string& path) { return nodes.connect(path); }
+
+        // Closes the links to the node ("": to every node), its workers
+        // leave here
+        void disconnect(const string& node = "") { nodes.disconnect(node); }
+
+        // Spawns a worker of the role in the node (the role has to be known
+        // there), it joins here as a RemoteWorker
+        void spawnAt(const string& node, const string& role, const string& name, const JSON& json) {
+            nodes.spawnAt(node, role, name, json);
+        }
+
+        vector<string> getNodes() const { return nodes.getNodes(); }
+
+        map<string, LinkStats> getLinkStats() const { return nodes.getLinkStats(); }
+
+        // ---- workers ----
+
         bool hasWorker(const string& name) const {
-            for (Worker<T>* worker: workers)
-                if (worker->getName() == name) return true;
-            return false;
+            lock_guard<mutex> lock(workers_mtx); // remote workers come and go
+            return workers.find(name);
         }
 
         // template<typename WorkerT>
         Worker<T>& getWorkerRef(const string& name) const {
-            for (Worker<T>* worker: workers)
-                if (safe(worker)->getName() == name) return *(Worker<T>*)worker;
+            Worker<T>* worker = nullptr;
+            {
+                lock_guard<mutex> lock(workers_mtx);
+                worker = workers.find(name);
+            }
+            if (worker) return *worker;
             throw ERROR("Requested worker '" + name + "' is not found.");
         }
 
@@ -133,7 +278,8 @@ namespace tools::agency {
 
         vector<string> findWorkers(const string& keyword = "") const {
             vector<string> found;
-            for (const Worker<T>* worker: workers) {
+            lock_guard<mutex> lock(workers_mtx);
+            for (const Worker<T>* worker: workers.all()) {
                 string name = safe(worker)->getName();
                 if (keyword.empty() || str_contains(name, keyword))
                     found.push_back(name);
@@ -143,17 +289,65 @@ namespace tools::agency {
 
         string dumpWorkers(const vector<string>& names) const {
             vector<string> dumps;
+            lock_guard<mutex> lock(workers_mtx);
             for (const string& name: names) {
-                if (hasWorker(name)) dumps.push_back(getWorkerRef(name).dump());
+                Worker<T>* worker = workers.find(name);
+                if (worker) dumps.push_back(worker->dump());
                 else dumps.push_back("Worker " + name + " is not exists!");
             };
             return implode("\n", dumps);
         }
 
+        // ---- configuration ----
+
+        // The pool, the autosave and the remote setup of this process: not
+        // in the saved state (see toJSON()), so loading a save starts no
+        // threads and takes no sockets, apply it explicitly
+        void configure(const JSON& config) {
+            if (config.has("threads"))
+                setThreads(
+                    config.get<size_t>("threads"),
+                    config.has("cpus") ? config.get<vector<int>>("cpus") : vector<int>()
+                );
+            if (config.has("affinity"))
+                for (const auto& [name, lane]: config.get<map<string, int>>("affinity"))
+                    setAffinity(name, lane);
+            if (config.has("autosave"))
+                setAutosave(config.get<string>("autosave.file"), config.get<long>("autosave.ms"));
+            if (config.has("remote.node")) setNode(config.get<string>("remote.node"));
+            if (config.has("remote.listen")) listen(config.get<string>("remote.listen"));
+            if (config.has("remote.connect"))
+                for (const string& path: config.get<vector<string>>("remote.connect"))
+                    try {
+                        connect(path);
+                    } catch (exception &e) {
+                        this->hoops("Node at " + path + " is unreachable: " + string(e.what()));
+                    }
+        }
+
+        JSON getConfig() const {
+            JSON config;
+            config.set("threads", scheduler.getThreads());
+            config.set("cpus", scheduler.getCpus());
+            config.set("affinity", scheduler.getAffinity());
+            long autosaveMs = checkpointer.getAutosaveMs();
+            if (autosaveMs) {
+                config.set("autosave.file", checkpointer.getAutosaveFile());
+                config.set("autosave.ms", autosaveMs);
+            }
+            if (nodes.isNamed()) config.set("remote.node", nodes.getNode());
+            string listening = nodes.getListening();
+            if (!listening.empty()) config.set("remote.listen", listening);
+            vector<string> connected = nodes.getConnected();
+            if (!connected.empty()) config.set("remote.connect", connected);
+            return config;
+        }
+
         // ---- JSON serialization ----
 
         void fromJSON(const JSON& json) override {
             Worker<T>::fromJSON(json);
+            backpressure.load(json);
 
             if (json.has("workers")) {
                 vector<JSON> jworkers = json.get<vector<JSON>>("workers");
@@ -169,26 +363,84 @@ namespace tools::agency {
         }
 
         JSON toJSON() const override {
-            JSON json = Worker<T>::toJSON();
+            JSON json = toSnapshot();
 
             vector<JSON> jworkers;
-            for (const Worker<T>* worker: workers) {
+            for (const Worker<T>* worker: workers.all()) {
                 safe(worker);
-                if (worker->getName() == "user") continue;
+                if (worker->getName() == "user" || remote_of(worker)) continue; // remotes are saved in their node
                 jworkers.push_back(worker->toJSON());
             }
             json.set("workers", jworkers);
             return json;
         }
 
+        // The agency itself, without the workers (and without the setup,
+        // see getConfig())
+        JSON toSnapshot() const override {
+            JSON json = Worker<T>::toJSON();
+            backpressure.save(json);
+            return json;
+        }
+
+    protected:
+
+        // The packs of the agency (and the packs to route) come
+        // through the queue, not the mailbox
+        void wait(long ms) override {
+            this->queue.waitFor(ms, [this]() { return this->closing.load(); });
+        }
+
+        void wake() override {
+            this->queue.notify();
+        }
+
+        // Backpressure on the send()s of the agency and its workers, may
+        // wait or throw to the sender (see hoops() in Scheduler::drain())
+        void admit(const WorkerId& sender, const WorkerId& recipient) override {
+            backpressure.admit(sender, recipient);
+        }
+
     private:
+
+        // Removes the worker from here (a remote one stays in its node),
+        // waits for its running handle() (if any) to return
+        bool dismiss(const string& name) {
+            WorkerId id;
+            if (!WorkerId::find(name, id)) return false;
+            Worker<T>* worker = nullptr;
+            WorkStealingPool* helper = nullptr;
+            {
+                lock_guard<mutex> lock(workers_mtx);
+                worker = workers.find(id);
+                if (worker && worker->getMailboxRef().isRunner())
+                    throw ERROR("Worker '" + name + "' can not kill itself.");
+                workers.remove(id);
+                helper = scheduler.getPool();
+            }
+            this->queue.drop(id);
+            if (!worker) return false;
+            Mailbox<T>& mailbox = worker->getMailboxRef();
+            mailbox.close(); // wakes the senders waiting for room
+            mailbox.clear();
+            while (!mailbox.waitIdle(1)) // its run may be queued behind us
+                if (helper) helper->runOne();
+            owns.release(this, worker); // delete worker;
+            return true;
+        }
+
         Owns& owns;
         AgentRoleMap& roles;
         // bool voice = false;
-        vector<Worker<T>*> workers; // TODO: Replace vector<Worker<T>*> with unordered_map<string, Worker<T>*>, O(1) lookup vs. O(n), huge win with many workers.
+        WorkerRegistry<T> workers;
         
-        mutex workers_mtx;
+        mutable mutex workers_mtx;
         Pack<T> pack;
+
+        Scheduler<T> scheduler;
+        Backpressure<T> backpressure;
+        Checkpointer<T> checkpointer;
+        Nodes<T> nodes;
     };
 
     template<typename T>
@@ -200,6 +452,9 @@ namespace tools::agency {
 
 #ifdef TEST
 
+#include <set>
+
+#include "../containers/vector_equal.hpp"
 #include "tests/TestAgency.hpp"
 
 // Agency tests
@@ -297,6 +552,76 @@ void test_Agency_tick_dispatch() {
     assert(test_worker.handled && "Tick should dispatch to worker");
 }
 
+// Dispatches on the alternative of the Message
+class MessageTestWorker: public Worker<Message> {
+public:
+    using Worker<Message>::Worker;
+    string type() const override { return "message_test"; }
+    void handle(const string&, const Message& item) override {
+        visit(overloaded{
+            [&](const Text& text) { texts.push_back(text.text); },
+            [&](const ToolCall& call) { calls.push_back(call.name + ":" + call.arguments.dump()); },
+            [&](const auto&) { others++; },
+        }, item);
+    }
+    vector<string> texts;
+    vector<string> calls;
+    size_t others = 0;
+};
+
+void test_Agency_message_items() {
+    Owns owns;
+    AgentRoleMap roles;
+    PackQueue<Message> queue;
+    Agency<Message> agency(owns, roles, queue, "agency");
+    MessageTestWorker& worker = agency.spawn<MessageTestWorker>(owns, &agency, queue, "worker");
+    queue.Produce(Pack<Message>("user", "worker", Message(Text("hello"))));
+    queue.Produce(Pack<Message>("user", "worker", Message(ToolCall{ "1", "weather", { { "city", "Budapest" } } })));
+    queue.Produce(Pack<Message>("user", "worker", Message(AudioRef{ "in.wav" })));
+    queue.Produce(Pack<Message>("user", "agency", Message(Control::List)));
+    queue.Produce(Pack<Message>("user", "agency", Message(Text("exit"))));
+    string output = capture_cout([&]() { agency.tick(); });
+    assert(vector_equal(worker.texts, vector<string>({ "hello" })) && "Text should reach its handler");
+    assert(vector_equal(worker.calls, vector<string>({ "weather:{\"city\":\"Budapest\"}" })) && "Tool call should arrive parsed");
+    assert(worker.others == 1 && "Audio should reach the generic handler");
+    assert(str_contains(output, "Workers in the agency:\nworker") && "List control should list the workers");
+    assert(!agency.isClosing() && "Text 'exit' should not be a control");
+    assert(str_contains(agency.dump(), "worker") && "Dump should work with Message items");
+    worker.exit(); // sends Control::Exit
+    output = capture_cout([&]() { agency.tick(); });
+    assert(agency.isClosing() && "Exit control should close the agency");
+}
+
+// Works on its pack until an interactive one preempts it
+class BackgroundTestWorker: public TestWorker<string> {
+public:
+    using TestWorker<string>::TestWorker;
+    atomic<bool> started = false;
+    atomic<bool> yielded = false;
+    void handle(const string&, const string&) override {
+        started = true;
+        for (int i = 0; i < 5000 && !this->isPreempted(); i++) sleep_ms(1);
+        yielded = this->isPreempted();
+    }
+};
+
+void test_Agency_priority_preemption() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.setThreads(1); // the interactive pack needs the thread of the background one
+    BackgroundTestWorker& background = agency.spawn<BackgroundTestWorker>(setup.owns, &agency, setup.queue, "background");
+    TestWorker<string>& interactive = agency.spawn<TestWorker<string>>(setup.owns, &agency, setup.queue, "interactive");
+    setup.queue.Produce(Pack<string>("agent", "background", "job", Priority::Background));
+    agency.tick();
+    for (int i = 0; i < 1000 && !background.started; i++) sleep_ms(1);
+    setup.queue.Produce(Pack<string>("user", "interactive", "hello", Priority::Interactive));
+    agency.tick();
+    agency.setThreads(0); // waits for the runs
+    assert(background.started && background.yielded && "Interactive pack should preempt the background handle()");
+    assert(interactive.handled && "Interactive pack should be handled");
+    assert(!background.isPreempted() && "Preemption should end with the handle()");
+}
+
 void test_Agency_type() {
     default_test_agency_setup setup("agency");
     Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
@@ -489,7 +814,545 @@ void test_Agency_getAgencyPtr_agency_is_not_this() {
     assert(agencyPtr == setup.agency && "Agency pointer should be the same as agency when agency is not this");
 }
 
+// Records the handled items (slowly if delay_ms is set)
+class RecordingTestWorker: public TestWorker<string> {
+public:
+    using TestWorker<string>::TestWorker;
+
+    long delay_ms = 0;
+    atomic<bool>* finished = nullptr;
+
+    void handle(const string&, const string& item) override {
+        if (delay_ms) sleep_ms(delay_ms);
+        lock_guard<mutex> lock(mtx);
+        items.push_back(item);
+        thread_ids.insert(this_thread::get_id());
+        if (finished) *finished = true;
+    }
+
+    vector<string> getItems() {
+        lock_guard<mutex> lock(mtx);
+        return items;
+    }
+
+    size_t countThreads() {
+        lock_guard<mutex> lock(mtx);
+        return thread_ids.size();
+    }
+
+private:
+    mutex mtx;
+    vector<string> items;
+    set<thread::id> thread_ids;
+};
+
+void test_Agency_tick_threads_order() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    agency.setThreads(3);
+    vector<RecordingTestWorker*> workers;
+    for (const string& name: vector<string>({ "worker1", "worker2", "worker3" }))
+        workers.push_back(&agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, name));
+    queue_to_vector(setup.queue); // spawn messages
+    vector<string> expected;
+    for (int i = 0; i < 50; i++) {
+        expected.push_back(to_string(i));
+        for (RecordingTestWorker* worker: workers)
+            setup.queue.Produce(Pack<string>("user", worker->getName(), to_string(i)));
+    }
+    agency.tick();
+    agency.wait();
+    for (RecordingTestWorker* worker: workers)
+        assert(vector_equal(worker->getItems(), expected) && "Each worker should handle its packs in order");
+}
+
+void test_Agency_tick_threads_parallel() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    agency.setThreads(2);
+    assert(agency.getThreads() == 2 && "Agency should have the pool threads");
+    RecordingTestWorker& slow = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "slow");
+    RecordingTestWorker& fast = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "fast");
+    slow.delay_ms = 300;
+    setup.queue.Produce(Pack<string>("user", "slow", "long job"));
+    setup.queue.Produce(Pack<string>("user", "fast", "short job"));
+    agency.tick();
+    for (int i = 0; i < 200 && fast.getItems().empty(); i++) sleep_ms(1);
+    bool fast_done = !fast.getItems().empty();
+    bool slow_done = !slow.getItems().empty();
+    agency.wait();
+    assert(fast_done && !slow_done && "A slow worker shouldn't hold back the others");
+    assert(slow.getItems().size() == 1 && "Slow worker should finish too");
+}
+
+void test_Agency_affinity_json() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    JSON config;
+    config.set("threads", 3);
+    config.set("affinity", map<string, int>({{ "pinned", 1 }}));
+    agency.configure(config);
+    assert(agency.getThreads() == 3 && "Threads should come from the config");
+    RecordingTestWorker& pinned = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "pinned");
+    for (int i = 0; i < 100; i++) setup.queue.Produce(Pack<string>("user", "pinned", to_string(i)));
+    agency.tick();
+    agency.wait();
+    assert(pinned.getItems().size() == 100 && pinned.countThreads() == 1 && "Pinned worker should run on one thread");
+    JSON json = agency.getConfig();
+    assert(json.get<size_t>("threads") == 3 && "getConfig should contain the threads");
+    map<string, int> affinity = json.get<map<string, int>>("affinity");
+    assert(affinity["pinned"] == 1 && "getConfig should contain the affinity");
+    assert(!agency.toJSON().has("threads") && !agency.toJSON().has("affinity") && "toJSON shouldn't contain the config");
+}
+
+void test_Agency_fromJSON_keeps_config() {
+    string path = (fs::temp_directory_path() / "test_Agency_fromJSON_keeps_config.sock").string();
+    if (file_exists(path)) remove(path);
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.setThreads(2);
+    setup.json.set("threads", 0);
+    setup.json.set("autosave.file", path + ".json");
+    setup.json.set("autosave.ms", 5);
+    setup.json.set("remote.listen", path);
+    agency.fromJSON(setup.json);
+    assert(agency.getThreads() == 2 && "fromJSON shouldn't change the pool");
+    assert(!agency.getConfig().has("autosave") && "fromJSON shouldn't start the autosave");
+    assert(!file_exists(path) && !agency.getConfig().has("remote.listen") && "fromJSON shouldn't listen");
+}
+
+void test_Agency_kill_waits_running() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    agency.setThreads(1);
+    atomic<bool> finished = false;
+    RecordingTestWorker& worker = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "worker");
+    worker.delay_ms = 50;
+    worker.finished = &finished;
+    setup.queue.Produce(Pack<string>("user", "worker", "job"));
+    setup.queue.Produce(Pack<string>("user", "worker", "dropped"));
+    agency.tick();
+    sleep_ms(10);
+    assert(agency.kill("worker") && "Worker should be found");
+    assert(finished && "Kill should wait for the running handle()");
+    assert(!agency.hasWorker("worker") && "Killed worker should be gone");
+}
+
+void test_Agency_registry_many_workers() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    for (int i = 0; i < 200; i++)
+        agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "helper" + to_string(i));
+    assert(agency.kill("helper7") && !agency.kill("helper7") && "Second kill should find nothing");
+    assert(!agency.kill("never_spawned_worker") && "Unknown worker shouldn't be found");
+    RecordingTestWorker& respawned = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "helper7");
+    queue_to_vector(setup.queue); // spawn messages
+    setup.queue.Produce(Pack<string>("user", "helper7", "hello"));
+    setup.queue.Produce(Pack<string>("user", "nobody", "lost"));
+    agency.tick();
+    assert(respawned.getItems().size() == 1 && "Respawned worker should get its packs");
+    assert(respawned.getId() == WorkerId("helper7") && "Respawned worker should keep the interned id");
+    vector<string> found = agency.findWorkers("helper");
+    assert(found.size() == 200 && found.back() == "helper7" && "Listing should keep the spawn order");
+}
+
+void test_Agency_async_wakes_on_pack() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    RecordingTestWorker& worker = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "worker");
+    agency.start();
+    setup.queue.Produce(Pack<string>("user", "worker", "hello"));
+    for (int i = 0; i < 1000 && worker.getItems().empty(); i++) sleep_ms(1);
+    bool delivered = !worker.getItems().empty();
+    agency.stop();
+    assert(delivered && "Running agency should route the pack without a tick timer");
+    assert(agency.isClosing() && "Stop should close the agency");
+}
+
+// Sends from a worker of the agency, returns the error (if any)
+string send_error(RecordingTestWorker& sender, const string& recipient, const string& item) {
+    try {
+        sender.testSend(recipient, item);
+    } catch (exception& e) {
+        return e.what();
+    }
+    return "";
+}
+
+void test_Agency_mailbox_reject() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    agency.setThreads(1);
+    agency.setMailboxLimit("slow", 1, MailboxPolicy::Reject);
+    RecordingTestWorker& slow = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "slow");
+    RecordingTestWorker& sender = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "sender");
+    slow.delay_ms = 100;
+    setup.queue.Produce(Pack<string>("user", "slow", "1"));
+    setup.queue.Produce(Pack<string>("user", "slow", "2"));
+    agency.tick();
+    sleep_ms(20);
+    string error = send_error(sender, "slow", "3");
+    assert(str_contains(error, "Mailbox of 'slow' is full") && "Full mailbox should reject to the sender");
+    agency.wait();
+    assert(slow.getItems().size() == 2 && "Admitted packs should be handled");
+    assert(agency.getThrottleStats()["sender"].rejected == 1 && "Rejection should be counted");
+    assert(str_contains(agency.dumpThrottles(), "Worker 'sender' limited: 0, blocked: 0, rejected: 1") && "Throttled worker should be listed");
+}
+
+void test_Agency_mailbox_drop_oldest() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    agency.setThreads(1);
+    RecordingTestWorker& slow = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "slow");
+    agency.setMailboxLimit("*", 2, MailboxPolicy::DropOldest);
+    slow.delay_ms = 20;
+    for (int i = 0; i < 6; i++) setup.queue.Produce(Pack<string>("user", "slow", to_string(i)));
+    agency.tick();
+    agency.wait();
+    size_t dropped = agency.getThrottleStats()["slow"].dropped;
+    vector<string> items = slow.getItems();
+    assert(dropped >= 3 && items.size() + dropped == 6 && "Full mailbox should drop the oldest packs");
+    assert(items.back() == "5" && "Newest pack should be kept");
+}
+
+void test_Agency_mailbox_block() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    agency.setThreads(1);
+    agency.setMailboxLimit("slow", 1);
+    RecordingTestWorker& slow = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "slow");
+    RecordingTestWorker& sender = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "sender");
+    slow.delay_ms = 20;
+    vector<string> expected;
+    for (int i = 0; i < 5; i++) {
+        expected.push_back(to_string(i));
+        assert(send_error(sender, "slow", to_string(i)).empty() && "Block policy shouldn't reject");
+        agency.tick();
+    }
+    agency.wait();
+    assert(vector_equal(slow.getItems(), expected) && "Blocked sends should arrive in order");
+    assert(agency.getThrottleStats()["sender"].blocked >= 1 && "Waiting sender should be counted");
+}
+
+void test_Agency_rate_limit() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    RecordingTestWorker& sender = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "sender");
+    agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "strict");
+    agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "patient");
+    agency.setMailboxLimit("strict", 0, MailboxPolicy::Reject);
+    agency.setRateLimit("sender", "strict", 1, 2);
+    agency.setRateLimit("*", "patient", 200, 1);
+    assert(send_error(sender, "strict", "1").empty() && send_error(sender, "strict", "2").empty() && "Burst should pass");
+    assert(str_contains(send_error(sender, "strict", "3"), "Rate limit exceeded") && "Over the limit should reject");
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < 5; i++) assert(send_error(sender, "patient", to_string(i)).empty() && "Block policy should wait");
+    long long ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    assert(ms >= 15 && "Sends should wait for the tokens");
+    ThrottleStats stats = agency.getThrottleStats()["sender"];
+    assert(stats.limited == 5 && stats.rejected == 1 && "Limited sends should be counted");
+}
+
+// Calls back from handle(), e.g. to send from there
+class CallbackTestWorker: public TestWorker<string> {
+public:
+    using TestWorker<string>::TestWorker;
+    function<void(CallbackTestWorker&, const string&)> callback;
+    void handle(const string&, const string& item) override {
+        if (callback) callback(*this, item);
+    }
+};
+
+// Runs the callback on a thread, false if it didn't return in time
+// (a deadlock, the thread is left behind)
+bool returns_within(long ms, function<void()> callback) {
+    auto done = make_shared<atomic<bool>>(false);
+    thread runner([done, callback]() {
+        callback();
+        *done = true;
+    });
+    for (long i = 0; i < ms && !*done; i++) sleep_ms(1);
+    if (!*done) {
+        runner.detach();
+        return false;
+    }
+    runner.join();
+    return true;
+}
+
+void test_Agency_inline_handle_sends_with_limits() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    agency.setMailboxLimit("*", 8, MailboxPolicy::Reject); // sends go through admit()
+    CallbackTestWorker& replier = agency.spawn<CallbackTestWorker>(setup.owns, &agency, setup.queue, "replier");
+    RecordingTestWorker& user = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "user");
+    replier.callback = [](CallbackTestWorker& self, const string& item) { self.testSend("user", "re: " + item); };
+    setup.queue.Produce(Pack<string>("user", "replier", "hello"));
+    bool returned = returns_within(5000, [&]() { agency.tick(); });
+    assert(returned && "Inline handle() should send without a deadlock");
+    assert(vector_equal(user.getItems(), vector<string>({ "re: hello" })) && "Reply should be routed in the same tick");
+}
+
+void test_Agency_inline_handle_finds_workers() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    CallbackTestWorker& lister = agency.spawn<CallbackTestWorker>(setup.owns, &agency, setup.queue, "lister");
+    agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "helper");
+    vector<string> found;
+    string dump;
+    bool has = false;
+    lister.callback = [&](CallbackTestWorker&, const string&) {
+        found = agency.findWorkers("");
+        has = agency.hasWorker("helper") && agency.getWorkerRef("helper").getName() == "helper";
+        dump = agency.dumpWorkers(found);
+    };
+    setup.queue.Produce(Pack<string>("user", "lister", "list"));
+    bool returned = returns_within(5000, [&]() { agency.tick(); });
+    assert(returned && "Inline handle() should look up the workers without a deadlock");
+    assert(vector_equal(found, vector<string>({ "lister", "helper" })) && has && "Workers should be found from handle()");
+    assert(str_contains(dump, "helper") && "Workers should be dumped from handle()");
+}
+
+void test_Agency_backpressure_json() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    JSON jlimit;
+    jlimit.set("capacity", 8);
+    jlimit.set("policy", "drop_oldest");
+    setup.json.set("mailboxes", map<string, JSON>({{ "*", jlimit }}));
+    JSON jrate;
+    jrate.set("sender", "*");
+    jrate.set("recipient", "chatbot");
+    jrate.set("per_second", 2.5);
+    jrate.set("burst", 4);
+    setup.json.set("rate_limits", vector<JSON>({ jrate }));
+    agency.fromJSON(setup.json);
+    RecordingTestWorker& worker = agency.spawn<RecordingTestWorker>(setup.owns, &agency, setup.queue, "worker");
+    MailboxLimit limit = worker.getMailboxRef().getLimit();
+    assert(limit.capacity == 8 && limit.policy == MailboxPolicy::DropOldest && "Default bound should apply");
+    assert(agency.dumpThrottles() == "No throttled workers." && "Nothing should be throttled yet");
+    JSON json = agency.toJSON();
+    JSON jmailbox = json.get<map<string, JSON>>("mailboxes")["*"];
+    assert(jmailbox.get<size_t>("capacity") == 8 && jmailbox.get<string>("policy") == "drop_oldest" && "toJSON should contain the bounds");
+    vector<JSON> jrates = json.get<vector<JSON>>("rate_limits");
+    assert(jrates.size() == 1 && jrates[0].get<string>("recipient") == "chatbot" && jrates[0].get<double>("per_second") == 2.5 && "toJSON should contain the rate limits");
+}
+
+// Keeps the handled items as a journal
+class JournalTestWorker: public TestWorker<string> {
+public:
+    using TestWorker<string>::TestWorker;
+
+    vector<string> items;
+
+    string type() const override { return "journal"; }
+
+    void handle(const string&, const string& item) override {
+        items.push_back(item);
+    }
+
+    void fromJSON(const JSON& json) override {
+        TestWorker<string>::fromJSON(json);
+        if (json.has("items"))
+            for (const JSON& jitem: json.get<vector<JSON>>("items")) items.push_back(jitem.get<string>("item"));
+    }
+
+    size_t journal(size_t from, vector<JSON>& entries, string& key) const override {
+        key = "items";
+        for (size_t i = from; i < items.size(); i++) {
+            JSON jitem;
+            jitem.set("item", items[i]);
+            entries.push_back(jitem);
+        }
+        return items.size();
+    }
+};
+
+// An agency making JournalTestWorkers for its "journal" role
+struct journal_test_agency {
+    default_test_agency_setup setup;
+    Agency<string> agency;
+    journal_test_agency(): setup("agency"), agency(setup.owns, setup.roles, setup.queue, setup.name) {
+        setup.roles["journal"] = [this](const string& name, const JSON& json) {
+            spawn(name).fromJSON(json);
+        };
+        agency.fromJSON(setup.json);
+    }
+    JournalTestWorker& spawn(const string& name) {
+        return agency.spawn<JournalTestWorker>(setup.owns, &agency, setup.queue, name);
+    }
+    void send(const string& recipient, const string& item) {
+        setup.queue.Produce(Pack<string>("user", recipient, item));
+    }
+};
+
+void test_Agency_checkpoint_incremental() {
+    string file = (fs::temp_directory_path() / "test_Agency_checkpoint_incremental.json").string();
+    journal_test_agency test;
+    test.spawn("alice").setPriority(Priority::Background);
+    test.spawn("bob");
+    for (string item: { "a1", "a2", "a3" }) test.send("alice", item);
+    test.send("bob", "b1");
+    test.agency.tick();
+    Checkpoint::Stats stats = test.agency.checkpoint(file);
+    assert(stats.written == 2 && stats.appended == 4 && "First checkpoint should write everything");
+    test.send("alice", "a4");
+    test.send("alice", "a5");
+    test.agency.tick();
+    stats = test.agency.checkpoint(file);
+    assert(stats.written == 1 && stats.kept == 1 && stats.appended == 2 && "Only the changed worker should be written");
+    stats = test.agency.checkpoint(file);
+    assert(stats.written == 0 && stats.kept == 2 && "Unchanged agency should write the manifest only");
+
+    journal_test_agency restored;
+    restored.agency.restore(file);
+    JournalTestWorker& alice = (JournalTestWorker&)restored.agency.getWorkerRef("alice");
+    JournalTestWorker& bob = (JournalTestWorker&)restored.agency.getWorkerRef("bob");
+    assert(alice.items.size() == 5 && alice.items[4] == "a5" && bob.items.size() == 1 && "Restore should replay the journals");
+    assert(alice.getPriority() == Priority::Background && bob.getPriority() == Priority::Normal && "Restore should keep the priorities");
+    stats = restored.agency.checkpoint(file);
+    assert(stats.written == 0 && "Restored workers should count as saved");
+    assert(restored.agency.kill("bob") && "Worker should be killed");
+    JournalTestWorker& reborn = restored.spawn("bob");
+    restored.send("bob", "new");
+    restored.agency.tick();
+    stats = restored.agency.checkpoint(file);
+    assert(stats.written == 1 && stats.appended == 1 && "Respawned worker should start its journal over");
+    journal_test_agency again;
+    again.agency.restore(file);
+    assert(((JournalTestWorker&)again.agency.getWorkerRef("bob")).items == reborn.items && "Journal of the respawned worker should be its own");
+}
+
+void test_Agency_checkpoint_holds_running_worker() {
+    string file = (fs::temp_directory_path() / "test_Agency_checkpoint_holds_running_worker.json").string();
+    journal_test_agency test;
+    test.agency.setThreads(1);
+    RecordingTestWorker& slow = test.agency.spawn<RecordingTestWorker>(test.setup.owns, &test.agency, test.setup.queue, "slow");
+    slow.delay_ms = 50;
+    atomic<bool> finished = false;
+    slow.finished = &finished;
+    test.send("slow", "job");
+    test.agency.tick();
+    sleep_ms(10);
+    test.agency.checkpoint(file);
+    assert(finished && "Checkpoint should wait for the running handle()");
+    test.agency.wait();
+}
+
+void test_Agency_autosave() {
+    string file = (fs::temp_directory_path() / "test_Agency_autosave.json").string();
+    if (file_exists(file)) remove(file);
+    journal_test_agency test;
+    test.spawn("alice");
+    test.send("alice", "hello");
+    test.agency.tick();
+    test.agency.setAutosave(file, 5);
+    for (int i = 0; i < 1000 && !file_exists(file); i++) sleep_ms(1);
+    assert(test.agency.getConfig().get<long>("autosave.ms") == 5 && "getConfig should contain the autosave");
+    test.agency.setAutosave("", 0);
+    journal_test_agency restored;
+    restored.agency.restore(file);
+    assert(!restored.agency.getConfig().has("autosave") && "Restore shouldn't start the autosave");
+    assert(((JournalTestWorker&)restored.agency.getWorkerRef("alice")).items.size() == 1 && "Autosave should write the checkpoint");
+}
+
 // Register tests
+void test_Agency_trace_pack() {
+    default_test_agency_setup setup("agency");
+    Agency<string> agency(setup.owns, setup.roles, setup.queue, setup.name);
+    agency.fromJSON(setup.json);
+    auto& test_worker = agency.spawn<TestWorker<string>>(setup.owns, &agency, setup.queue, "test_worker");
+    test_worker.fromJSON(setup.json);
+    capture_cout([&]() { agency.tick(); });
+
+    Tracer& tracer = Tracer::instance();
+    tracer.clear();
+    tracer.enable();
+    setup.queue.Produce(Pack<string>("user", "test_worker", "hello"));
+    capture_cout([&]() { agency.tick(); });
+    tracer.enable(false);
+
+    vector<string> spans;
+    string flows;
+    uint64_t id = 0;
+    for (const Tracer::ThreadEvent& te: tracer.collect()) {
+        const Tracer::Event& e = te.event;
+        if (string(e.category) == "flow") flows += e.phase;
+        if (string(e.category) != "pack") continue;
+        if (!id) id = e.id;
+        assert(e.id == id && e.id && "Spans of the pack should share its id");
+        assert(string(e.detail) == "test_worker" && "Spans should tell the recipient");
+        spans.push_back(e.name);
+    }
+    tracer.clear();
+    assert(test_worker.handled && "Traced pack should be handled");
+    // spans end inside out: handle (inline drain) closes before dequeue
+    assert(vector_equal(spans, vector<string>({ "enqueue", "handle", "dequeue" })) && "Pack should be traced from enqueue to handle");
+    assert(flows == "stf" && "Flow should link the spans");
+}
+
+// Two nodes in one process, talking over a Unix domain socket
+void test_Agency_remote_nodes() {
+    string path = "/tmp/test_Agency_remote_" + to_string(getpid()) + ".sock";
+    auto eventually = [](function<bool()> done) {
+        for (int i = 0; i < 2000 && !done(); i++) this_thread::sleep_for(chrono::milliseconds(1));
+        return done();
+    };
+    default_test_agency_setup here("agency"), there("agency");
+    Agency<string> local(here.owns, here.roles, here.queue, here.name);
+    Agency<string> remote(there.owns, there.roles, there.queue, there.name);
+    local.fromJSON(here.json);
+    remote.fromJSON(there.json);
+    local.setNode("local");
+    remote.setNode("remote");
+    there.roles["test"] = [&](const string& name, const JSON& json) {
+        remote.spawn<TestWorker<string>>(there.owns, &remote, there.queue, name).fromJSON(json);
+    };
+    auto& alpha = remote.spawn<TestWorker<string>>(there.owns, &remote, there.queue, "remote_alpha");
+    alpha.fromJSON(there.json);
+    auto& beta = local.spawn<TestWorker<string>>(here.owns, &local, here.queue, "local_beta");
+    beta.fromJSON(here.json);
+    local.start(1);
+    remote.start(1);
+
+    remote.listen(path);
+    assert(local.connect(path) == "remote" && "Connect should return the name of the node");
+    assert(eventually([&]() { return local.hasWorker("remote_alpha") && remote.hasWorker("local_beta"); }) && "Workers should show up in the other node");
+    assert(vector_equal(local.getNodes(), vector<string>({ "remote" })) && "Node should be listed");
+    assert(str_contains(local.dumpWorkers({ "remote_alpha" }), "remote worker in node 'remote'") && "Dump should tell the node");
+
+    beta.testSend("remote_alpha", "hello");
+    assert(eventually([&]() { return alpha.handled; }) && "Pack should be routed to the other node");
+
+    JSON json;
+    json.set("recipients", vector<string>());
+    local.spawnAt("remote", "test", "remote_gamma", json);
+    assert(eventually([&]() { return local.hasWorker("remote_gamma"); }) && remote.hasWorker("remote_gamma") && "Spawn should happen in the node and show up here");
+    assert(local.kill("remote_gamma") && !local.hasWorker("remote_gamma") && "Remote worker should be killed");
+    assert(eventually([&]() { return !remote.hasWorker("remote_gamma"); }) && "Kill should happen in the node");
+
+    assert(local.toJSON().get<vector<JSON>>("workers").size() == 1 && "Remote workers should be saved in their node only");
+    assert(local.getConfig().get<vector<string>>("remote.connect") == vector<string>({ path }) && "Connections should be in the config");
+    assert(!local.toJSON().has("remote") && "Connections shouldn't be saved");
+
+    remote.disconnect();
+    assert(eventually([&]() { return !local.hasWorker("remote_alpha"); }) && "Workers of a disconnected node should leave");
+    assert(!remote.hasWorker("local_beta") && "Disconnect should remove the remote workers");
+    remote.listen("");
+}
+
 TEST(test_Agency_constructor_basic);
 TEST(test_Agency_handle_exit);
 TEST(test_Agency_handle_list);
@@ -497,6 +1360,8 @@ TEST(test_Agency_spawn_success);
 TEST(test_Agency_spawn_duplicate);
 TEST(test_Agency_kill_basic);
 TEST(test_Agency_tick_dispatch);
+TEST(test_Agency_message_items);
+TEST(test_Agency_priority_preemption);
 TEST(test_Agency_type);
 TEST(test_Agency_hasWorker_existing);
 TEST(test_Agency_hasWorker_nonExisting);
@@ -512,6 +1377,25 @@ TEST(test_Agency_fromJSON_workers);
 TEST(test_Agency_toJSON_workers);
 TEST(test_Agency_fromJSON_throws_on_invalid_role);
 TEST(test_Agency_getAgencyPtr_agency_is_not_this);
+TEST(test_Agency_tick_threads_order);
+TEST(test_Agency_tick_threads_parallel);
+TEST(test_Agency_affinity_json);
+TEST(test_Agency_fromJSON_keeps_config);
+TEST(test_Agency_kill_waits_running);
+TEST(test_Agency_registry_many_workers);
+TEST(test_Agency_async_wakes_on_pack);
+TEST(test_Agency_mailbox_reject);
+TEST(test_Agency_mailbox_drop_oldest);
+TEST(test_Agency_mailbox_block);
+TEST(test_Agency_rate_limit);
+TEST(test_Agency_inline_handle_sends_with_limits);
+TEST(test_Agency_inline_handle_finds_workers);
+TEST(test_Agency_backpressure_json);
+TEST(test_Agency_checkpoint_incremental);
+TEST(test_Agency_checkpoint_holds_running_worker);
+TEST(test_Agency_autosave);
+TEST(test_Agency_trace_pack);
+TEST(test_Agency_remote_nodes);
 
 // TODO:
 // Memory Management: Ensure ~Agency doesn’t double-delete if kill is called before destruction (current code is safe, but worth a double-check).
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "../abstracts/Closable.hpp"
+#include "../str/implode.hpp"
+#include "../utils/ERROR.hpp"
+#include "../utils/JSON.hpp"
+#include "Worker.hpp"
+#include "WorkerRegistry.hpp"
+#include "Scheduler.hpp"
+#include "Throttle.hpp"
+
+using namespace std;
+using namespace tools::abstracts;
+using namespace tools::str;
+using namespace tools::utils;
+
+namespace tools::agency {
+
+    /**
+     * Backpressure on the send()s of an agency and its workers: a token
+     * bucket per sender => recipient pair, then the room in the recipient's
+     * mailbox (see MailboxPolicy). The mailbox bounds are guarded by the
+     * mutex of the agency's workers, the rate limits by their own.
+     */
+    template<typename T>
+    class Backpressure {
+    public:
+        // longest wait of a send() for room in a Block mailbox before it is
+        // rejected (two workers may wait for each other)
+        static constexpr long admitTimeoutMs = 1000;
+
+        Backpressure(
+            WorkerRegistry<T>& workers,
+            mutex& workers_mtx,
+            Scheduler<T>& scheduler,
+            const Closable& agency
+        ):
+            workers(workers),
+            workers_mtx(workers_mtx),
+            scheduler(scheduler),
+            agency(agency)
+        {}
+
+        // Bounds the mailbox of the worker ("*": of every worker without
+        // its own bound), capacity 0: unbounded (see MailboxPolicy)
+        void setMailboxLimit(const string& name, size_t capacity, MailboxPolicy policy = MailboxPolicy::Block) {
+            lock_guard<mutex> lock(workers_mtx);
+            mailboxLimits[WorkerId(name)] = { capacity, policy };
+            for (Worker<T>* worker: workers.all())
+                worker->getMailboxRef().setLimit(mailboxLimit(worker->getId()));
+            if (capacity) limiting = true;
+        }
+
+        // The bound of the worker's mailbox, needs workers_mtx
+        MailboxLimit mailboxLimit(const WorkerId& id) const {
+            auto it = mailboxLimits.find(id);
+            if (it == mailboxLimits.end()) it = mailboxLimits.find(WorkerId("*"));
+            return it == mailboxLimits.end() ? MailboxLimit() : it->second;
+        }
+
+        // Token bucket for each sender => recipient pair ("*": any), the
+        // recipient's mailbox policy tells if an over the limit send()
+        // waits or throws, perSecond <= 0 lifts the limit
+        void setRateLimit(const string& sender, const string& recipient, double perSecond, double burst = 1) {
+            lock_guard<mutex> lock(limits_mtx);
+            WorkerId from(sender), to(recipient);
+            uint64_t key = pairKey(from, to);
+            if (perSecond <= 0) rateLimits.erase(key);
+            else rateLimits[key] = { from, to, { perSecond, burst } };
+            buckets.clear();
+            if (!rateLimits.empty()) limiting = true;
+        }
+
+        // The workers held back so far
+        map<string, ThrottleStats> getThrottleStats() const {
+            map<string, ThrottleStats> stats;
+            {
+                lock_guard<mutex> lock(limits_mtx);
+                for (const auto& [id, throttle]: throttles)
+                    if (throttle.any()) stats[id.name()] = throttle;
+            }
+            lock_guard<mutex> lock(workers_mtx);
+            for (const Worker<T>* worker: workers.all()) {
+                size_t dropped = worker->getMailboxCRef().getDropped();
+                if (dropped) stats[worker->getName()].dropped = dropped;
+            }
+            return stats;
+        }
+
+        string dump() const {
+            vector<string> dumps;
+            for (const auto& [name, stats]: getThrottleStats())
+                dumps.push_back(
+                    "Worker '" + name + "' limited: " + to_string(stats.limited) +
+                    ", blocked: " + to_string(stats.blocked) +
+                    ", rejected: " + to_string(stats.rejected) +
+                    ", dropped: " + to_string(stats.dropped)
+                );
+            return dumps.empty() ? "No throttled workers." : implode("\n", dumps);
+        }
+
+        // The rate limit of the pair, then the room in the recipient's
+        // mailbox. Block waits (a pool thread runs the queued runs
+        // meanwhile), the other policies throw to the sender.
+        void admit(const WorkerId& sender, const WorkerId& recipient) {
+            if (!limiting) return;
+            Worker<T>* target = nullptr;
+            WorkStealingPool* helper = nullptr;
+            MailboxLimit limit;
+            {
+                lock_guard<mutex> lock(workers_mtx);
+                target = workers.find(recipient);
+                if (target) {
+                    limit = target->getMailboxRef().getLimit();
+                    target->getMailboxRef().enter(); // kill() waits for leave()
+                }
+                WorkStealingPool* pool = scheduler.getPool();
+                if (pool && pool->getCurrentLane() >= 0) helper = pool;
+            }
+            try {
+                throttle(sender, recipient, limit.policy);
+                if (target) reserve(sender, *target, limit.policy, helper);
+            } catch (...) {
+                if (target) target->getMailboxRef().leave();
+                throw;
+            }
+            if (target) target->getMailboxRef().leave();
+        }
+
+        // ---- JSON serialization ----
+
+        // The "mailboxes" and "rate_limits" of the agency's state
+        void load(const JSON& json) {
+            if (json.has("mailboxes"))
+                for (const pair<const string, JSON>& jmailbox: json.get<map<string, JSON>>("mailboxes")) {
+                    const JSON& jlimit = jmailbox.second;
+                    setMailboxLimit(
+                        jmailbox.first,
+                        jlimit.get<size_t>("capacity"),
+                        to_mailbox_policy(jlimit.has("policy") ? jlimit.get<string>("policy") : "block")
+                    );
+                }
+            if (json.has("rate_limits"))
+                for (const JSON& jlimit: json.get<vector<JSON>>("rate_limits"))
+                    setRateLimit(
+                        jlimit.get<string>("sender"),
+                        jlimit.get<string>("recipient"),
+                        jlimit.get<double>("per_second"),
+                        jlimit.has("burst") ? jlimit.get<double>("burst") : 1
+                    );
+        }
+
+        void save(JSON& json) const {
+            map<string, JSON> jmailboxes;
+            {
+                lock_guard<mutex> lock(workers_mtx);
+                for (const auto& [id, limit]: mailboxLimits) {
+                    JSON jlimit;
+                    jlimit.set("capacity", limit.capacity);
+                    jlimit.set("policy", mailbox_policy_name(limit.policy));
+                    jmailboxes[id.name()] = jlimit;
+                }
+            }
+            json.set("mailboxes", jmailboxes);
+            vector<JSON> jrates;
+            {
+                lock_guard<mutex> lock(limits_mtx);
+                for (const auto& [key, pair]: rateLimits) {
+                    JSON jlimit;
+                    jlimit.set("sender", pair.sender.name());
+                    jlimit.set("recipient", pair.recipient.name());
+                    jlimit.set("per_second", pair.limit.perSecond);
+                    jlimit.set("burst", pair.limit.burst);
+                    jrates.push_back(jlimit);
+                }
+            }
+            json.set("rate_limits", jrates);
+        }
+
+    private:
+
+        static uint64_t pairKey(const WorkerId& sender, const WorkerId& recipient) {
+            return ((uint64_t)sender.value() << 32) | recipient.value();
+        }
+
+        void count(const WorkerId& sender, size_t ThrottleStats::* counter) {
+            lock_guard<mutex> lock(limits_mtx);
+            throttles[sender].*counter += 1;
+        }
+
+        // Takes a token of the pair's bucket, waits for it (Block) or throws
+        void throttle(const WorkerId& sender, const WorkerId& recipient, MailboxPolicy policy) {
+            for (bool limited = false; ; limited = true) {
+                chrono::nanoseconds wait(0);
+                {
+                    lock_guard<mutex> lock(limits_mtx);
+                    if (bucket(sender, recipient).take(wait)) return;
+                    if (!limited) throttles[sender].limited++;
+                    if (policy != MailboxPolicy::Block) {
+                        throttles[sender].rejected++;
+                        throw ERROR("Rate limit exceeded from '" + sender.name() + "' to '" + recipient.name() + "', pack dropped.");
+                    }
+                }
+                if (agency.isClosing()) return;
+                this_thread::sleep_for(min(wait, chrono::nanoseconds(chrono::milliseconds(10))));
+            }
+        }
+
+        // The bucket of the pair (unlimited if no limit applies), the most
+        // specific limit wins, needs limits_mtx
+        TokenBucket& bucket(const WorkerId& sender, const WorkerId& recipient) {
+            uint64_t key = pairKey(sender, recipient);
+            auto it = buckets.find(key);
+            if (it != buckets.end()) return it->second;
+            WorkerId any("*");
+            for (uint64_t limitKey: { key, pairKey(sender, any), pairKey(any, recipient), pairKey(any, any) }) {
+                auto limit = rateLimits.find(limitKey);
+                if (limit != rateLimits.end())
+                    return buckets.emplace(key, TokenBucket(limit->second.limit)).first->second;
+            }
+            return buckets.emplace(key, TokenBucket()).first->second;
+        }
+
+        // Waits for (Block) or throws without room in the target's mailbox
+        void reserve(const WorkerId& sender, Worker<T>& target, MailboxPolicy policy, WorkStealingPool* helper) {
+            using Admission = typename Mailbox<T>::Admission;
+            Mailbox<T>& mailbox = target.getMailboxRef();
+            Admission admission = mailbox.admit();
+            if (admission == Admission::Full && policy == MailboxPolicy::Block) {
+                count(sender, &ThrottleStats::blocked);
+                auto deadline = chrono::steady_clock::now() + chrono::milliseconds(admitTimeoutMs);
+                while (admission == Admission::Full && !agency.isClosing() && chrono::steady_clock::now() < deadline) {
+                    if (helper && helper->runOne()) admission = mailbox.admit();
+                    else admission = mailbox.admit(1);
+                }
+            }
+            if (admission != Admission::Full) return; // Closed: the router drops it
+            count(sender, &ThrottleStats::rejected);
+            throw ERROR("Mailbox of '" + target.getName() + "' is full, pack dropped.");
+        }
+
+        WorkerRegistry<T>& workers;
+        mutex& workers_mtx;
+        Scheduler<T>& scheduler;
+        const Closable& agency;
+
+        atomic<bool> limiting = false; // any bound or rate limit set
+        unordered_map<WorkerId, MailboxLimit> mailboxLimits; // needs workers_mtx
+        mutable mutex limits_mtx;
+        struct PairLimit {
+            WorkerId sender;
+            WorkerId recipient;
+            RateLimit limit;
+        };
+        unordered_map<uint64_t, PairLimit> rateLimits; // pair key => limit
+        unordered_map<uint64_t, TokenBucket> buckets; // pair key => bucket
+        unordered_map<WorkerId, ThrottleStats> throttles; // sender => stats
+    };
+
+}
@@ -0,0 +1,431 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "../utils/ERROR.hpp"
+#include "../utils/JSON.hpp"
+#include "../utils/files.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::agency {
+
+    /**
+     * Incremental save of an agency into a manifest file and segment files
+     * next to it, one per worker (the layout SaveCommand always used).
+     *
+     * A write rewrites the segments of the workers changed since the last
+     * write only. The append only part of a worker (see Worker::journal())
+     * goes to a journal file, one JSON per line, and a write appends the new
+     * entries only. Segments and started over journals go to new files,
+     * <name>.<generation>.json and <name>.<generation>.journal.jsonl, the
+     * files of the last manifest are only appended past the size it tells.
+     * The manifest is replaced last (tmp file + rename) and the files it no
+     * longer names are removed after, so a broken write reads back as the
+     * previous checkpoint.
+     */
+    class Checkpoint {
+    public:
+
+        static inline const string journalExtension = ".journal.jsonl";
+
+        // One worker of a capture (see Checkpointer::capture())
+        struct Segment {
+            string name;
+            uint64_t origin = 0; // see Worker::getOrigin()
+            uint64_t revision = 0;
+            bool dirty = true; // false: as in the last write, nothing else is set
+            JSON snapshot; // see Worker::toSnapshot()
+            string journalKey; // "": no journal
+            vector<JSON> entries; // the new journal entries
+            bool rewrite = false; // entries are the whole journal
+        };
+
+        // A consistent capture of an agency
+        struct Image {
+            JSON manifest; // the state of the agency itself
+            vector<Segment> segments;
+        };
+
+        // What a write did
+        struct Stats {
+            size_t written = 0; // segments rewritten
+            size_t kept = 0; // segments left as they were
+            size_t appended = 0; // journal entries added
+            size_t bytes = 0; // bytes written
+        };
+
+        Checkpoint(const string& filename): filename(filename) {}
+
+        const string& getFilename() const { return filename; }
+
+        // The revision of the worker in the last write, 0: not written
+        uint64_t getRevision(const string& name) const {
+            lock_guard<mutex> lock(mtx);
+            auto it = saved.find(name);
+            return it == saved.end() ? 0 : it->second.revision;
+        }
+
+        // The journal entries of the worker in the last write, 0 if it was
+        // an other worker by the name
+        size_t getEntries(const string& name, uint64_t origin) const {
+            lock_guard<mutex> lock(mtx);
+            auto it = saved.find(name);
+            return it == saved.end() || it->second.origin != origin ? 0 : it->second.entries;
+        }
+
+        // Marks the worker written as it is now (e.g. right after a read())
+        void setSaved(const string& name, uint64_t origin, uint64_t revision) {
+            lock_guard<mutex> lock(mtx);
+            auto it = saved.find(name);
+            if (it == saved.end()) return;
+            it->second.origin = origin;
+            it->second.revision = revision;
+        }
+
+        Stats write(const Image& image) {
+            lock_guard<mutex> lock(mtx);
+            if (!generation) generation = lastGeneration();
+            string version = "." + to_string(++generation);
+            Stats stats;
+            JSON manifest = image.manifest;
+            vector<string> fsegments;
+            map<string, JSON> jjournals;
+            map<string, Saved> written;
+            for (const Segment& segment: image.segments) {
+                Saved state = saved.count(segment.name) ? saved[segment.name] : Saved();
+                if (segment.dirty) {
+                    string content = segment.snapshot.dump(4);
+                    state.segmentFile = segment.name + version + ".json";
+                    file_put_contents(path(state.segmentFile), content, false, true);
+                    stats.bytes += content.size();
+                    if (!segment.journalKey.empty()) {
+                        bool restart = segment.rewrite || state.journalFile.empty();
+                        if (restart) {
+                            state.journalFile = segment.name + version + journalExtension;
+                            state.entries = state.bytes = 0;
+                        } else truncate(path(state.journalFile), state.bytes); // a broken write leaves a tail
+                        string lines;
+                        for (const JSON& entry: segment.entries) lines += entry.dump() + "\n";
+                        if (!lines.empty() || restart)
+                            file_put_contents(path(state.journalFile), lines, !restart, true);
+                        state.entries += segment.entries.size();
+                        state.bytes += lines.size();
+                        state.journalKey = segment.journalKey;
+                        stats.appended += segment.entries.size();
+                        stats.bytes += lines.size();
+                    }
+                    state.origin = segment.origin;
+                    state.revision = segment.revision;
+                    stats.written++;
+                } else {
+                    if (!saved.count(segment.name))
+                        throw ERROR("Worker '" + segment.name + "' is not in the checkpoint: " + filename);
+                    stats.kept++;
+                }
+                fsegments.push_back(state.segmentFile);
+                if (!state.journalKey.empty()) {
+                    JSON jjournal;
+                    jjournal.set("key", state.journalKey);
+                    jjournal.set("file", state.journalFile);
+                    jjournal.set("entries", state.entries);
+                    jjournal.set("bytes", state.bytes);
+                    jjournals[segment.name] = jjournal;
+                }
+                written[segment.name] = state;
+            }
+            manifest.set("workers", fsegments);
+            manifest.set("journals", jjournals);
+            manifest.set("generation", generation);
+            string content = manifest.dump(4);
+            replace(filename, content);
+            stats.bytes += content.size();
+
+            // the files of the last write that are replaced or of the workers gone since
+            for (const auto& [name, state]: saved) {
+                auto it = written.find(name);
+                if (it == written.end() || it->second.segmentFile != state.segmentFile) discard(state.segmentFile);
+                if (it == written.end() || it->second.journalFile != state.journalFile) discard(state.journalFile);
+            }
+            saved = written;
+            return stats;
+        }
+
+        // The agency JSON with the workers in it (see Agency::fromJSON()),
+        // the manifest of the former full saves reads too
+        JSON read() {
+            lock_guard<mutex> lock(mtx);
+            JSON manifest(file_get_contents(filename));
+            map<string, JSON> jjournals;
+            if (manifest.has("journals")) jjournals = manifest.get<map<string, JSON>>("journals");
+            generation = manifest.has("generation") ? manifest.get<uint64_t>("generation") : 0;
+            vector<JSON> jworkers;
+            saved.clear();
+            for (const string& fsegment: manifest.get<vector<string>>("workers")) {
+                JSON jworker(file_get_contents(locate(fsegment)));
+                string name = jworker.get<string>("name");
+                Saved state;
+                state.segmentFile = fsegment;
+                auto it = jjournals.find(name);
+                if (it != jjournals.end()) {
+                    const JSON& jjournal = it->second;
+                    state.journalKey = jjournal.get<string>("key");
+                    state.journalFile = jjournal.get<string>("file");
+                    state.entries = jjournal.get<size_t>("entries");
+                    state.bytes = jjournal.get<size_t>("bytes");
+                    jworker.set(state.journalKey, readJournal(path(state.journalFile), state));
+                }
+                saved[name] = state;
+                jworkers.push_back(jworker);
+            }
+            manifest.set("workers", jworkers);
+            return manifest;
+        }
+
+    private:
+
+        struct Saved {
+            uint64_t origin = 0;
+            uint64_t revision = 0;
+            size_t entries = 0;
+            size_t bytes = 0;
+            string journalKey;
+            string segmentFile;
+            string journalFile; // "": no journal
+        };
+
+        string path(const string& file) const {
+            return (fs::path(filename).parent_path() / file).string();
+        }
+
+        // Next to the manifest, or in the working directory where the former
+        // full saves put the segments
+        string locate(const string& file) const {
+            string next = path(file);
+            return !file_exists(next) && file_exists(file) ? file : next;
+        }
+
+        void discard(const string& file) const {
+            if (!file.empty() && file_exists(path(file))) remove(path(file), false);
+        }
+
+        // Of the manifest already there (written without a read() first),
+        // the new files never take the names it uses
+        uint64_t lastGeneration() const {
+            if (!file_exists(filename)) return 0;
+            try {
+                JSON manifest(file_get_contents(filename));
+                return manifest.has("generation") ? manifest.get<uint64_t>("generation") : 0;
+            } catch (exception &e) {
+                return 0;
+            }
+        }
+
+        // Writes a tmp file and renames it over, so the file is the old or the new
+        static void replace(const string& file, const string& content) {
+            string tmp = file + ".tmp";
+            file_put_contents(tmp, content, false, true);
+            rename(tmp, file, true);
+        }
+
+        static void truncate(const string& file, size_t bytes) {
+            if (file_exists(file) && fs::file_size(file) > bytes) fs::resize_file(file, bytes);
+        }
+
+        // The first state.entries lines of the journal (in state.bytes)
+        static vector<JSON> readJournal(const string& file, const Saved& state) {
+            string content = file_get_contents(file);
+            if (content.size() < state.bytes)
+                throw ERROR("Journal is shorter than the checkpoint: " + file);
+            vector<JSON> entries;
+            size_t start = 0;
+            while (entries.size() < state.entries) {
+                size_t end = content.find('\n', start);
+                if (end == string::npos || end >= state.bytes)
+                    throw ERROR("Journal is broken: " + file);
+                entries.push_back(JSON(content.substr(start, end - start)));
+                start = end + 1;
+            }
+            return entries;
+        }
+
+        string filename; // of the manifest
+        uint64_t generation = 0; // of the last write or read
+        map<string, Saved> saved; // worker => in the last write
+        mutable mutex mtx;
+    };
+
+}
+
+#ifdef TEST
+
+#include <algorithm>
+
+#include "../utils/Test.hpp"
+
+using namespace tools::agency;
+
+// A fresh directory for the checkpoint files
+string checkpoint_test_dir(const string& name) {
+    string dir = (fs::temp_directory_path() / ("test_Checkpoint_" + name)).string();
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+// The files in the checkpoint directory
+vector<string> checkpoint_test_files(const string& dir) {
+    vector<string> files;
+    for (const fs::directory_entry& entry: fs::directory_iterator(dir)) files.push_back(entry.path().filename().string());
+    sort(files.begin(), files.end());
+    return files;
+}
+
+Checkpoint::Segment checkpoint_test_segment(const string& name, uint64_t revision, const vector<string>& texts, bool rewrite = false) {
+    Checkpoint::Segment segment;
+    segment.name = name;
+    segment.origin = 1;
+    segment.revision = revision;
+    segment.snapshot.set("name", name);
+    segment.snapshot.set("revision", revision);
+    segment.journalKey = "history.messages";
+    for (const string& text: texts) {
+        JSON entry;
+        entry.set("text", text);
+        segment.entries.push_back(entry);
+    }
+    segment.rewrite = rewrite;
+    return segment;
+}
+
+void test_Checkpoint_write_read() {
+    string dir = checkpoint_test_dir("write_read");
+    Checkpoint checkpoint(dir + "/agency.json");
+    Checkpoint::Image image;
+    image.manifest.set("name", "agency");
+    image.segments.push_back(checkpoint_test_segment("alice", 1, { "a", "b" }));
+    Checkpoint::Stats stats = checkpoint.write(image);
+    assert(stats.written == 1 && stats.appended == 2 && "First write should write everything");
+    assert(checkpoint.getRevision("alice") == 1 && checkpoint.getEntries("alice", 1) == 2 && "Write should remember the worker");
+    assert(checkpoint.getEntries("alice", 2) == 0 && "Other worker by the name should start over");
+
+    Checkpoint reader(dir + "/agency.json");
+    JSON json = reader.read();
+    vector<JSON> jworkers = json.get<vector<JSON>>("workers");
+    assert(jworkers.size() == 1 && jworkers[0].get<string>("name") == "alice" && "Segment should read back");
+    vector<JSON> entries = jworkers[0].get<vector<JSON>>("history.messages");
+    assert(entries.size() == 2 && entries[1].get<string>("text") == "b" && "Journal should read back into its key");
+    reader.setSaved("alice", 5, 6);
+    assert(reader.getEntries("alice", 5) == 2 && reader.getRevision("alice") == 6 && "Read should remember the journal");
+}
+
+void test_Checkpoint_incremental() {
+    string dir = checkpoint_test_dir("incremental");
+    Checkpoint checkpoint(dir + "/agency.json");
+    Checkpoint::Image image;
+    image.segments.push_back(checkpoint_test_segment("alice", 1, { "a" }));
+    image.segments.push_back(checkpoint_test_segment("bob", 2, { "x" }));
+    checkpoint.write(image);
+
+    Checkpoint::Image next;
+    next.segments.push_back(checkpoint_test_segment("alice", 3, { "b", "c" }));
+    Checkpoint::Segment bob;
+    bob.name = "bob";
+    bob.dirty = false;
+    next.segments.push_back(bob);
+    Checkpoint::Stats stats = checkpoint.write(next);
+    assert(stats.written == 1 && stats.kept == 1 && stats.appended == 2 && "Clean worker should be kept");
+
+    JSON json = Checkpoint(dir + "/agency.json").read();
+    vector<JSON> jworkers = json.get<vector<JSON>>("workers");
+    assert(jworkers[0].get<vector<JSON>>("history.messages").size() == 3 && "New entries should be appended");
+    assert(jworkers[1].get<vector<JSON>>("history.messages").size() == 1 && "Kept worker should read back");
+
+    Checkpoint::Image gone;
+    gone.segments.push_back(checkpoint_test_segment("alice", 4, { "z" }, true));
+    checkpoint.write(gone);
+    json = Checkpoint(dir + "/agency.json").read();
+    jworkers = json.get<vector<JSON>>("workers");
+    assert(jworkers.size() == 1 && "Gone worker should not read back");
+    assert(checkpoint_test_files(dir) == vector<string>({ "agency.json", "alice.3.journal.jsonl", "alice.3.json" }) && "Replaced files and the files of a gone worker should be removed");
+    assert(jworkers[0].get<vector<JSON>>("history.messages").size() == 1 && "Rewrite should start the journal over");
+}
+
+void test_Checkpoint_broken_tail() {
+    string dir = checkpoint_test_dir("broken_tail");
+    Checkpoint checkpoint(dir + "/agency.json");
+    Checkpoint::Image image;
+    image.segments.push_back(checkpoint_test_segment("alice", 1, { "a" }));
+    checkpoint.write(image);
+    string fjournal = JSON(file_get_contents(dir + "/agency.json")).get<string>("journals.alice.file");
+    file_put_contents(dir + "/" + fjournal, "{\"text\":\"tor", true); // interrupted write
+    JSON json = Checkpoint(dir + "/agency.json").read();
+    assert(json.get<vector<JSON>>("workers")[0].get<vector<JSON>>("history.messages").size() == 1 && "Broken tail should be ignored");
+    Checkpoint::Image next;
+    next.segments.push_back(checkpoint_test_segment("alice", 2, { "b" }));
+    checkpoint.write(next);
+    json = Checkpoint(dir + "/agency.json").read();
+    vector<JSON> entries = json.get<vector<JSON>>("workers")[0].get<vector<JSON>>("history.messages");
+    assert(entries.size() == 2 && entries[1].get<string>("text") == "b" && "Next write should cut the broken tail");
+}
+
+void test_Checkpoint_interrupted_write() {
+    string dir = checkpoint_test_dir("interrupted_write");
+    Checkpoint checkpoint(dir + "/agency.json");
+    Checkpoint::Image image;
+    image.segments.push_back(checkpoint_test_segment("alice", 1, { "a", "b" }));
+    image.segments.push_back(checkpoint_test_segment("bob", 2, { "x" }));
+    checkpoint.write(image);
+
+    fs::create_directories(dir + "/agency.json.tmp"); // the manifest can't be written
+    Checkpoint::Image next;
+    next.segments.push_back(checkpoint_test_segment("alice", 3, { "z" }, true));
+    next.segments.push_back(checkpoint_test_segment("bob", 4, { "y" }));
+    bool thrown = false;
+    try {
+        checkpoint.write(next);
+    } catch (exception &e) {
+        thrown = true;
+    }
+    assert(thrown && "Write should fail without the manifest");
+    vector<JSON> jworkers = Checkpoint(dir + "/agency.json").read().get<vector<JSON>>("workers");
+    assert(jworkers[0].get<uint64_t>("revision") == 1 && jworkers[1].get<uint64_t>("revision") == 2 && "Segments should read back as in the last checkpoint");
+    vector<JSON> alice = jworkers[0].get<vector<JSON>>("history.messages");
+    vector<JSON> bob = jworkers[1].get<vector<JSON>>("history.messages");
+    assert(alice.size() == 2 && alice[1].get<string>("text") == "b" && bob.size() == 1 && "Journals should read back as in the last checkpoint");
+
+    fs::remove(dir + "/agency.json.tmp");
+    Checkpoint reader(dir + "/agency.json");
+    reader.read();
+    reader.write(next);
+    jworkers = Checkpoint(dir + "/agency.json").read().get<vector<JSON>>("workers");
+    assert(jworkers[0].get<vector<JSON>>("history.messages").size() == 1 && jworkers[1].get<vector<JSON>>("history.messages").size() == 2 && "Next write should go through");
+}
+
+void test_Checkpoint_read_legacy_full_save() {
+    string dir = checkpoint_test_dir("legacy");
+    string fworker = "test_Checkpoint_legacy_worker.json"; // the former saves put it in the working directory
+    JSON jworker;
+    jworker.set("name", "legacy");
+    file_put_contents(fworker, jworker.dump(), false, true);
+    JSON manifest;
+    manifest.set("name", "agency");
+    manifest.set("workers", vector<string>({ fworker }));
+    file_put_contents(dir + "/agency.json", manifest.dump(), false, true);
+    vector<JSON> jworkers = Checkpoint(dir + "/agency.json").read().get<vector<JSON>>("workers");
+    remove(fworker, false);
+    assert(jworkers.size() == 1 && jworkers[0].get<string>("name") == "legacy" && "Segment in the working directory should read");
+}
+
+TEST(test_Checkpoint_write_read);
+TEST(test_Checkpoint_incremental);
+TEST(test_Checkpoint_broken_tail);
+TEST(test_Checkpoint_interrupted_write);
+TEST(test_Checkpoint_read_legacy_full_save);
+
+#endif
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+#include "../utils/JSON.hpp"
+#include "Worker.hpp"
+#include "WorkerRegistry.hpp"
+#include "Checkpoint.hpp"
+#include "remote/RemoteWorker.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency::remote;
+
+namespace tools::agency {
+
+    /**
+     * Checkpoints of an agency and its workers, a Checkpoint per file (it
+     * knows what the file has), and the autosave thread writing one.
+     * Each worker is read between two handle()s (see Mailbox::hold()).
+     */
+    template<typename T>
+    class Checkpointer {
+    public:
+        typedef function<void(const string&)> ErrorHandler;
+
+        Checkpointer(
+            Worker<T>& agency,
+            WorkerRegistry<T>& workers,
+            mutex& workers_mtx,
+            ErrorHandler hoops
+        ):
+            agency(agency),
+            workers(workers),
+            workers_mtx(workers_mtx),
+            hoops(hoops)
+        {}
+
+        ~Checkpointer() {
+            setAutosave("", 0);
+        }
+
+        // Saves the agency into filename and a segment file per worker next
+        // to it, rewriting the workers changed since the last checkpoint
+        // only (see Checkpoint)
+        Checkpoint::Stats checkpoint(const string& filename) {
+            lock_guard<mutex> lock(checkpoint_mtx);
+            Checkpoint& checkpoint = checkpointOf(filename);
+            return checkpoint.write(capture(checkpoint));
+        }
+
+        // Loads a checkpoint (or a former full save) into the agency, the
+        // loaded workers count as saved
+        void restore(const string& filename) {
+            Checkpoint* checkpoint = nullptr;
+            {
+                lock_guard<mutex> lock(checkpoint_mtx);
+                checkpoint = &checkpointOf(filename);
+            }
+            JSON json = checkpoint->read();
+            agency.fromJSON(json); // unlocked, takes workers_mtx
+            lock_guard<mutex> workers_lock(workers_mtx);
+            for (const JSON& jworker: json.get<vector<JSON>>("workers")) {
+                Worker<T>* worker = workers.find(jworker.get<string>("name"));
+                if (worker) checkpoint->setSaved(worker->getName(), worker->getOrigin(), worker->getRevision());
+            }
+        }
+
+        // Checkpoints into filename every ms on a background thread (0:
+        // stops), errors go to hoops
+        void setAutosave(const string& filename, long ms) {
+            {
+                lock_guard<mutex> lock(autosave_mtx);
+                autosaving = false;
+            }
+            autosaved.notify_all();
+            if (autosaver.joinable()) autosaver.join();
+            lock_guard<mutex> lock(autosave_mtx);
+            autosaveFile = ms ? filename : "";
+            autosaveMs = ms;
+            if (!ms) return;
+            autosaving = true;
+            autosaver = thread([this, filename, ms]() {
+                unique_lock<mutex> lock(autosave_mtx);
+                while (!autosaved.wait_for(lock, chrono::milliseconds(ms), [this]() { return !autosaving; })) {
+                    lock.unlock();
+                    try {
+                        checkpoint(filename);
+                    } catch (exception &e) {
+                        hoops("Autosave error: " + string(e.what()));
+                    }
+                    lock.lock();
+                }
+            });
+        }
+
+        string getAutosaveFile() const {
+            lock_guard<mutex> lock(autosave_mtx);
+            return autosaveFile;
+        }
+
+        // 0: no autosave
+        long getAutosaveMs() const {
+            lock_guard<mutex> lock(autosave_mtx);
+            return autosaveMs;
+        }
+
+    private:
+
+        // Needs checkpoint_mtx
+        Checkpoint& checkpointOf(const string& filename) {
+            unique_ptr<Checkpoint>& checkpoint = checkpoints[filename];
+            if (!checkpoint) checkpoint = make_unique<Checkpoint>(filename);
+            return *checkpoint;
+        }
+
+        // The agency and its workers changed since the last write of the
+        // checkpoint (only their new journal entries), each worker held
+        // (see Mailbox::hold()) while it is read
+        Checkpoint::Image capture(const Checkpoint& checkpoint) {
+            vector<Worker<T>*> held;
+            {
+                lock_guard<mutex> lock(workers_mtx);
+                for (Worker<T>* worker: workers.all()) {
+                    if (worker->getName() == "user" || remote_of(worker)) continue;
+                    worker->getMailboxRef().enter(); // kill() waits for leave()
+                    held.push_back(worker);
+                }
+            }
+            Checkpoint::Image image;
+            exception_ptr error;
+            try {
+                image.manifest = agency.toSnapshot();
+            } catch (...) {
+                error = current_exception();
+            }
+            for (Worker<T>* worker: held) {
+                Mailbox<T>& mailbox = worker->getMailboxRef();
+                bool runner = mailbox.isRunner(); // called from its handle()
+                if (!runner) mailbox.hold();
+                try {
+                    if (!error) image.segments.push_back(segment(checkpoint, *worker));
+                } catch (...) {
+                    error = current_exception();
+                }
+                if (!runner) mailbox.release();
+                mailbox.leave();
+            }
+            if (error) rethrow_exception(error);
+            return image;
+        }
+
+        // Needs the worker held
+        static Checkpoint::Segment segment(const Checkpoint& checkpoint, const Worker<T>& worker) {
+            Checkpoint::Segment segment;
+            segment.name = worker.getName();
+            segment.origin = worker.getOrigin();
+            segment.revision = worker.getRevision();
+            if (checkpoint.getRevision(segment.name) == segment.revision) {
+                segment.dirty = false;
+                return segment;
+            }
+            segment.snapshot = worker.toSnapshot();
+            size_t from = checkpoint.getEntries(segment.name, segment.origin);
+            if (worker.journal(from, segment.entries, segment.journalKey) < from) {
+                segment.entries.clear(); // shrunk, starts over
+                worker.journal(0, segment.entries, segment.journalKey);
+                from = 0;
+            }
+            segment.rewrite = !from;
+            return segment;
+        }
+
+        Worker<T>& agency;
+        WorkerRegistry<T>& workers;
+        mutex& workers_mtx;
+        ErrorHandler hoops;
+
+        mutex checkpoint_mtx;
+        map<string, unique_ptr<Checkpoint>> checkpoints; // file => what it has
+
+        mutable mutex autosave_mtx;
+        condition_variable autosaved;
+        bool autosaving = false;
+        thread autosaver;
+        string autosaveFile;
+        long autosaveMs = 0;
+    };
+
+}
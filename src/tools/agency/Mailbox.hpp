@@ -0,0 +1,378 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <condition_variable>
+
+#include "Pack.hpp"
+#include "Throttle.hpp"
+
+using namespace std;
+
+namespace tools::agency {
+
+    /**
+     * The packs waiting for one worker, in arrival order per priority,
+     * the higher ones first.
+     *
+     * A mailbox is either idle or scheduled: post() tells the caller when
+     * it just became scheduled (so it has to get a drain run), take() turns
+     * it back to idle when it runs empty. So one run drains a mailbox at a
+     * time and the worker sees its packs one by one, in order.
+     *
+     * The thread of the worker can block in wait() until a pack arrives.
+     *
+     * A bounded mailbox (see setLimit()) drops its oldest pack of the
+     * lowest priority on post() with the DropOldest policy, the other policies are up to the sender
+     * side: admit() tells (or waits) if there is room. Senders passing at
+     * once may overshoot the capacity a little, it is a soft bound.
+     *
+     * hold() keeps the drain run out of the worker between two packs, so
+     * the state of the worker can be read consistently (see checkpoints).
+     */
+    template<typename T>
+    class Mailbox {
+    public:
+        enum class Admission { Admitted, Full, Closed };
+
+        // Returns true if the mailbox was idle and needs a drain run
+        bool post(Pack<T>&& pack) {
+            lock_guard<mutex> lock(mtx);
+            if (limit.capacity && limit.policy == MailboxPolicy::DropOldest && count >= limit.capacity) {
+                for (size_t lane = priorities; lane--;) {
+                    if (packs[lane].empty()) continue;
+                    packs[lane].pop_front();
+                    count--;
+                    dropped++;
+                    break;
+                }
+            }
+            packs[(size_t)pack.priority].push_back(move(pack));
+            count++;
+            posted++;
+            if (waiting) arrived.notify_all();
+            if (scheduled) return false;
+            scheduled = true;
+            return true;
+        }
+
+        // The next pack for the drain run, false (and idle) if there is none
+        bool take(Pack<T>& pack) {
+            unique_lock<mutex> lock(mtx);
+            if (handling) {
+                handling = false;
+                if (holds) released.notify_all();
+            }
+            released.wait(lock, [this]() { return !holds; });
+            if (!count) {
+                scheduled = false;
+                runner = thread::id();
+                idle.notify_all();
+                return false;
+            }
+            size_t lane = 0;
+            while (packs[lane].empty()) lane++;
+            pack = move(packs[lane].front());
+            packs[lane].pop_front();
+            count--;
+            runner = this_thread::get_id();
+            handling = true;
+            if (admitting) room.notify_all();
+            return true;
+        }
+
+        void clear() {
+            lock_guard<mutex> lock(mtx);
+            for (deque<Pack<T>>& lane: packs) lane.clear();
+            count = 0;
+            room.notify_all();
+        }
+
+        void setLimit(const MailboxLimit& limit) {
+            lock_guard<mutex> lock(mtx);
+            this->limit = limit;
+            room.notify_all();
+        }
+
+        MailboxLimit getLimit() const {
+            lock_guard<mutex> lock(mtx);
+            return limit;
+        }
+
+        // Sender side: keeps the mailbox alive (see waitIdle()) until leave()
+        void enter() {
+            lock_guard<mutex> lock(mtx);
+            admitting++;
+        }
+
+        void leave() {
+            lock_guard<mutex> lock(mtx);
+            admitting--;
+            if (!admitting) idle.notify_all();
+        }
+
+        // Sender side (between enter() and leave()): is there room for one
+        // more pack, waits up to ms for it with the Block policy
+        Admission admit(long ms = 0) {
+            unique_lock<mutex> lock(mtx);
+            auto ready = [this]() {
+                return closed || !limit.capacity || limit.policy == MailboxPolicy::DropOldest ||
+                    count < limit.capacity;
+            };
+            if (ms && limit.policy == MailboxPolicy::Block)
+                room.wait_for(lock, chrono::milliseconds(ms), ready);
+            if (closed) return Admission::Closed;
+            return ready() ? Admission::Admitted : Admission::Full;
+        }
+
+        // Waits for the running pack to be done and holds the next one
+        // back until release(), not from the drain run itself
+        void hold() {
+            unique_lock<mutex> lock(mtx);
+            holds++;
+            released.wait(lock, [this]() { return !handling; });
+        }
+
+        void release() {
+            lock_guard<mutex> lock(mtx);
+            holds--;
+            if (!holds) released.notify_all();
+        }
+
+        // Refuses the senders for good (the worker is going away)
+        void close() {
+            lock_guard<mutex> lock(mtx);
+            closed = true;
+            room.notify_all();
+        }
+
+        size_t getDropped() const {
+            lock_guard<mutex> lock(mtx);
+            return dropped;
+        }
+
+        // Blocks until the drain run ends and no sender is inside (give up
+        // after ms, 0 = never)
+        bool waitIdle(long ms = 0) {
+            unique_lock<mutex> lock(mtx);
+            auto done = [this]() { return !scheduled && !admitting; };
+            if (!ms) {
+                idle.wait(lock, done);
+                return true;
+            }
+            return idle.wait_for(lock, chrono::milliseconds(ms), done);
+        }
+
+        // Blocks until a post since the last wait(), ms passes (0 = no
+        // timeout) or interrupt is set (see notify()), true if not timed out
+        bool wait(long ms, const atomic<bool>& interrupt) {
+            unique_lock<mutex> lock(mtx);
+            auto ready = [&]() { return posted != seen || interrupt.load(); };
+            waiting++;
+            bool woken = true;
+            if (!ms) arrived.wait(lock, ready);
+            else woken = arrived.wait_for(lock, chrono::milliseconds(ms), ready);
+            waiting--;
+            seen = posted;
+            return woken;
+        }
+
+        // Wakes wait() up to check its interrupt flag
+        void notify() {
+            lock_guard<mutex> lock(mtx);
+            arrived.notify_all();
+        }
+
+        bool isScheduled() const {
+            lock_guard<mutex> lock(mtx);
+            return scheduled;
+        }
+
+        // The calling thread is inside the drain run
+        bool isRunner() const {
+            lock_guard<mutex> lock(mtx);
+            return scheduled && runner == this_thread::get_id();
+        }
+
+        size_t size() const {
+            lock_guard<mutex> lock(mtx);
+            return count;
+        }
+
+    private:
+        mutable mutex mtx;
+        condition_variable idle;
+        condition_variable arrived;
+        condition_variable room;
+        condition_variable released;
+        array<deque<Pack<T>>, priorities> packs; // by priority
+        size_t count = 0;
+        MailboxLimit limit;
+        size_t dropped = 0;
+        int admitting = 0;
+        int holds = 0;
+        bool handling = false; // a taken pack is in the worker
+        bool closed = false;
+        bool scheduled = false;
+        thread::id runner;
+        uint64_t posted = 0;
+        uint64_t seen = 0;
+        int waiting = 0;
+    };
+
+}
+
+#ifdef TEST
+
+#include "../utils/Test.hpp"
+
+using namespace tools::agency;
+
+void test_Mailbox_post_take_order() {
+    Mailbox<string> mailbox;
+    assert(mailbox.post(Pack<string>("alice", "bob", "1")) && "First post should schedule");
+    assert(!mailbox.post(Pack<string>("alice", "bob", "2")) && "Scheduled mailbox shouldn't be scheduled again");
+    assert(mailbox.size() == 2 && mailbox.isScheduled() && "Packs should wait in the mailbox");
+    Pack<string> pack;
+    assert(mailbox.take(pack) && pack.item == "1" && "Packs should come in order");
+    assert(mailbox.isRunner() && "Taking thread should be the runner");
+    assert(mailbox.take(pack) && pack.item == "2" && "Packs should come in order");
+    assert(!mailbox.take(pack) && !mailbox.isScheduled() && "Empty mailbox should go idle");
+    assert(mailbox.waitIdle(1) && "Idle mailbox shouldn't wait");
+    assert(mailbox.post(Pack<string>("alice", "bob", "3")) && "Idle mailbox should be scheduled again");
+}
+
+void test_Mailbox_clear_waitIdle() {
+    Mailbox<string> mailbox;
+    mailbox.post(Pack<string>("alice", "bob", "1"));
+    mailbox.post(Pack<string>("alice", "bob", "2"));
+    mailbox.clear();
+    assert(mailbox.size() == 0 && mailbox.isScheduled() && "Clear should keep the drain run");
+    assert(!mailbox.waitIdle(1) && "Scheduled mailbox should time out");
+    thread drain([&mailbox]() {
+        Pack<string> pack;
+        while (mailbox.take(pack));
+    });
+    assert(mailbox.waitIdle() && "Wait should return when the run ends");
+    drain.join();
+    assert(!mailbox.isRunner() && "Idle mailbox has no runner");
+}
+
+void test_Mailbox_wait() {
+    Mailbox<string> mailbox;
+    atomic<bool> interrupt = false;
+    assert(!mailbox.wait(1, interrupt) && "Wait without posts should time out");
+    mailbox.post(Pack<string>("alice", "bob", "1"));
+    assert(mailbox.wait(0, interrupt) && "Post before the wait shouldn't be lost");
+    assert(!mailbox.wait(1, interrupt) && "A post should wake one wait only");
+    thread poster([&mailbox]() {
+        this_thread::sleep_for(chrono::milliseconds(5));
+        mailbox.post(Pack<string>("alice", "bob", "2"));
+    });
+    assert(mailbox.wait(0, interrupt) && "Post should wake the wait");
+    poster.join();
+    thread closer([&]() {
+        this_thread::sleep_for(chrono::milliseconds(5));
+        interrupt = true;
+        mailbox.notify();
+    });
+    assert(mailbox.wait(0, interrupt) && "Interrupt should wake the wait");
+    closer.join();
+}
+
+void test_Mailbox_drop_oldest() {
+    Mailbox<string> mailbox;
+    mailbox.setLimit({ 2, MailboxPolicy::DropOldest });
+    for (string item: { "1", "2", "3", "4" }) mailbox.post(Pack<string>("alice", "bob", item));
+    assert(mailbox.size() == 2 && mailbox.getDropped() == 2 && "Full mailbox should drop the oldest");
+    assert(mailbox.admit() == Mailbox<string>::Admission::Admitted && "Dropping mailbox should admit");
+    Pack<string> pack;
+    assert(mailbox.take(pack) && pack.item == "3" && "Newest packs should be kept");
+}
+
+void test_Mailbox_priorities() {
+    Mailbox<string> mailbox;
+    mailbox.post(Pack<string>("agent", "bob", "b1", Priority::Background));
+    mailbox.post(Pack<string>("agent", "bob", "n1"));
+    mailbox.post(Pack<string>("user", "bob", "i1", Priority::Interactive));
+    mailbox.post(Pack<string>("agent", "bob", "n2"));
+    string order;
+    Pack<string> pack;
+    while (mailbox.take(pack)) order += pack.item.get() + ",";
+    assert(order == "i1,n1,n2,b1," && "Higher priority packs should be taken first, in order");
+    mailbox.setLimit({ 2, MailboxPolicy::DropOldest });
+    mailbox.post(Pack<string>("user", "bob", "i", Priority::Interactive));
+    mailbox.post(Pack<string>("agent", "bob", "b", Priority::Background));
+    mailbox.post(Pack<string>("agent", "bob", "n"));
+    order = "";
+    while (mailbox.take(pack)) order += pack.item.get() + ",";
+    assert(order == "i,n," && "Full mailbox should drop the lowest priority first");
+}
+
+void test_Mailbox_admit_block_reject() {
+    Mailbox<string> mailbox;
+    mailbox.setLimit({ 1, MailboxPolicy::Reject });
+    assert(mailbox.admit() == Mailbox<string>::Admission::Admitted && "Empty mailbox should admit");
+    mailbox.post(Pack<string>("alice", "bob", "1"));
+    assert(mailbox.admit(5) == Mailbox<string>::Admission::Full && "Full mailbox should reject at once");
+    mailbox.setLimit({ 1, MailboxPolicy::Block });
+    assert(mailbox.admit(1) == Mailbox<string>::Admission::Full && "Full mailbox should time out");
+    mailbox.enter();
+    thread taker([&mailbox]() {
+        this_thread::sleep_for(chrono::milliseconds(5));
+        Pack<string> pack;
+        mailbox.take(pack);
+    });
+    assert(mailbox.admit(1000) == Mailbox<string>::Admission::Admitted && "Take should make room");
+    taker.join();
+    Pack<string> pack;
+    mailbox.take(pack);
+    assert(!mailbox.waitIdle(1) && "Entered sender should keep the mailbox busy");
+    mailbox.leave();
+    assert(mailbox.waitIdle(1) && "Left mailbox should be idle");
+    mailbox.close();
+    assert(mailbox.admit() == Mailbox<string>::Admission::Closed && "Closed mailbox should refuse");
+}
+
+void test_Mailbox_hold() {
+    Mailbox<string> mailbox;
+    mailbox.post(Pack<string>("alice", "bob", "1"));
+    mailbox.post(Pack<string>("alice", "bob", "2"));
+    atomic<int> handled = 0;
+    atomic<bool> holding = false;
+    Pack<string> pack;
+    mailbox.take(pack);
+    thread drain([&]() {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        handled++; // the running pack
+        Pack<string> next;
+        while (mailbox.take(next)) {
+            assert(!holding && "Held mailbox shouldn't hand out packs");
+            handled++;
+        }
+    });
+    mailbox.hold();
+    holding = true;
+    assert(handled == 1 && "Hold should wait for the running pack");
+    this_thread::sleep_for(chrono::milliseconds(10));
+    assert(handled == 1 && "Hold should keep the next pack back");
+    holding = false;
+    mailbox.release();
+    drain.join();
+    assert(handled == 2 && "Released mailbox should go on");
+}
+
+TEST(test_Mailbox_post_take_order);
+TEST(test_Mailbox_clear_waitIdle);
+TEST(test_Mailbox_wait);
+TEST(test_Mailbox_drop_oldest);
+TEST(test_Mailbox_priorities);
+TEST(test_Mailbox_admit_block_reject);
+TEST(test_Mailbox_hold);
+
+#endif
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <string>
+#include <variant>
+#include <ostream>
+#include <optional>
+#include <type_traits>
+
+#include "../utils/ERROR.hpp"
+#include "../utils/JSON.hpp"
+#include "../utils/Streamable.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::agency {
+
+    // Tells the agency what to do (was the "exit" and "list" strings)
+    enum class Control { Exit, List };
+
+    struct Text {
+        Text(const string& text = ""): text(text) {}
+        Text(const char* text): text(text) {}
+        string text;
+        bool operator==(const Text&) const = default;
+    };
+
+    // The arguments are parsed once, by the sender
+    struct ToolCall {
+        string id;
+        string name;
+        json arguments = json::object();
+        bool operator==(const ToolCall&) const = default;
+    };
+
+    struct ToolResult {
+        string id; // of the call
+        json result;
+        bool error = false;
+        bool operator==(const ToolResult&) const = default;
+    };
+
+    // Points into an audio file instead of carrying the samples
+    struct AudioRef {
+        string path;
+        double sampleRate = 16000;
+        size_t offset = 0; // in frames
+        size_t frames = 0; // 0: to the end
+        bool operator==(const AudioRef&) const = default;
+    };
+
+    /**
+     * Typed item for Worker<Message>: handle() dispatches on the
+     * alternative with std::visit (see overloaded) instead of comparing
+     * strings, a control message costs no allocation.
+     */
+    using Message = variant<Control, Text, ToolCall, ToolResult, AudioRef>;
+
+    // visit(overloaded{ [](const Text&) {...}, [](const auto&) {...} }, message)
+    template<typename... Fs>
+    struct overloaded: Fs... { using Fs::operator()...; };
+
+    template<typename... Fs>
+    overloaded(Fs...) -> overloaded<Fs...>;
+
+    inline const char* control_name(Control control) {
+        switch (control) {
+            case Control::Exit: return "exit";
+            case Control::List: return "list";
+        }
+        throw ERROR("Unknown control: " + to_string((int)control));
+    }
+
+    inline optional<Control> control_parse(const string& name) {
+        if (name == "exit") return Control::Exit;
+        if (name == "list") return Control::List;
+        return nullopt;
+    }
+
+    // The control message in an item, if any (a string item is one by its name)
+    inline optional<Control> control_of(const string& item) {
+        return control_parse(item);
+    }
+
+    inline optional<Control> control_of(const Message& item) {
+        if (const Control* control = get_if<Control>(&item)) return *control;
+        return nullopt;
+    }
+
+    template<typename T>
+    optional<Control> control_of(const T&) {
+        return nullopt;
+    }
+
+    // A control message as an item of type T
+    template<typename T>
+    T control_item(Control control) {
+        if constexpr (is_constructible_v<T, Control>) return T(control);
+        else return T(control_name(control));
+    }
+
+    // ----- ostream (dump() needs T Streamable) -----
+
+    inline ostream& operator<<(ostream& os, Control control) {
+        return os << control_name(control);
+    }
+
+    inline ostream& operator<<(ostream& os, const Text& text) {
+        return os << text.text;
+    }
+
+    inline ostream& operator<<(ostream& os, const ToolCall& call) {
+        return os << "call " << call.name << "#" << call.id << " " << call.arguments.dump();
+    }
+
+    inline ostream& operator<<(ostream& os, const ToolResult& result) {
+        return os << (result.error ? "error #" : "result #") << result.id << " " << result.result.dump();
+    }
+
+    inline ostream& operator<<(ostream& os, const AudioRef& audio) {
+        os << "audio " << audio.path << " @" << audio.sampleRate << "Hz [" << audio.offset;
+        if (audio.frames) os << "+" << audio.frames;
+        return os << "]";
+    }
+
+    inline ostream& operator<<(ostream& os, const Message& message) {
+        visit([&os](const auto& alternative) { os << alternative; }, message);
+        return os;
+    }
+
+}
+
+// ----- JSON (see remote::Codec and PackRecorder) -----
+
+namespace nlohmann {
+    template<>
+    struct adl_serializer<tools::agency::Message> {
+        static tools::agency::Message from_json(const json& j) {
+            using namespace tools::agency;
+            string type = j.at("type").get<string>();
+            if (type == "control") {
+                optional<Control> control = control_parse(j.at("control").get<string>());
+                if (!control) throw ERROR("Unknown control: " + j.at("control").dump());
+                return *control;
+            }
+            if (type == "text") return Text(j.at("text").get<string>());
+            if (type == "tool_call") return ToolCall{ j.at("id"), j.at("name"), j.value("arguments", json::object()) };
+            if (type == "tool_result") return ToolResult{ j.at("id"), j.value("result", json()), j.value("error", false) };
+            if (type == "audio") return AudioRef{ j.at("path"), j.value("sampleRate", 16000.0), j.value("offset", (size_t)0), j.value("frames", (size_t)0) };
+            throw ERROR("Unknown message type: " + type);
+        }
+
+        static void to_json(json& j, const tools::agency::Message& message) {
+            using namespace tools::agency;
+            j = visit(overloaded{
+                [](Control control) -> json { return { { "type", "control" }, { "control", control_name(control) } }; },
+                [](const Text& text) -> json { return { { "type", "text" }, { "text", text.text } }; },
+                [](const ToolCall& call) -> json { return { { "type", "tool_call" }, { "id", call.id }, { "name", call.name }, { "arguments", call.arguments } }; },
+                [](const ToolResult& result) -> json { return { { "type", "tool_result" }, { "id", result.id }, { "result", result.result }, { "error", result.error } }; },
+                [](const AudioRef& audio) -> json { return { { "type", "audio" }, { "path", audio.path }, { "sampleRate", audio.sampleRate }, { "offset", audio.offset }, { "frames", audio.frames } }; },
+            }, message);
+        }
+    };
+}
+
+#ifdef TEST
+
+#include <sstream>
+
+#include "../utils/Test.hpp"
+
+using namespace tools::agency;
+
+void test_Message_visit_dispatch() {
+    vector<Message> messages = {
+        Control::Exit,
+        Text("hello"),
+        ToolCall{ "1", "weather", { { "city", "Budapest" } } },
+        ToolResult{ "1", { { "celsius", 21 } } },
+        AudioRef{ "in.wav" },
+    };
+    string seen;
+    for (const Message& message: messages)
+        visit(overloaded{
+            [&](Control control) { seen += string("C:") + control_name(control) + ","; },
+            [&](const Text& text) { seen += "T:" + text.text + ","; },
+            [&](const ToolCall& call) { seen += "TC:" + call.arguments["city"].get<string>() + ","; },
+            [&](const ToolResult& result) { seen += "TR:" + to_string(result.result["celsius"].get<int>()) + ","; },
+            [&](const AudioRef& audio) { seen += "A:" + audio.path; },
+        }, message);
+    assert(seen == "C:exit,T:hello,TC:Budapest,TR:21,A:in.wav" && "Each alternative should get its own handler");
+}
+
+void test_Message_streamable() {
+    static_assert(Streamable<Message>, "Message should be Streamable for dump()");
+    stringstream ss;
+    ss << Message(Control::List) << "|" << Message(Text("hi")) << "|" << Message(ToolCall{ "7", "sum", { 1, 2 } }) << "|" << Message(AudioRef{ "a.wav", 8000, 10, 20 });
+    assert(ss.str() == "list|hi|call sum#7 [1,2]|audio a.wav @8000Hz [10+20]" && "Messages should print");
+}
+
+void test_Message_control_of() {
+    assert(control_of(string("exit")) == Control::Exit && "Legacy string should be a control");
+    assert(!control_of(string("hello")) && "Other strings should not be controls");
+    assert(control_of(Message(Control::List)) == Control::List && "Control alternative should be a control");
+    assert(!control_of(Message(Text("exit"))) && "Text should never be a control");
+    assert(control_item<string>(Control::Exit) == "exit" && "String item should be the name");
+    assert(control_item<Message>(Control::Exit) == Message(Control::Exit) && "Message item should be the control");
+}
+
+void test_Message_json_roundtrip() {
+    vector<Message> messages = {
+        Control::Exit,
+        Text("hello"),
+        ToolCall{ "1", "weather", { { "city", "Budapest" } } },
+        ToolResult{ "1", "failed", true },
+        AudioRef{ "in.wav", 44100, 5, 0 },
+    };
+    for (const Message& message: messages) {
+        Message decoded = json::parse(json(message).dump()).get<Message>();
+        assert(decoded == message && "Message should survive JSON");
+    }
+    bool thrown = false;
+    try {
+        json({ { "type", "nope" } }).get<Message>();
+    } catch (exception &e) {
+        thrown = true;
+    }
+    assert(thrown && "Unknown type should throw");
+}
+
+TEST(test_Message_visit_dispatch);
+TEST(test_Message_streamable);
+TEST(test_Message_control_of);
+TEST(test_Message_json_roundtrip);
+
+#endif
@@ -1,22 +1,52 @@
 #pragma once
 
+#include <string>
+#include <cstdint>
+
+#include "../utils/ERROR.hpp"
 #include "../utils/Streamable.hpp"
+#include "WorkerId.hpp"
+#include "Payload.hpp"
 
 using namespace tools::utils;
 
 namespace tools::agency {
 
+    // Lane of a pack in the queue and the mailboxes (see PackQueue),
+    // the user waits for the interactive ones
+    enum class Priority: uint8_t { Interactive, Normal, Background };
+
+    static const size_t priorities = 3;
+
+    inline const char* priority_name(Priority priority) {
+        switch (priority) {
+            case Priority::Interactive: return "interactive";
+            case Priority::Normal: return "normal";
+            case Priority::Background: return "background";
+        }
+        return "unknown";
+    }
+
+    inline Priority to_priority(const string& name) {
+        if (name == "interactive") return Priority::Interactive;
+        if (name == "normal") return Priority::Normal;
+        if (name == "background") return Priority::Background;
+        throw ERROR("Invalid priority: " + name);
+    }
+
     template<typename T>
     class Pack {
     public:
-        Pack(const string& sender = "", const string& recipient = "", T item = T()): sender(sender), recipient(recipient), item(item) {}
-        string sender;
-        string recipient;
-        T item;
+        Pack(WorkerId sender = WorkerId(), WorkerId recipient = WorkerId(), Payload<T> item = Payload<T>(), Priority priority = Priority::Normal): sender(sender), recipient(recipient), item(move(item)), priority(priority) {}
+        WorkerId sender; // routed by id, see WorkerId
+        WorkerId recipient;
+        Payload<T> item; // shared by the packs of a broadcast
+        Priority priority = Priority::Normal;
+        uint64_t trace = 0; // id in the trace (see Tracer), 0: not traced
 
         void dump(ostream& os = cout) const {
             os << "Pack[sender: " << sender << ", recipient: " << recipient << ", item: ";
-            if constexpr (has_ostream<T>::value) os << item;
+            if constexpr (has_ostream<T>::value) os << item.get();
             else os << "(unprintable)";
             os << "]";
         }
@@ -45,6 +75,7 @@ void test_Pack_constructor_default() {
     assert(actual_sender == "" && "Default sender should be empty");
     assert(actual_recipient == "" && "Default recipient should be empty");
     assert(actual_item == "" && "Default item should be empty string");
+    assert(pack.priority == Priority::Normal && "Default priority should be normal");
 }
 
 // Test constructor with arguments
@@ -75,9 +106,22 @@ void test_Pack_dump_non_streamable() {
 }
 
 // Register tests
+void test_Priority_names() {
+    for (Priority priority: { Priority::Interactive, Priority::Normal, Priority::Background })
+        assert(to_priority(priority_name(priority)) == priority && "Priority names should round trip");
+    bool thrown = false;
+    try {
+        to_priority("urgent");
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Unknown priority should throw");
+}
+
 TEST(test_Pack_constructor_default);
 TEST(test_Pack_constructor_with_args);
 TEST(test_Pack_dump_streamable);
 TEST(test_Pack_dump_non_streamable);
+TEST(test_Priority_names);
 
 #endif
\ No newline at end of file
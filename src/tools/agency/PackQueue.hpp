@@ -1,35 +1,316 @@
 #pragma once
 
-#include "../../../libs/K-Adam/SafeQueue/SafeQueue.hpp"
+#include <array>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
 
+#include "../utils/Tracer.hpp"
 #include "Pack.hpp"
+#include "PackRecorder.hpp"
+
+using namespace std;
 
 namespace tools::agency {
 
+    // How Consume() picks the lane (priority) to take the next pack from:
+    // Strict: the highest non-empty one, lower lanes wait while it lasts
+    // WeightedFair: a round gives each lane up to its weight of packs,
+    // higher lanes first, so the background still moves under load
+    enum class LanePolicy { Strict, WeightedFair };
+
+    typedef array<size_t, priorities> LaneWeights;
+
+    /**
+     * Thread safe FIFO of packs per priority lane, segmented by recipient.
+     *
+     * Every recipient id has its own linked sub-queue (segment) in each
+     * lane, and a ticket per pack keeps the arrival order of the lane for
+     * Consume(). drop() unlinks the segments of the recipient in O(1) and
+     * bumps their generation, which turns their tickets stale (Consume()
+     * skips them). Nodes come from a free list and go back to it, so a
+     * steady flow of packs doesn't allocate.
+     */
     template<typename T>
-    class PackQueue: public SafeQueue<Pack<T>> {
+    class PackQueue {
     public:
-        void drop(const string& recipient) {
-            unique_lock<mutex> lock(this->mtx); // Access the mutex from SafeQueue
-
-            queue<Pack<T>> temp; // Temporary queue for filtered items
-            while (!this->q.empty()) {
-                Pack<T> pack = move(this->q.front());
-                this->q.pop();
-                if (pack.recipient != recipient) {
-                    temp.push(move(pack)); // Keep packs that don't match
+        typedef size_t size_type;
+
+        // packs per round of the interactive, normal and background lanes
+        static constexpr LaneWeights defaultWeights = { 16, 4, 1 };
+
+        PackQueue() {}
+
+        ~PackQueue() {
+            Finish();
+            for (Segment& segment: segments) release(segment.head);
+            release(pool);
+        }
+
+        PackQueue(const PackQueue&) = delete;
+        PackQueue& operator=(const PackQueue&) = delete;
+
+        void Produce(Pack<T>&& pack) {
+            pack.trace = Tracer::on() ? Tracer::nextId() : 0;
+            TraceSpan span("pack", "enqueue", pack.recipient.name().c_str(), pack.trace);
+            if (pack.trace) Tracer::instance().flow('s', pack.trace);
+            {
+                lock_guard<mutex> lock(mtx);
+                if (recorder) recorder->record(pack); // in queue order
+                Node* node = allocate();
+                node->pack = move(pack);
+                size_t lane = (size_t)node->pack.priority;
+                uint32_t index = (uint32_t)(node->pack.recipient.value() * priorities + lane);
+                if (index >= segments.size()) segments.resize(index - lane + priorities);
+                Segment& segment = segments[index];
+                if (segment.tail) segment.tail->next = node;
+                else segment.head = node;
+                segment.tail = node;
+                segment.count++;
+                lanes[lane].push_back({ index, segment.generation });
+                counts[lane]++;
+                size++;
+                if (waiting) arrived.notify_all();
+            }
+            cv.notify_one();
+        }
+
+        // Logs every produced pack into the recorder (nullptr: stops),
+        // keep it alive until stopped
+        void setRecorder(PackRecorder<T>* recorder) {
+            lock_guard<mutex> lock(mtx);
+            this->recorder = recorder;
+        }
+
+        // Logs the produced packs into filename from now on with a
+        // recorder of its own ("": stops), see PackReplay
+        void record(const string& filename) {
+            unique_ptr<PackRecorder<T>> old; // flushed unlocked
+            unique_ptr<PackRecorder<T>> started;
+            if (!filename.empty()) started = make_unique<PackRecorder<T>>(filename);
+            lock_guard<mutex> lock(mtx);
+            old = move(recording);
+            recording = move(started);
+            recorder = recording.get();
+        }
+
+        // Packs logged by the running record()
+        size_t getRecorded() {
+            lock_guard<mutex> lock(mtx);
+            return recording ? recording->getCount() : 0;
+        }
+
+        size_type Size() {
+            lock_guard<mutex> lock(mtx);
+            return size;
+        }
+
+        size_type Size(Priority priority) {
+            lock_guard<mutex> lock(mtx);
+            return counts[(size_t)priority];
+        }
+
+        // weights: packs per round of each lane (WeightedFair only)
+        void setLanePolicy(LanePolicy policy, const LaneWeights& weights = defaultWeights) {
+            lock_guard<mutex> lock(mtx);
+            this->policy = policy;
+            this->weights = weights;
+            credits = weights;
+        }
+
+        LanePolicy getLanePolicy() {
+            lock_guard<mutex> lock(mtx);
+            return policy;
+        }
+
+        [[nodiscard]] bool Consume(Pack<T>& pack) {
+            lock_guard<mutex> lock(mtx);
+            return take(pack);
+        }
+
+        // Blocks until there is a pack or Finish() is called
+        [[nodiscard]] bool ConsumeSync(Pack<T>& pack) {
+            unique_lock<mutex> lock(mtx);
+            sync_counter++;
+            cv.wait(lock, [&] { return size || finish_processing; });
+            bool taken = take(pack);
+            if (--sync_counter == 0) sync_wait.notify_one();
+            return taken;
+        }
+
+        // Blocks until there is a pack, ms passes (0 = no timeout) or
+        // interrupt() is true (see notify()), true if not timed out
+        template<typename Interrupt>
+        bool waitFor(long ms, Interrupt interrupt) {
+            unique_lock<mutex> lock(mtx);
+            auto ready = [&]() { return size || interrupt(); };
+            waiting++;
+            bool woken = true;
+            if (!ms) arrived.wait(lock, ready);
+            else woken = arrived.wait_for(lock, chrono::milliseconds(ms), ready);
+            waiting--;
+            return woken;
+        }
+
+        // Wakes waitFor() up to check its interrupt
+        void notify() {
+            lock_guard<mutex> lock(mtx);
+            arrived.notify_all();
+        }
+
+        // Wakes up (and waits out) the ConsumeSync() callers
+        void Finish() {
+            unique_lock<mutex> lock(mtx);
+            finish_processing = true;
+            cv.notify_all();
+            sync_wait.wait(lock, [&]() { return sync_counter == 0; });
+            finish_processing = false;
+        }
+
+        // Drops every queued pack of the recipient, producers wait
+        // only for the unlink, the packs are released outside the lock
+        void drop(const WorkerId& recipient) {
+            Node* head = nullptr;
+            Node* tail = nullptr;
+            {
+                lock_guard<mutex> lock(mtx);
+                size_t first = (size_t)recipient.value() * priorities;
+                for (size_t lane = 0; lane < priorities && first + lane < segments.size(); lane++) {
+                    Segment& segment = segments[first + lane];
+                    if (!segment.head) continue;
+                    if (tail) tail->next = segment.head;
+                    else head = segment.head;
+                    tail = segment.tail;
+                    size -= segment.count;
+                    counts[lane] -= segment.count;
+                    segment.head = segment.tail = nullptr;
+                    segment.count = 0;
+                    segment.generation++;
                 }
+                if (!head) return;
+            }
+            for (Node* node = head; node; node = node->next) node->pack = Pack<T>();
+            lock_guard<mutex> lock(mtx);
+            tail->next = pool;
+            pool = head;
+        }
+
+        // Nodes waiting in the free list for reuse
+        size_t getPooled() {
+            lock_guard<mutex> lock(mtx);
+            size_t count = 0;
+            for (Node* node = pool; node; node = node->next) count++;
+            return count;
+        }
+
+    private:
+        struct Node {
+            Pack<T> pack;
+            Node* next = nullptr;
+        };
+
+        struct Segment {
+            Node* head = nullptr;
+            Node* tail = nullptr;
+            size_t count = 0;
+            uint32_t generation = 0;
+        };
+
+        struct Ticket {
+            uint32_t segment; // recipient id * priorities + lane
+            uint32_t generation;
+        };
+
+        // Needs the lock
+        bool take(Pack<T>& pack) {
+            int lane = pick();
+            if (lane < 0) return false;
+            Ticket ticket = lanes[lane].front();
+            lanes[lane].pop_front();
+            if (credits[lane]) credits[lane]--;
+            Segment& segment = segments[ticket.segment];
+            Node* node = segment.head;
+            segment.head = node->next;
+            if (!segment.head) segment.tail = nullptr;
+            segment.count--;
+            counts[lane]--;
+            size--;
+            pack = move(node->pack);
+            node->next = pool;
+            pool = node;
+            return true;
+        }
+
+        // The lane of the next pack, -1 if there is none, needs the lock
+        int pick() {
+            if (policy == LanePolicy::WeightedFair) {
+                for (size_t lane = 0; lane < priorities; lane++)
+                    if (credits[lane] && ready(lane)) return (int)lane;
+                credits = weights; // the round is over
             }
-            this->q = move(temp); // Replace the original queue
+            for (size_t lane = 0; lane < priorities; lane++)
+                if (ready(lane)) return (int)lane;
+            return -1;
+        }
+
+        // Skips the stale (dropped) tickets, true if a pack is left
+        bool ready(size_t lane) {
+            deque<Ticket>& tickets = lanes[lane];
+            while (!tickets.empty() && tickets.front().generation != segments[tickets.front().segment].generation)
+                tickets.pop_front();
+            return !tickets.empty();
+        }
+
+        Node* allocate() {
+            if (!pool) return new Node();
+            Node* node = pool;
+            pool = node->next;
+            node->next = nullptr;
+            return node;
         }
 
+        static void release(Node* node) {
+            while (node) {
+                Node* next = node->next;
+                delete node;
+                node = next;
+            }
+        }
+
+        mutex mtx;
+        condition_variable cv;
+        condition_variable sync_wait;
+        condition_variable arrived;
+        bool finish_processing = false;
+        int sync_counter = 0;
+        int waiting = 0;
+
+        vector<Segment> segments; // by recipient id and lane
+        array<deque<Ticket>, priorities> lanes; // by priority
+        array<size_t, priorities> counts = {};
+        LanePolicy policy = LanePolicy::Strict;
+        LaneWeights weights = defaultWeights;
+        LaneWeights credits = defaultWeights; // left in the round
+        Node* pool = nullptr;
+        size_t size = 0;
+        PackRecorder<T>* recorder = nullptr;
+        unique_ptr<PackRecorder<T>> recording; // see record()
     };
 
 }
 
 #ifdef TEST
 
+#include <cstdio>
+#include <unistd.h>
+
 #include "../utils/Test.hpp"
+#include "../containers/vector_equal.hpp"
 #include "tests/helpers.hpp"
 
 using namespace tools::agency;
@@ -83,10 +364,166 @@ void test_PackQueue_drop_multiple_mixed() {
     // Optionally use vector_equal if available: assert(vector_equal(actual_contents, expected_contents) && "Contents should match expected");
 }
 
+// Test order across recipients after a drop and a re-produce
+void test_PackQueue_drop_keeps_order() {
+    PackQueue<string> pq;
+    pq.Produce(Pack<string>("alice", "bob", "1"));
+    pq.Produce(Pack<string>("alice", "charlie", "2"));
+    pq.Produce(Pack<string>("alice", "bob", "3"));
+    pq.drop("bob");
+    pq.Produce(Pack<string>("alice", "bob", "4"));
+    pq.Produce(Pack<string>("alice", "charlie", "5"));
+    assert(pq.Size() == 3 && "Size should count the remaining packs only");
+    auto actual_contents = queue_to_vector(pq);
+    assert(actual_contents.size() == 3 && "Dropped packs shouldn't come back");
+    assert(actual_contents[0].item == "2" && actual_contents[1].item == "4" && actual_contents[2].item == "5" && "Arrival order should be kept");
+}
+
+// Test nodes are recycled
+void test_PackQueue_pooled_nodes() {
+    PackQueue<string> pq;
+    for (int i = 0; i < 10; i++) pq.Produce(Pack<string>("alice", "bob", to_string(i)));
+    queue_to_vector(pq);
+    assert(pq.getPooled() == 10 && "Consumed nodes should go to the pool");
+    for (int i = 0; i < 4; i++) pq.Produce(Pack<string>("alice", "charlie", to_string(i)));
+    assert(pq.getPooled() == 6 && "Produce should reuse pooled nodes");
+    pq.drop("charlie");
+    assert(pq.getPooled() == 10 && pq.Size() == 0 && "Dropped nodes should go to the pool");
+}
+
+// Test ConsumeSync wakes up on Produce and on Finish
+void test_PackQueue_consume_sync() {
+    PackQueue<string> pq;
+    Pack<string> pack;
+    atomic<bool> consumed = false;
+    thread consumer([&]() { consumed = pq.ConsumeSync(pack); });
+    pq.Produce(Pack<string>("alice", "bob", "hello"));
+    consumer.join();
+    assert(consumed && pack.item == "hello" && "ConsumeSync should get the pack");
+    thread finished([&]() { consumed = pq.ConsumeSync(pack); });
+    while (consumed) { // until the consumer got in the wait
+        pq.Finish();
+        this_thread::yield();
+    }
+    finished.join();
+    assert(!consumed && "Finish should release ConsumeSync");
+}
+
+// Test waitFor wakes up on Produce and on interrupt
+void test_PackQueue_waitFor() {
+    PackQueue<string> pq;
+    atomic<bool> interrupt = false;
+    auto interrupted = [&]() { return interrupt.load(); };
+    assert(!pq.waitFor(1, interrupted) && "Wait on an empty queue should time out");
+    thread producer([&]() {
+        this_thread::sleep_for(chrono::milliseconds(5));
+        pq.Produce(Pack<string>("alice", "bob", "hello"));
+    });
+    assert(pq.waitFor(0, interrupted) && pq.Size() == 1 && "Produce should wake the wait");
+    producer.join();
+    assert(pq.waitFor(0, interrupted) && "Wait on a non-empty queue should return");
+    queue_to_vector(pq);
+    thread closer([&]() {
+        this_thread::sleep_for(chrono::milliseconds(5));
+        interrupt = true;
+        pq.notify();
+    });
+    assert(pq.waitFor(0, interrupted) && "Interrupt should wake the wait");
+    closer.join();
+}
+
+// Test the interactive lane overtakes, each lane keeps its order
+void test_PackQueue_lanes_strict() {
+    PackQueue<string> pq;
+    pq.Produce(Pack<string>("agent", "bob", "b1", Priority::Background));
+    pq.Produce(Pack<string>("agent", "bob", "n1"));
+    pq.Produce(Pack<string>("agent", "bob", "b2", Priority::Background));
+    pq.Produce(Pack<string>("user", "bob", "i1", Priority::Interactive));
+    pq.Produce(Pack<string>("agent", "charlie", "n2"));
+    pq.Produce(Pack<string>("user", "charlie", "i2", Priority::Interactive));
+    assert(pq.Size(Priority::Interactive) == 2 && pq.Size(Priority::Normal) == 2 && pq.Size(Priority::Background) == 2 && "Lanes should be counted");
+    vector<string> items;
+    for (const Pack<string>& pack: queue_to_vector(pq)) items.push_back(pack.item);
+    assert(vector_equal(items, vector<string>({ "i1", "i2", "n1", "n2", "b1", "b2" })) && "Higher lanes should go first, in arrival order");
+}
+
+// Test the weights share the rounds between the lanes
+void test_PackQueue_lanes_weighted_fair() {
+    PackQueue<string> pq;
+    pq.setLanePolicy(LanePolicy::WeightedFair, { 3, 2, 1 });
+    assert(pq.getLanePolicy() == LanePolicy::WeightedFair && "Policy should be set");
+    for (int i = 0; i < 6; i++) {
+        pq.Produce(Pack<string>("agent", "bob", "b", Priority::Background));
+        pq.Produce(Pack<string>("agent", "bob", "n"));
+        pq.Produce(Pack<string>("user", "bob", "i", Priority::Interactive));
+    }
+    string order;
+    for (const Pack<string>& pack: queue_to_vector(pq)) order += pack.item;
+    assert(order == "iiinnbiiinnbnnbbbb" && "Each round should give a lane its weight");
+}
+
+// Test drop takes the packs of every lane
+void test_PackQueue_lanes_drop() {
+    PackQueue<string> pq;
+    pq.Produce(Pack<string>("user", "bob", "1", Priority::Interactive));
+    pq.Produce(Pack<string>("agent", "bob", "2", Priority::Background));
+    pq.Produce(Pack<string>("agent", "charlie", "3", Priority::Background));
+    pq.drop("bob");
+    assert(pq.Size() == 1 && pq.Size(Priority::Interactive) == 0 && pq.Size(Priority::Background) == 1 && "Every lane of the recipient should be dropped");
+    auto actual_contents = queue_to_vector(pq);
+    assert(actual_contents.size() == 1 && actual_contents[0].item == "3" && "Other recipients should stay");
+    assert(pq.getPooled() == 3 && "Dropped nodes should go to the pool");
+}
+
+void test_PackQueue_recorder() {
+    string filename = "/tmp/test_PackQueue_recorder_" + to_string(getpid()) + ".pklg";
+    PackQueue<string> pq;
+    {
+        PackRecorder<string> recorder(filename);
+        pq.Produce(Pack<string>("alice", "bob", "before"));
+        pq.setRecorder(&recorder);
+        pq.Produce(Pack<string>("alice", "bob", "hello"));
+        pq.Produce(Pack<string>("bob", "alice", string("bin\0ary", 7), Priority::Background));
+        pq.setRecorder(nullptr);
+        pq.Produce(Pack<string>("alice", "bob", "after"));
+        assert(recorder.getCount() == 2 && "Only the packs while recording should be logged");
+    }
+    vector<RecordedPack<string>> packs = PackRecorder<string>::read(filename);
+    assert(packs.size() == 2 && "Log should have the recorded packs");
+    assert(packs[0].sender == "alice" && packs[0].recipient == "bob" && packs[0].item == "hello" && "First pack should round trip");
+    assert(packs[1].item == string("bin\0ary", 7) && "Binary item should round trip");
+    assert(packs[0].priority == Priority::Normal && packs[1].priority == Priority::Background && "Priority should round trip");
+    assert(packs[0].at >= 0 && packs[1].at >= packs[0].at && "Times should be in order");
+    remove(filename.c_str());
+}
+
+void test_PackQueue_record() {
+    string filename = "/tmp/test_PackQueue_record_" + to_string(getpid()) + ".pklg";
+    PackQueue<string> pq;
+    pq.record(filename);
+    pq.Produce(Pack<string>("alice", "bob", "hello"));
+    assert(pq.getRecorded() == 1 && "Recorded packs should be counted");
+    pq.record("");
+    pq.Produce(Pack<string>("alice", "bob", "after"));
+    assert(pq.getRecorded() == 0 && "Stopped recording should count nothing");
+    vector<RecordedPack<string>> packs = PackRecorder<string>::read(filename);
+    assert(packs.size() == 1 && packs[0].item == "hello" && "Stopping should flush the log");
+    remove(filename.c_str());
+}
+
 // Register tests
 TEST(test_PackQueue_drop_empty);
 TEST(test_PackQueue_drop_single_no_match);
 TEST(test_PackQueue_drop_single_match);
 TEST(test_PackQueue_drop_multiple_mixed);
+TEST(test_PackQueue_drop_keeps_order);
+TEST(test_PackQueue_pooled_nodes);
+TEST(test_PackQueue_consume_sync);
+TEST(test_PackQueue_waitFor);
+TEST(test_PackQueue_lanes_strict);
+TEST(test_PackQueue_lanes_weighted_fair);
+TEST(test_PackQueue_lanes_drop);
+TEST(test_PackQueue_recorder);
+TEST(test_PackQueue_record);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+
+#include "../utils/ERROR.hpp"
+#include "remote/Wire.hpp"
+#include "Pack.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::agency::remote;
+
+namespace tools::agency {
+
+    template<typename T>
+    struct RecordedPack {
+        long long at = 0; // ns since the recording started
+        string sender;
+        string recipient;
+        T item;
+        Priority priority = Priority::Normal;
+    };
+
+    /**
+     * Binary log of the produced packs (see PackQueue::setRecorder()):
+     *   "PKLG" | u32 version | frames
+     * a Pack frame per pack with the time as its first field (8 bytes,
+     * little endian) and the priority as its last (a byte, since version
+     * 2), see Wire. Written in chunks, flushed on close.
+     */
+    template<typename T>
+    class PackRecorder {
+    public:
+        static inline const string magic = "PKLG";
+        static const uint32_t version = 2;
+        static const size_t flushBytes = 1 << 20;
+
+        PackRecorder(const string& filename): filename(filename), start(chrono::steady_clock::now()) {
+            file.open(filename, ios::binary | ios::trunc);
+            if (!file) throw ERROR("Unable to write pack log: " + filename);
+            string header = magic;
+            header.append(bytes(version, 4));
+            file.write(header.data(), header.size());
+        }
+
+        virtual ~PackRecorder() {
+            flush();
+        }
+
+        void record(const Pack<T>& pack) {
+            long long at = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+            lock_guard<mutex> lock(mtx);
+            Wire::encode({ FrameType::Pack, { bytes(at, 8), pack.sender.name(), pack.recipient.name(), Codec<T>::encode(pack.item.get()), bytes((uint64_t)pack.priority, 1) } }, buffer);
+            count++;
+            if (buffer.size() >= flushBytes) write();
+        }
+
+        void flush() {
+            lock_guard<mutex> lock(mtx);
+            write();
+            file.flush();
+        }
+
+        size_t getCount() const {
+            lock_guard<mutex> lock(mtx);
+            return count;
+        }
+
+        string getFilename() const { return filename; }
+
+        static vector<RecordedPack<T>> read(const string& filename) {
+            ifstream file(filename, ios::binary);
+            if (!file) throw ERROR("Unable to read pack log: " + filename);
+            string header(8, '\0');
+            if (!file.read(header.data(), header.size()) || header.substr(0, 4) != magic)
+                throw ERROR("Not a pack log: " + filename);
+            uint32_t logVersion = Wire::get(header.data() + 4);
+            if (logVersion < 1 || logVersion > version)
+                throw ERROR("Unsupported pack log version in " + filename);
+            size_t fields = logVersion < 2 ? 4 : 5;
+            vector<RecordedPack<T>> packs;
+            FrameReader reader;
+            Frame frame;
+            char chunk[1 << 16];
+            while (file.read(chunk, sizeof(chunk)) || file.gcount()) {
+                reader.feed(chunk, file.gcount());
+                while (reader.next(frame)) {
+                    if (frame.type != FrameType::Pack || frame.fields.size() != fields || frame.fields[0].size() != 8 ||
+                        (fields > 4 && (frame.fields[4].size() != 1 || (size_t)frame.fields[4][0] >= priorities)))
+                        throw ERROR("Broken pack log: " + filename);
+                    const char* at = frame.fields[0].data();
+                    packs.push_back({
+                        (long long)(Wire::get(at) | ((uint64_t)Wire::get(at + 4) << 32)),
+                        frame.fields[1],
+                        frame.fields[2],
+                        Codec<T>::decode(frame.fields[3]),
+                        fields > 4 ? (Priority)frame.fields[4][0] : Priority::Normal
+                    });
+                }
+            }
+            return packs;
+        }
+
+    private:
+        static string bytes(uint64_t value, size_t size) {
+            string out(size, '\0');
+            for (size_t i = 0; i < size; i++) out[i] = (char)((value >> (8 * i)) & 0xff);
+            return out;
+        }
+
+        // Needs mtx
+        void write() {
+            if (buffer.empty()) return;
+            file.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+        string filename;
+        chrono::steady_clock::time_point start;
+        mutable mutex mtx;
+        ofstream file;
+        string buffer;
+        size_t count = 0;
+    };
+
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <map>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "../utils/Owns.hpp"
+#include "../utils/ERROR.hpp"
+#include "PackRecorder.hpp"
+#include "Agency.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::agency {
+
+    // Mock recipient of a replay, timestamps its handle()s
+    template<typename T>
+    class ReplayWorker: public Worker<T> {
+    public:
+        ReplayWorker(
+            Owns& owns,
+            Worker<T>* agency,
+            PackQueue<T>& queue,
+            const string& name,
+            atomic<size_t>& handled
+        ):
+            Worker<T>(owns, agency, queue, name),
+            handled(handled)
+        {}
+
+        string type() const override { return "replay"; }
+
+        void handle(const string&, const T&) override {
+            handledAt.push_back(chrono::steady_clock::now().time_since_epoch().count());
+            handled.fetch_add(1, memory_order_release);
+        }
+
+        vector<long long> handledAt; // steady clock ns, read after the replay
+
+    private:
+        atomic<size_t>& handled;
+    };
+
+    /**
+     * Feeds a pack log (see PackRecorder) into a fresh agency that has a
+     * ReplayWorker for every recipient, at the recorded timing (speed
+     * times faster) or as fast as possible (speed 0), and measures the
+     * latency from Produce() to the handle() of each pack.
+     * The packs to the agency itself are skipped, those are commands.
+     */
+    template<typename T>
+    class PackReplay {
+    public:
+        struct Result {
+            size_t packs = 0;   // replayed
+            size_t skipped = 0;
+            long long ns = 0;   // from the first Produce() to the last handle()
+            vector<long long> latencies; // ns, of the replayed packs in log order
+
+            double throughput() const {
+                return ns > 0 ? (double)packs * 1e9 / (double)ns : 0.0;
+            }
+        };
+
+        static constexpr long timeoutMs = 60000;
+
+        // threads: of the agency's pool (0: inline)
+        static Result run(const vector<RecordedPack<T>>& log, double speed = 0, size_t threads = 0, const string& agencyName = "agency") {
+            Owns owns;
+            AgentRoleMap roles;
+            PackQueue<T> queue;
+            atomic<size_t> handled = 0;
+            Result result;
+            Agency<T> agency(owns, roles, queue, agencyName);
+            agency.setThreads(threads);
+
+            map<string, ReplayWorker<T>*> workers;
+            vector<Pack<T>> packs; // made up front, not timed
+            vector<long long> at;
+            vector<pair<ReplayWorker<T>*, size_t>> targets; // worker, nth pack of it
+            map<ReplayWorker<T>*, size_t> counts;
+            for (const RecordedPack<T>& recorded: log) {
+                if (recorded.recipient == agencyName) {
+                    result.skipped++;
+                    continue;
+                }
+                ReplayWorker<T>*& worker = workers[recorded.recipient];
+                if (!worker) worker = &agency.template spawn<ReplayWorker<T>>(owns, &agency, queue, recorded.recipient, handled);
+                targets.push_back({ worker, counts[worker]++ });
+                packs.push_back(Pack<T>(recorded.sender, recorded.recipient, Payload<T>(recorded.item), recorded.priority));
+                at.push_back(recorded.at);
+            }
+            result.packs = packs.size();
+            if (packs.empty()) return result;
+
+            agency.start(); // routes as the packs come
+            vector<long long> producedAt(packs.size());
+            auto start = chrono::steady_clock::now();
+            for (size_t i = 0; i < packs.size(); i++) {
+                if (speed > 0) this_thread::sleep_until(start + chrono::nanoseconds((long long)((at[i] - at[0]) / speed)));
+                producedAt[i] = chrono::steady_clock::now().time_since_epoch().count();
+                queue.Produce(move(packs[i]));
+            }
+            auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+            while (handled.load(memory_order_acquire) < result.packs) {
+                if (chrono::steady_clock::now() > deadline)
+                    throw ERROR("Replay timed out, " + to_string(handled.load()) + " of " + to_string(result.packs) + " packs handled");
+                this_thread::sleep_for(chrono::microseconds(100));
+            }
+
+            long long last = 0;
+            for (size_t i = 0; i < targets.size(); i++) {
+                long long handledAt = targets[i].first->handledAt[targets[i].second];
+                result.latencies.push_back(handledAt - producedAt[i]);
+                last = max(last, handledAt);
+            }
+            result.ns = last - producedAt[0];
+            return result;
+        }
+
+        static Result run(const string& filename, double speed = 0, size_t threads = 0, const string& agencyName = "agency") {
+            return run(PackRecorder<T>::read(filename), speed, threads, agencyName);
+        }
+    };
+
+}
+
+#ifdef TEST
+
+#include <unistd.h>
+
+#include "../utils/Test.hpp"
+
+using namespace tools::agency;
+
+static vector<RecordedPack<string>> replay_test_log(size_t count, long long stepNs) {
+    vector<RecordedPack<string>> log;
+    for (size_t i = 0; i < count; i++)
+        log.push_back({ (long long)i * stepNs, "sender", "worker" + to_string(i % 3), "item" + to_string(i) });
+    log.push_back({ (long long)count * stepNs, "user", "agency", "exit" });
+    return log;
+}
+
+void test_PackReplay_fast() {
+    for (size_t threads: { 0, 2 }) {
+        PackReplay<string>::Result result = PackReplay<string>::run(replay_test_log(300, 1000), 0, threads);
+        assert(result.packs == 300 && result.skipped == 1 && "Packs to the agency should be skipped");
+        assert(result.latencies.size() == 300 && "Every pack should have its latency");
+        assert(all_of(result.latencies.begin(), result.latencies.end(), [](long long ns) { return ns >= 0; }) && "Latencies should not be negative");
+        assert(result.ns > 0 && result.throughput() > 0 && "Throughput should be measured");
+    }
+}
+
+void test_PackReplay_recorded_timing() {
+    // 10 packs, 5ms apart: the replay takes 45ms at least, twice faster half of it
+    PackReplay<string>::Result timed = PackReplay<string>::run(replay_test_log(10, 5000000), 1);
+    assert(timed.ns >= 45000000 && "Replay should keep the recorded timing");
+    PackReplay<string>::Result faster = PackReplay<string>::run(replay_test_log(10, 5000000), 2);
+    assert(faster.ns >= 22500000 && faster.ns < timed.ns && "Speed should scale the timing");
+}
+
+void test_PackReplay_from_file() {
+    string filename = "/tmp/test_PackReplay_" + to_string(getpid()) + ".pklg";
+    {
+        PackQueue<string> queue;
+        PackRecorder<string> recorder(filename);
+        queue.setRecorder(&recorder);
+        for (int i = 0; i < 50; i++) queue.Produce(Pack<string>("alice", "bob", "hi"));
+        queue.setRecorder(nullptr);
+    }
+    PackReplay<string>::Result result = PackReplay<string>::run(filename);
+    assert(result.packs == 50 && result.skipped == 0 && "Recorded packs should be replayed");
+    remove(filename.c_str());
+}
+
+TEST(test_PackReplay_fast);
+TEST(test_PackReplay_recorded_timing);
+TEST(test_PackReplay_from_file);
+
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <memory>
+#include <concepts>
+#include <type_traits>
+
+using namespace std;
+
+namespace tools::agency {
+
+    /**
+     * Immutable, reference counted item of a Pack: copying a Payload
+     * shares the item, so a broadcast allocates it once however many
+     * packs carry it. Built from an rvalue the item is moved in.
+     */
+    template<typename T>
+    class Payload {
+    public:
+        Payload() {}
+        Payload(shared_ptr<const T> item): item(move(item)) {}
+
+        template<typename U>
+        requires (!same_as<remove_cvref_t<U>, Payload>) &&
+            (!same_as<remove_cvref_t<U>, shared_ptr<const T>>) &&
+            constructible_from<T, U&&>
+        Payload(U&& value): item(make_shared<const T>(forward<U>(value))) {}
+
+        // An empty payload reads as T()
+        const T& get() const {
+            return item ? *item : empty();
+        }
+
+        operator const T&() const { return get(); }
+
+        shared_ptr<const T> share() const { return item; }
+
+        // Packs sharing this item
+        long uses() const { return item.use_count(); }
+
+        bool operator==(const Payload& other) const {
+            return item == other.item || get() == other.get();
+        }
+
+        template<typename U>
+        requires (!same_as<U, Payload>)
+        bool operator==(const U& other) const {
+            return get() == other;
+        }
+
+    private:
+        static const T& empty() {
+            static const T value{};
+            return value;
+        }
+
+        shared_ptr<const T> item;
+    };
+
+}
+
+#ifdef TEST
+
+#include "../utils/Test.hpp"
+
+using namespace tools::agency;
+
+// Counts the copies of the item
+struct PayloadCopyCounter {
+    static inline int copies = 0;
+    string text;
+    PayloadCopyCounter(const string& text = ""): text(text) {}
+    PayloadCopyCounter(const PayloadCopyCounter& other): text(other.text) { copies++; }
+    PayloadCopyCounter(PayloadCopyCounter&& other) = default;
+};
+
+void test_Payload_shares_item() {
+    Payload<string> payload(string("hello"));
+    Payload<string> shared = payload;
+    assert(&payload.get() == &shared.get() && "Copies should share the item");
+    assert(payload.uses() == 2 && "Shared item should be counted");
+    assert(payload == "hello" && payload == shared && "Payload should compare to the item");
+    const string& item = payload;
+    assert(item == "hello" && "Payload should convert to the item");
+    assert(Payload<string>().get().empty() && Payload<string>() == "" && "Empty payload should read as T()");
+}
+
+void test_Payload_moves_rvalue() {
+    PayloadCopyCounter::copies = 0;
+    PayloadCopyCounter counter("hello");
+    Payload<PayloadCopyCounter> moved(move(counter));
+    assert(PayloadCopyCounter::copies == 0 && "Rvalue should be moved in");
+    Payload<PayloadCopyCounter> copied(moved.get());
+    assert(PayloadCopyCounter::copies == 1 && "Lvalue should be copied once");
+    Payload<PayloadCopyCounter> shared = copied;
+    assert(PayloadCopyCounter::copies == 1 && shared.get().text == "hello" && "Sharing shouldn't copy");
+}
+
+TEST(test_Payload_shares_item);
+TEST(test_Payload_moves_rvalue);
+
+#endif
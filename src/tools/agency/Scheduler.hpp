@@ -0,0 +1,135 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "../utils/WorkStealingPool.hpp"
+#include "../utils/Tracer.hpp"
+#include "Worker.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::agency {
+
+    /**
+     * Runs the handle() calls of the agency's workers on a work-stealing
+     * pool: packs of one worker one by one in order, different workers in
+     * parallel. Without a pool the agency drains the mailboxes inline.
+     * Guarded by the mutex of the agency's workers.
+     */
+    template<typename T>
+    class Scheduler {
+    public:
+        typedef function<void(const string&)> ErrorHandler;
+
+        // packs a pool run hands to one worker before it gives others a turn
+        static const size_t mailboxBatch = 16;
+
+        Scheduler(mutex& workers_mtx, ErrorHandler hoops):
+            workers_mtx(workers_mtx),
+            hoops(hoops)
+        {}
+
+        // 0 threads: inline, cpus: binds the threads. The old pool finishes
+        // its queued runs first.
+        void setThreads(size_t threads, const vector<int>& cpus = {}) {
+            unique_ptr<WorkStealingPool> old; // its runs take workers_mtx
+            lock_guard<mutex> lock(workers_mtx);
+            old = move(pool);
+            if (threads) pool = make_unique<WorkStealingPool>(threads, cpus);
+            this->cpus = cpus;
+        }
+
+        size_t getThreads() const {
+            lock_guard<mutex> lock(workers_mtx);
+            return pool ? pool->getThreads() : 0;
+        }
+
+        vector<int> getCpus() const {
+            lock_guard<mutex> lock(workers_mtx);
+            return cpus;
+        }
+
+        // Keeps the worker on one pool thread (lane % threads), -1 lets
+        // it run on any
+        void setAffinity(const string& name, int lane) {
+            lock_guard<mutex> lock(workers_mtx);
+            if (lane < 0) affinity.erase(WorkerId(name));
+            else affinity[WorkerId(name)] = lane;
+        }
+
+        map<string, int> getAffinity() const {
+            map<string, int> lanes;
+            lock_guard<mutex> lock(workers_mtx);
+            for (const auto& [id, lane]: affinity) lanes[id.name()] = lane;
+            return lanes;
+        }
+
+        // Blocks until the workers handled the packs scheduled so far
+        void wait() {
+            if (pool) pool->wait();
+        }
+
+        // Needs workers_mtx, nullptr without a pool
+        WorkStealingPool* getPool() const {
+            return pool.get();
+        }
+
+        // Gives the worker a drain run on the pool (urgent: next), needs
+        // workers_mtx, false without a pool: the caller drains it inline,
+        // after releasing workers_mtx
+        bool schedule(Worker<T>* worker, bool urgent = false) {
+            if (!pool) return false;
+            auto it = affinity.find(worker->getId());
+            bool pinned = it != affinity.end();
+            pool->submit([this, worker]() {
+                if (!drain(worker, mailboxBatch)) return;
+                bool queued = false;
+                {
+                    lock_guard<mutex> lock(workers_mtx);
+                    queued = schedule(worker); // more to do, back in line
+                }
+                if (!queued) while (drain(worker, SIZE_MAX)); // the pool is going away
+            }, pinned ? it->second : -1, pinned, urgent);
+            return true;
+        }
+
+        // Hands up to limit packs of the mailbox to the worker, returns
+        // true if it may have more (still scheduled), early if preempted
+        // so the pool thread gets to the waiting interactive packs
+        bool drain(Worker<T>* worker, size_t limit) {
+            Mailbox<T>& mailbox = worker->getMailboxRef();
+            Pack<T> next;
+            for (size_t i = 0; i < limit; i++) {
+                if (!mailbox.take(next)) return false;
+                TraceSpan span("pack", "handle", worker->getId().name().c_str(), next.trace);
+                if (next.trace) Tracer::instance().flow('f', next.trace);
+                worker->enter(next.priority);
+                try {
+                    worker->handle(next.sender, next.item);
+                } catch (exception &e) {
+                    hoops("Worker '" + worker->getName() + "' error: " + string(e.what()));
+                }
+                bool preempted = worker->isPreempted();
+                worker->leave();
+                worker->touch();
+                if (preempted) return true;
+            }
+            return true;
+        }
+
+    private:
+        mutex& workers_mtx;
+        ErrorHandler hoops;
+        unique_ptr<WorkStealingPool> pool; // nullptr: inline
+        vector<int> cpus;
+        unordered_map<WorkerId, int> affinity; // worker => pool thread
+    };
+
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "../utils/ERROR.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::agency {
+
+    // What happens to a send when the recipient's mailbox is full
+    enum class MailboxPolicy {
+        Block,      // the sender waits for room (and for rate limit tokens)
+        DropOldest, // the oldest waiting pack is dropped
+        Reject,     // send() throws to the sender (also when rate limited)
+    };
+
+    inline string mailbox_policy_name(MailboxPolicy policy) {
+        switch (policy) {
+            case MailboxPolicy::Block: return "block";
+            case MailboxPolicy::DropOldest: return "drop_oldest";
+            case MailboxPolicy::Reject: return "reject";
+        }
+        throw ERROR("Invalid mailbox policy");
+    }
+
+    inline MailboxPolicy to_mailbox_policy(const string& name) {
+        if (name == "block") return MailboxPolicy::Block;
+        if (name == "drop_oldest") return MailboxPolicy::DropOldest;
+        if (name == "reject") return MailboxPolicy::Reject;
+        throw ERROR("Invalid mailbox policy: " + name);
+    }
+
+    // Mailbox bound (capacity 0: unbounded)
+    struct MailboxLimit {
+        size_t capacity = 0;
+        MailboxPolicy policy = MailboxPolicy::Block;
+    };
+
+    // perSecond <= 0: unlimited
+    struct RateLimit {
+        double perSecond = 0;
+        double burst = 1;
+    };
+
+    /**
+     * Token bucket: burst tokens at most, refilled at perSecond.
+     * Not synchronized.
+     */
+    class TokenBucket {
+    public:
+        TokenBucket(const RateLimit& limit = RateLimit()):
+            perSecond(limit.perSecond),
+            burst(max(1.0, limit.burst)),
+            tokens(burst),
+            last(chrono::steady_clock::now())
+        {}
+
+        // Takes a token or tells how long until there is one
+        bool take(chrono::nanoseconds& wait) {
+            if (perSecond <= 0) return true;
+            auto now = chrono::steady_clock::now();
+            tokens = min(burst, tokens + chrono::duration<double>(now - last).count() * perSecond);
+            last = now;
+            if (tokens >= 1) {
+                tokens -= 1;
+                return true;
+            }
+            wait = chrono::nanoseconds((long long)((1 - tokens) / perSecond * 1e9) + 1);
+            return false;
+        }
+
+    private:
+        double perSecond;
+        double burst;
+        double tokens;
+        chrono::steady_clock::time_point last;
+    };
+
+    // How often a worker was held back
+    struct ThrottleStats {
+        size_t limited = 0;  // sends over the rate limit
+        size_t blocked = 0;  // sends that waited for mailbox room
+        size_t rejected = 0; // sends refused
+        size_t dropped = 0;  // packs dropped from its full mailbox
+
+        bool any() const {
+            return limited || blocked || rejected || dropped;
+        }
+    };
+
+}
+
+#ifdef TEST
+
+#include "../utils/Test.hpp"
+
+using namespace tools::agency;
+
+void test_TokenBucket_burst_and_refill() {
+    TokenBucket bucket(RateLimit{ 1000, 3 });
+    chrono::nanoseconds wait(0);
+    assert(bucket.take(wait) && bucket.take(wait) && bucket.take(wait) && "Burst should pass");
+    assert(!bucket.take(wait) && wait.count() > 0 && wait.count() <= 1000001 && "Empty bucket should tell the wait");
+    this_thread::sleep_for(wait);
+    assert(bucket.take(wait) && "Bucket should refill");
+    TokenBucket unlimited;
+    for (int i = 0; i < 100; i++) assert(unlimited.take(wait) && "No rate should be unlimited");
+}
+
+void test_MailboxPolicy_names() {
+    for (MailboxPolicy policy: { MailboxPolicy::Block, MailboxPolicy::DropOldest, MailboxPolicy::Reject })
+        assert(to_mailbox_policy(mailbox_policy_name(policy)) == policy && "Policy names should round trip");
+    bool thrown = false;
+    try {
+        to_mailbox_policy("later");
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Unknown policy should throw");
+}
+
+TEST(test_TokenBucket_burst_and_refill);
+TEST(test_MailboxPolicy_names);
+
+#endif
@@ -11,6 +11,8 @@
 
 #include "Pack.hpp"
 #include "PackQueue.hpp"
+#include "Message.hpp"
+#include "Mailbox.hpp"
 
 using namespace std;
 using namespace tools::utils;
@@ -33,7 +35,8 @@ namespace tools::agency {
             owns(owns),
             agency(agency),
             queue(queue),
-            name(name)
+            name(name),
+            id(name)
         {}
 
         virtual ~Worker() {
@@ -48,9 +51,16 @@ namespace tools::agency {
         Owns& getOwnsRef() const { return owns; }
         Worker<T>* getAgencyPtr() { return agency ? agency : this; }
         PackQueue<T>& getQueueRef() { return queue; }
+        Mailbox<T>& getMailboxRef() { return mailbox; }
+        const Mailbox<T>& getMailboxCRef() const { return mailbox; }
         string getName() const { return name; }
+        WorkerId getId() const { return id; }
         vector<string> getRecipients() const { return recipients; }
 
+        // Of the packs the worker sends (see send())
+        Priority getPriority() const { return priority; }
+        void setPriority(Priority priority) { this->priority = priority; touch(); }
+
 
         // -----------------------------------------------------------------
         // ---- working ----------------------------------------------------
@@ -61,23 +71,39 @@ namespace tools::agency {
         virtual void tick() {}
 
         void exit() {
-            this->send("agency", "exit");
+            this->send("agency", control_item<T>(Control::Exit), Priority::Interactive);
             this->close();
         }
 
-        void start(long ms = 10, bool run_async = true) {
+        // Also wakes the sync() loop up to leave
+        void close() override {
+            Closable::close();
+            wake();
+        }
+
+        // Closes and waits for the async() thread
+        void stop() {
+            this->close();
+            if (t.joinable()) t.join();
+        }
+
+        // ms: tick() timer, see sync()
+        void start(long ms = 0, bool run_async = true) {
             if (run_async) async(ms);
             else sync(ms);
         }
 
-        void async(long ms = 10) {
+        void async(long ms = 0) {
             t = thread([this, ms]() { sync(ms); });
         }
 
-        void sync(long ms = 10) {
+        // Calls tick() whenever a pack arrives for the worker, and at least
+        // every ms milliseconds (0: no timer), sleeps in between
+        void sync(long ms = 0) {
             while (!closing) {
                 try {
-                    if (ms) sleep_ms(ms);
+                    wait(ms);
+                    if (closing) break;
                     tick();
                 } catch (exception &e) {
                     hoops("Worker '" + name + "' error: " + string(e.what()));
@@ -86,20 +112,53 @@ namespace tools::agency {
         }
 
 
+        // -----------------------------------------------------------------
+        // ---- preemption -------------------------------------------------
+        // -----------------------------------------------------------------
+
+        // A pack of higher priority than the one in handle() is waiting, a
+        // long handle() may check it and yield (e.g. return and send the
+        // rest of its work to itself as a background pack)
+        bool isPreempted() const {
+            int state = handling.load(memory_order_relaxed);
+            return state >= 0 && (state & preemptedFlag);
+        }
+
+        // The priority of the pack in handle()
+        Priority getHandling() const {
+            int state = handling.load(memory_order_relaxed);
+            return state >= 0 ? (Priority)(state & ~preemptedFlag) : Priority::Normal;
+        }
+
+        // The agency marks the handle() calls (see Scheduler::drain())
+        void enter(Priority priority) { handling.store((int)priority, memory_order_relaxed); }
+        void leave() { handling.store(-1, memory_order_relaxed); }
+
+        // Raises isPreempted() if the pack in handle() has a lower priority
+        void preempt(Priority priority) {
+            int state = handling.load(memory_order_relaxed);
+            while (state >= 0 && !(state & preemptedFlag) && state > (int)priority)
+                if (handling.compare_exchange_weak(state, state | preemptedFlag, memory_order_relaxed)) return;
+        }
+
+
         // -----------------------------------------------------------------
         // ---- messaging --------------------------------------------------
         // -----------------------------------------------------------------
 
         void addRecipients(const vector<string>& recipients) {
             this->recipients = array_merge(this->recipients, recipients);
+            touch();
         }
 
         void setRecipients(const vector<string>& recipients) {
             this->recipients = recipients;
+            touch();
         }
 
         void removeRecipients(const vector<string>& recipients) {
             this->recipients = array_diff(this->recipients, recipients);
+            touch();
         }
 
         vector<string> findRecipients(const string& keyword = "") const {
@@ -133,6 +192,8 @@ namespace tools::agency {
         void fromJSON(const JSON& json) override {
             // DEBUG(json.dump());
             recipients = json.get<vector<string>>("recipients");
+            if (json.has("priority")) priority = to_priority(json.get<string>("priority"));
+            touch();
         }
 
         JSON toJSON() const override {
@@ -140,15 +201,66 @@ namespace tools::agency {
             json.set("role", this->type());
             json.set("name", name);
             json.set("recipients", recipients);
+            json.set("priority", string(priority_name(priority)));
             return json;
         }
 
+        // ----- checkpoints -----
+
+        // Changes with the state (drawn from one counter for all workers,
+        // so a respawned worker never looks saved)
+        uint64_t getRevision() const { return revision; }
+
+        // The first revision, tells this worker from an other one by the name
+        uint64_t getOrigin() const { return origin; }
+
+        // Marks the state changed (the agency does it after each handle())
+        void touch() { revision = nextRevision(); }
+
+        // The state without the journal, rewritten on each checkpoint of
+        // the worker, so keep it small
+        virtual JSON toSnapshot() const { return toJSON(); }
+
+        // The append only part of the state (e.g. a chat history): adds the
+        // entries after the first from ones, returns the count of all and
+        // sets the key of toJSON() they belong to ("": no journal)
+        virtual size_t journal(size_t /*from*/, vector<JSON>& /*entries*/, string& key) const {
+            key = "";
+            return 0;
+        }
+
     protected:
 
+        // The item is copied (or moved) once, the recipients share it
         void send(const T& item) {
-            send(recipients, item);
+            send(recipients, Payload<T>(item), priority);
+        }
+
+        void send(T&& item) {
+            send(recipients, Payload<T>(move(item)), priority);
+        }
+
+        void send(const T& item, Priority priority) {
+            send(recipients, Payload<T>(item), priority);
+        }
+
+        void send(T&& item, Priority priority) {
+            send(recipients, Payload<T>(move(item)), priority);
         }
         
+        // Blocks until there is something to tick() for (see sync())
+        virtual void wait(long ms) {
+            mailbox.wait(ms, closing);
+        }
+
+        // Interrupts wait()
+        virtual void wake() {
+            mailbox.notify();
+        }
+
+        // Backpressure on send(): may wait or throw (see Agency::admit())
+        virtual void admit(const WorkerId& /*sender*/, const WorkerId& /*recipient*/) {}
+
         // LCOV_EXCL_START
         virtual void hoops(const string& errmsg = "") {
             cerr << errmsg << endl;
@@ -159,21 +271,36 @@ namespace tools::agency {
         Worker<T>* agency = nullptr;
         PackQueue<T>& queue;
         string name;
+        WorkerId id; // the name interned, for routing
         vector<string> recipients;
+        Mailbox<T> mailbox; // packs routed to this worker by the agency
+        const uint64_t origin = nextRevision();
+        atomic<uint64_t> revision = origin;
+        Priority priority = Priority::Normal;
 
     private:
 
-        void send(const string& recipient, const T& item) {
+        static const int preemptedFlag = 0x10;
+
+        static uint64_t nextRevision() {
+            static atomic<uint64_t> revisions = 0;
+            return ++revisions;
+        }
+
+        void send(const string& recipient, Payload<T> item, Priority priority) {
             if (name == recipient) ERROR("Can not send for itself: " + name);
-            Pack<T> pack(name, recipient, item);
+            WorkerId to(recipient);
+            getAgencyPtr()->admit(id, to);
+            Pack<T> pack(id, to, move(item), priority);
             queue.Produce(move(pack));
         }
 
-        void send(const vector<string>& recipients, const T& item) {
-            for (const string& recipient: recipients) send(recipient, item);
+        void send(const vector<string>& recipients, Payload<T> item, Priority priority) {
+            for (const string& recipient: recipients) send(recipient, item, priority);
         }
 
         thread t;
+        atomic<int> handling = -1; // priority of the pack in handle() | preemptedFlag
     };
 
 }
@@ -193,6 +320,14 @@ using namespace tools::agency;
 using namespace tools::str;
 using namespace tools::agency::chat;
 
+// Counts the ticks
+class TickCountingTestWorker: public TestWorker<string> {
+public:
+    using TestWorker<string>::TestWorker;
+    atomic<size_t> ticks = 0;
+    void tick() override { ticks++; }
+};
+
 // Test constructor
 void test_Worker_constructor_basic() {
     default_test_agency_setup setup("test_worker");
@@ -233,6 +368,67 @@ void test_Worker_send_multiple() {
     assert(actual_contents[1].item == "hello" && "Second item should be 'hello'");
 }
 
+// Test a broadcast shares one payload
+void test_Worker_send_broadcast_shares_payload() {
+    default_test_agency_setup setup("alice");
+    TestWorker<string> worker(setup.owns, setup.agency, setup.queue, setup.name);
+    worker.testSend(vector<string>({ "bob", "charlie", "dave" }), string(1000, 'x'));
+    auto actual_contents = queue_to_vector(setup.queue);
+    assert(actual_contents.size() == 3 && "Send should produce three packs");
+    assert(actual_contents[0].item.share() == actual_contents[2].item.share() && "Packs should share the payload");
+    assert(actual_contents[0].item.uses() == 3 && "Payload should be allocated once");
+}
+
+// Test the priority of the sent packs
+void test_Worker_send_priority() {
+    default_test_agency_setup setup("alice");
+    TestWorker<string> worker(setup.owns, setup.agency, setup.queue, setup.name);
+    worker.testSend("bob", "normal");
+    worker.setPriority(Priority::Background);
+    worker.testSend("bob", "background");
+    worker.exit();
+    auto actual_contents = queue_to_vector(setup.queue);
+    assert(actual_contents.size() == 3 && "Sends should produce three packs");
+    assert(actual_contents[0].item == "exit" && actual_contents[0].priority == Priority::Interactive && "Exit should be interactive");
+    assert(actual_contents[1].priority == Priority::Normal && "Default priority should be normal");
+    assert(actual_contents[2].priority == Priority::Background && "Packs should get the priority of the worker");
+}
+
+// Test the priority survives toJSON() and fromJSON()
+void test_Worker_json_priority() {
+    default_test_agency_setup setup("alice");
+    TestWorker<string> worker(setup.owns, setup.agency, setup.queue, setup.name);
+    worker.fromJSON(setup.json);
+    assert(worker.getPriority() == Priority::Normal && "Priority should default to normal");
+    worker.setPriority(Priority::Background);
+    JSON json = worker.toJSON();
+    assert(json.get<string>("priority") == "background" && "toJSON should contain the priority");
+    TestWorker<string> restored(setup.owns, setup.agency, setup.queue, setup.name);
+    restored.fromJSON(json);
+    assert(restored.getPriority() == Priority::Background && "fromJSON should restore the priority");
+}
+
+// Test a higher priority preempts the running handle() only
+void test_Worker_preemption() {
+    default_test_agency_setup setup("test_worker");
+    TestWorker<string> worker(setup.owns, setup.agency, setup.queue, setup.name);
+    worker.preempt(Priority::Interactive);
+    assert(!worker.isPreempted() && "Idle worker shouldn't be preempted");
+    worker.enter(Priority::Background);
+    worker.preempt(Priority::Background);
+    assert(!worker.isPreempted() && "Same priority shouldn't preempt");
+    worker.preempt(Priority::Normal);
+    assert(worker.isPreempted() && worker.getHandling() == Priority::Background && "Higher priority should preempt");
+    worker.preempt(Priority::Interactive);
+    assert(worker.isPreempted() && worker.getHandling() == Priority::Background && "Preemption should keep the handled priority");
+    worker.leave();
+    assert(!worker.isPreempted() && "Preemption should end with the handle()");
+    worker.enter(Priority::Interactive);
+    worker.preempt(Priority::Interactive);
+    assert(!worker.isPreempted() && "Nothing should preempt an interactive handle()");
+    worker.leave();
+}
+
 // Test tick default does nothing
 void test_Worker_tick_default() {
     default_test_agency_setup setup("test_worker");
@@ -254,6 +450,31 @@ void test_Worker_sync_basic() {
     assert(actual_closed && "Agent should remain closed after sync");
 }
 
+// Test sync wakes up on a pack, not on a timer
+void test_Worker_sync_wakes_on_pack() {
+    default_test_agency_setup setup("test_worker");
+    TickCountingTestWorker worker(setup.owns, setup.agency, setup.queue, setup.name);
+    worker.start();
+    sleep_ms(20);
+    size_t idle_ticks = worker.ticks;
+    worker.getMailboxRef().post(Pack<string>("alice", "test_worker", "hello"));
+    for (int i = 0; i < 1000 && worker.ticks == idle_ticks; i++) sleep_ms(1);
+    size_t woken_ticks = worker.ticks;
+    worker.stop();
+    assert(idle_ticks == 0 && "Idle worker without timer shouldn't tick");
+    assert(woken_ticks == 1 && "Pack should wake the worker");
+}
+
+// Test the tick timer
+void test_Worker_sync_timer() {
+    default_test_agency_setup setup("test_worker");
+    TickCountingTestWorker worker(setup.owns, setup.agency, setup.queue, setup.name);
+    worker.start(1);
+    for (int i = 0; i < 1000 && worker.ticks < 3; i++) sleep_ms(1);
+    worker.stop();
+    assert(worker.ticks >= 3 && "Timer should tick");
+}
+
 // Test async starts and stops
 void test_Worker_async_basic() {
     default_test_agency_setup setup("test_worker");
@@ -363,8 +584,14 @@ void test_Worker_findRecipients_emptyKeyword() {
 TEST(test_Worker_constructor_basic);
 TEST(test_Worker_send_single);
 TEST(test_Worker_send_multiple);
+TEST(test_Worker_send_broadcast_shares_payload);
+TEST(test_Worker_send_priority);
+TEST(test_Worker_json_priority);
+TEST(test_Worker_preemption);
 TEST(test_Worker_tick_default);
 TEST(test_Worker_sync_basic);
+TEST(test_Worker_sync_wakes_on_pack);
+TEST(test_Worker_sync_timer);
 TEST(test_Worker_async_basic);
 TEST(test_Worker_getAgencyPtr_agency_is_this);
 TEST(test_Worker_exit_basic);
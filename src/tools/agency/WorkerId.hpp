@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <ostream>
+
+#include "../utils/Interner.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::agency {
+
+    /**
+     * Interned worker name (see Interner, the worker names have their own
+     * table): compared, hashed and routed by its id, the name is there for
+     * display and persistence.
+     */
+    class WorkerId {
+    public:
+        WorkerId(): entry(&names().empty()) {}
+        WorkerId(const string& name): entry(&names().intern(name)) {}
+        WorkerId(const char* name): WorkerId(string(name)) {}
+
+        uint32_t value() const { return (uint32_t)entry->index; }
+        const string& name() const { return entry->text; }
+        bool empty() const { return entry->index == 0; }
+
+        operator const string&() const { return entry->text; }
+
+        bool operator==(const WorkerId& other) const { return entry == other.entry; }
+        bool operator==(const string& other) const { return entry->text == other; }
+        bool operator==(const char* other) const { return entry->text == other; }
+
+        // The id of a name that is already interned
+        static bool find(const string& name, WorkerId& found) {
+            const Interner::Entry* entry = names().find(name);
+            if (!entry) return false;
+            found.entry = entry;
+            return true;
+        }
+
+        // Number of interned names (all the ids are below)
+        static size_t count() {
+            return names().size();
+        }
+
+    private:
+        static Interner& names() {
+            static Interner interner;
+            return interner;
+        }
+
+        const Interner::Entry* entry;
+    };
+
+    inline ostream& operator<<(ostream& os, const WorkerId& id) {
+        return os << id.name();
+    }
+
+}
+
+template<>
+struct std::hash<tools::agency::WorkerId> {
+    size_t operator()(const tools::agency::WorkerId& id) const noexcept {
+        return id.value();
+    }
+};
+
+#ifdef TEST
+
+#include "../utils/Test.hpp"
+
+using namespace tools::agency;
+
+void test_WorkerId_interning() {
+    WorkerId alice("test_WorkerId_alice");
+    WorkerId again(string("test_WorkerId_alice"));
+    WorkerId bob("test_WorkerId_bob");
+    assert(alice == again && alice.value() == again.value() && "Same name should get the same id");
+    assert(!(alice == bob) && "Different names should get different ids");
+    assert(alice == "test_WorkerId_alice" && alice == string("test_WorkerId_alice") && "Id should compare to its name");
+    assert(&alice.name() == &again.name() && "Interned name should be shared");
+    const string& name = alice;
+    assert(name == "test_WorkerId_alice" && "Id should convert to its name");
+    assert(WorkerId().empty() && WorkerId("") == WorkerId() && "Empty name should be id 0");
+}
+
+void test_WorkerId_find() {
+    WorkerId found;
+    assert(!WorkerId::find("test_WorkerId_unknown", found) && "Unknown name shouldn't be found");
+    size_t count = WorkerId::count();
+    assert(!WorkerId::find("test_WorkerId_unknown", found) && WorkerId::count() == count && "Find shouldn't intern");
+    WorkerId charlie("test_WorkerId_charlie");
+    assert(WorkerId::find("test_WorkerId_charlie", found) && found == charlie && "Known name should be found");
+    assert(hash<WorkerId>()(charlie) == charlie.value() && "Hash should be the id");
+}
+
+TEST(test_WorkerId_interning);
+TEST(test_WorkerId_find);
+
+#endif
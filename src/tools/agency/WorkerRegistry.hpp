@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "../utils/ERROR.hpp"
+#include "WorkerId.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::agency {
+
+    template<typename T>
+    class Worker;
+
+    /**
+     * The workers of an agency by id: slot lookup in O(1), names are only
+     * hashed once (when interned). Keeps the spawn order for listing.
+     * Not synchronized, the agency guards it.
+     */
+    template<typename T>
+    class WorkerRegistry {
+    public:
+        void add(Worker<T>* worker) {
+            uint32_t id = worker->getId().value();
+            if (id < slots.size() && slots[id])
+                throw ERROR("Worker '" + worker->getName() + "' already exists.");
+            if (id >= slots.size()) slots.resize(id + 1, nullptr);
+            slots[id] = worker;
+            ordered.push_back(worker);
+        }
+
+        // Returns the removed worker, nullptr if there was none
+        Worker<T>* remove(const WorkerId& id) {
+            Worker<T>* worker = find(id);
+            if (!worker) return nullptr;
+            slots[id.value()] = nullptr;
+            ordered.erase(find_if(ordered.begin(), ordered.end(), [worker](Worker<T>* w) { return w == worker; }));
+            return worker;
+        }
+
+        Worker<T>* find(const WorkerId& id) const {
+            return id.value() < slots.size() ? slots[id.value()] : nullptr;
+        }
+
+        // Doesn't intern unknown names
+        Worker<T>* find(const string& name) const {
+            WorkerId id;
+            return WorkerId::find(name, id) ? find(id) : nullptr;
+        }
+
+        // In spawn order
+        const vector<Worker<T>*>& all() const {
+            return ordered;
+        }
+
+        size_t size() const {
+            return ordered.size();
+        }
+
+        void clear() {
+            slots.clear();
+            ordered.clear();
+        }
+
+    private:
+        vector<Worker<T>*> slots; // by id, nullptr: free
+        vector<Worker<T>*> ordered;
+    };
+
+}
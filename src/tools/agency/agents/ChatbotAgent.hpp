@@ -47,6 +47,7 @@ namespace tools::agency::agents {
 
         void setTalks(bool talks) {
             safe(chatbot)->setTalks(talks);
+            this->touch();
         }
 
         void handle(const string& sender, const T& item) override {
@@ -68,7 +69,7 @@ namespace tools::agency::agents {
 
             // if (!chatbot->isTalks()) {
                 this->addRecipients({ sender });
-                this->send(response);
+                this->send(move(response));
             // }
 
             cline.setPromptVisible(true);
@@ -104,6 +105,18 @@ namespace tools::agency::agents {
         } // TODO: !@# basepath for save/load
 
         JSON toJSON() const override {
+            JSON json = toSnapshot();
+            
+            // chatbot.history.messages
+            vector<JSON> jmessages;
+            string key;
+            journal(0, jmessages, key);
+            json.set(key, jmessages);
+
+            return json;
+        }
+
+        JSON toSnapshot() const override {
             JSON json = Agent<T>::toJSON();
 
             // role
@@ -114,20 +127,21 @@ namespace tools::agency::agents {
 
             // // instructions
             // json.set("chatbot.instructions", chatbot->getInstructions());
-            
-            // chatbot.history.messages
+
+            return json;
+        }
+
+        // The history is append only, a checkpoint writes the new messages
+        size_t journal(size_t from, vector<JSON>& entries, string& key) const override {
+            key = "chatbot.history.messages";
             ChatHistory* history = (ChatHistory*)safe(chatbot->getHistoryPtr());
-            vector<ChatMessage> messages = history->getMessages();
-            vector<JSON> jmessages;
-            for (const ChatMessage& message: messages) {
+            for (const ChatMessage& message: history->getMessages(from)) {
                 JSON jmessage;
                 jmessage.set("sender", message.getSender());
                 jmessage.set("text", message.getText());
-                jmessages.push_back(jmessage);
+                entries.push_back(jmessage);
             }
-            json.set("chatbot.history.messages", jmessages);
-
-            return json;
+            return history->size();
         }
 
     private:
@@ -623,6 +637,44 @@ void test_ChatbotAgent_toJSON_talks_false() {
 }
 
 
+void test_ChatbotAgent_journal() {
+    Owns owns;
+    PackQueue<string> queue;
+    string name = "journal_agent";
+    string instructions = "test_instructions";
+    ChatHistory* history = owns.allocate<ChatHistory>("> ", false);
+    history->append("user1", "First");
+    history->append("bot1", "Second");
+    OList* plugins = owns.allocate<OList>(owns);
+    Chatbot* chatbot = owns.allocate<Chatbot>(owns, instructions, history, plugins, false);
+    TTS tts("", 0, 0, "", "", {});
+    STTSwitch sttSwitch;
+    MicView micView;
+    LinenoiseAdapter lineEditor("> ");
+    CommandLine commandLine(lineEditor, "", "", false, 10);
+    vector<Command*> commands;
+    Commander commander(commandLine, commands, "");
+    InputPipeInterceptor inputPipeInterceptor;
+    UserAgentInterface<string> interface(tts, sttSwitch, micView, commander, inputPipeInterceptor);
+
+    ChatbotAgent<string> agent(owns, nullptr, queue, name, chatbot, interface);
+
+    JSON snapshot = agent.toSnapshot();
+    assert(!snapshot.has("chatbot.history.messages") && "Snapshot shouldn't contain the history");
+    assert(snapshot.get<string>("role") == "chat" && "Snapshot should contain the role");
+
+    vector<JSON> entries;
+    string key;
+    size_t count = agent.journal(1, entries, key);
+    assert(count == 2 && key == "chatbot.history.messages" && "Journal should tell the count and the key");
+    assert(entries.size() == 1 && entries[0].get<string>("text") == "Second" && "Journal should give the messages after from");
+
+    uint64_t revision = agent.getRevision();
+    agent.setTalks(true);
+    assert(agent.getRevision() != revision && "Setting should mark the agent changed");
+}
+
+
 TEST(test_ChatbotAgent_constructor);
 TEST(test_ChatbotAgent_type);
 TEST(test_ChatbotAgent_setTalks);
@@ -636,5 +688,6 @@ TEST(test_ChatbotAgent_fromJSON_incorrect_role);
 TEST(test_ChatbotAgent_toJSON_basic);
 TEST(test_ChatbotAgent_toJSON_empty_history);
 TEST(test_ChatbotAgent_toJSON_talks_false);
+TEST(test_ChatbotAgent_journal);
 
 #endif
@@ -84,7 +84,7 @@ namespace tools::agency::agents {
             // if (tts.is_speaking()) tts.speak_stop();
 
             // interface.getCommanderRef().getCommandLineRef().setPromptVisible(false);
-            this->send(input);
+            this->send(move(input), Priority::Interactive); // overtakes the agents' chatter
         }
 
         void handle(const string& /*sender*/, const T& /*item*/) override {
@@ -137,6 +137,11 @@ namespace tools::agency::agents {
             return confirmed;
         }
         
+    protected:
+
+        // tick() waits for the input itself
+        void wait(long) override {}
+
     private:
         UserAgentInterface<T>& interface;
         vector<string> inputs = {};
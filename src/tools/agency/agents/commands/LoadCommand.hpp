@@ -122,15 +122,7 @@ namespace tools::agency::agents::commands {
         }
 
         void loadAgency(Agency<T>& agency, const string& filename) {
-            JSON json(file_get_contents(filename));
-            vector<string> fworkers = json.get<vector<string>>("workers");
-            vector<JSON> jworkers;
-            for (const string& fworker: fworkers) {
-                JSON jworker(file_get_contents(fworker));
-                jworkers.push_back(jworker);
-            }
-            json.set("workers", jworkers);
-            agency.fromJSON(json);
+            agency.restore(filename);
         }
 
     };
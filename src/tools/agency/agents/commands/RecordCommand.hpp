@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../../../cmd/Usage.hpp"
+#include "../../../cmd/Parameter.hpp"
+#include "../../../cmd/Command.hpp"
+#include "../../Agency.hpp"
+#include "../UserAgent.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::cmd;
+using namespace tools::agency;
+using namespace tools::agency::agents;
+
+namespace tools::agency::agents::commands {
+
+    // Not registered in prompt.cpp yet (that file is edited by humans only):
+    // include this header there, add
+    // if (in_array("record", command_factory_commands)) cfactory.withCommand<RecordCommand<PackT>>(commander.getPrefix());
+    // next to the other commands and "record" to the available_commands of
+    // prompt.config.json
+    template<typename T>
+    class RecordCommand: public Command {
+    public:
+
+        using Command::Command;
+        virtual ~RecordCommand() {}
+
+        static inline const string defaultFile = "packs.pklg";
+
+        vector<string> getPatterns() const override {
+            return {
+                this->prefix + "record start",
+                this->prefix + "record start {string}",
+                this->prefix + "record stop",
+            };
+        }
+
+        string getName() const override {
+            return this->prefix + "record";
+        }
+
+        string getDescription() const override {
+            return "Records the packs going through the agency into a binary log for replay.";
+        }
+
+        string getUsage() const override {
+            return implode("\n", vector<string>({
+                Usage({
+                    getName(), // command
+                    getDescription(), // help
+                    vector<Parameter>({ // parameters
+                        {
+                            string("action"), // name
+                            bool(false), // optional
+                            string("Action to perform (start|stop)") // help
+                        },
+                        {
+                            string("file"), // name
+                            bool(true), // optional
+                            string("Log file (start only), defaults to " + defaultFile) // help
+                        }
+                    }),
+                    vector<pair<string, string>>({ // examples
+                        make_pair(this->prefix + "record start", "Start recording into " + defaultFile),
+                        make_pair(this->prefix + "record start session.pklg", "Start recording into session.pklg"),
+                        make_pair(this->prefix + "record stop", "Stop recording")
+                    }),
+                    vector<string>({ // notes
+                        string("Starting again overwrites the log"),
+                        string("Replay it with builds/benchmarks/pack_replay --log=<file>")
+                    })
+                }).to_string()
+            }));
+        }
+
+        void run(void* worker_void, const vector<string>& args) override {
+            Worker<T>& worker = *safe((Worker<T>*)worker_void);
+            Agency<T>& agency = *safe((Agency<T>*)worker.getAgencyPtr());
+            UserAgent<T>& user = (UserAgent<T>&)agency.getWorkerRef("user");
+            UserAgentInterface<T>& interface = user.getInterfaceRef();
+
+            string action = args.size() > 1 ? args[1] : "";
+            if (action == "start") {
+                string filename = args.size() > 2 ? args[2] : defaultFile;
+                agency.record(filename);
+                interface.println("Recording packs into: " + filename);
+                return;
+            }
+            if (action == "stop") {
+                size_t recorded = agency.getRecorded();
+                agency.record("");
+                interface.println("Recording stopped, " + to_string(recorded) + " pack(s) recorded.");
+                return;
+            }
+
+            throw ERROR("Unrecognised record command: '" + implode(" ", args) + "'");
+        }
+
+    };
+
+}
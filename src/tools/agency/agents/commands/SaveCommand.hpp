@@ -135,17 +135,9 @@ namespace tools::agency::agents::commands {
             file_put_contents(filename, agency.getWorkerRef(name).toJSON().dump(4), false, true);
         }
 
+        // Rewrites only the workers changed since the last save (see Checkpoint)
         void saveAgency(Agency<T>& agency, const string& filename) {
-            JSON jagency = agency.toJSON();
-            vector<JSON> jworkers = jagency.get<vector<JSON>>("workers");
-            vector<string> fworkers;
-            for (const JSON& jworker: jworkers) {
-                string fworker = jworker.get<string>("name") + ".json";
-                file_put_contents(fworker, jworker.dump(4), false, true);
-                fworkers.push_back(fworker);
-            }
-            jagency.set("workers", fworkers);
-            file_put_contents(filename, jagency.dump(4), false, true);
+            agency.checkpoint(filename);
         }
 
     };
@@ -75,28 +75,46 @@ namespace tools::agency::agents::commands {
                     vector<pair<string, string>>({ // examples
                         make_pair(this->prefix + "spawn worker", "Creates worker agent"),
                         make_pair(this->prefix + "spawn bot mybot", "Creates bot agent named 'mybot'"),
-                        make_pair(this->prefix + "spawn bot mybot user1,user2", "Creates bot agent with recipients")
+                        make_pair(this->prefix + "spawn bot mybot user1,user2", "Creates bot agent with recipients"),
+                        make_pair(this->prefix + "spawn bot@node2 mybot", "Creates bot agent 'mybot' in the connected node 'node2'")
                     }),
                     vector<string>({ // notes
                         string("Role must match an existing role type"),
                         string("Names must be unique within the agency"),
-                        string("Default recipient is the current user")
+                        string("Default recipient is the current user"),
+                        string("role@node spawns in a connected node (see Agency::connect()), the role has to exist there")
                     })
                 }).to_string()
             }));
         }
         
-        void run(void* /*agency_void*/, const vector<string>& args) override {
+        void run(void* worker_void, const vector<string>& args) override {
             // NULLCHK(agency_void);
             // Agency<T>& agency = *(Agency<T>*)agency_void;
 
             if (args.size() < 2) throw ERROR("Missing argument(s): use: /spawn <role> [<name>] [<recipients>]");
             string role = trim(args[1]);
+            string node = "";
+            size_t at = role.find('@');
+            if (at != string::npos) {
+                node = role.substr(at + 1);
+                role = role.substr(0, at);
+            }
             string name = args.size() >= 3 ? trim(args[2]) : role;
             vector<string> recipients = args.size() >= 4 
                 ? parse_vector<string>(args[3]) 
                 : vector<string>({ "user" }); // TODO: what's going on??? UserAgent("user").getName()??? what?? "user" is already the name, isn't it??
 
+            if (!node.empty()) {
+                Worker<T>& worker = *safe((Worker<T>*)worker_void);
+                Agency<T>& agency = *safe((Agency<T>*)worker.getAgencyPtr());
+                JSON json;
+                json.set("role", role);
+                json.set("recipients", recipients);
+                agency.spawnAt(node, role, name, json);
+                return;
+            }
+
             if (!in_array(role, array_keys(roles))) {
                 throw ERROR("Invalid agent role: " + role + " - available roles are [" + implode(", ", array_keys(roles)) + "]");
             }
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../../../utils/Tracer.hpp"
+#include "../../../utils/files.hpp"
+#include "../../../cmd/Usage.hpp"
+#include "../../../cmd/Parameter.hpp"
+#include "../../../cmd/Command.hpp"
+#include "../../Agency.hpp"
+#include "../UserAgent.hpp"
+
+using namespace std;
+using namespace tools::utils;
+using namespace tools::cmd;
+using namespace tools::agency;
+using namespace tools::agency::agents;
+
+namespace tools::agency::agents::commands {
+
+    // Not registered in prompt.cpp yet (that file is edited by humans only):
+    // include this header there, add
+    // if (in_array("trace", command_factory_commands)) cfactory.withCommand<TraceCommand<PackT>>(commander.getPrefix());
+    // next to the other commands and "trace" to the available_commands of
+    // prompt.config.json
+    template<typename T>
+    class TraceCommand: public Command {
+    public:
+
+        using Command::Command;
+        virtual ~TraceCommand() {}
+
+        static inline const string defaultFile = "trace.json";
+
+        vector<string> getPatterns() const override {
+            return {
+                this->prefix + "trace on",
+                this->prefix + "trace off",
+                this->prefix + "trace clear",
+                this->prefix + "trace dump",
+                this->prefix + "trace dump {string}",
+            };
+        }
+
+        string getName() const override {
+            return this->prefix + "trace";
+        }
+
+        string getDescription() const override {
+            return "Records pack and chat plugin spans and dumps them as Chrome trace JSON.";
+        }
+
+        string getUsage() const override {
+            return implode("\n", vector<string>({
+                Usage({
+                    getName(), // command
+                    getDescription(), // help
+                    vector<Parameter>({ // parameters
+                        {
+                            string("action"), // name
+                            bool(false), // optional
+                            string("Action to perform (on|off|clear|dump)") // help
+                        },
+                        {
+                            string("file"), // name
+                            bool(true), // optional
+                            string("File to dump the trace into (dump only), defaults to " + defaultFile) // help
+                        }
+                    }),
+                    vector<pair<string, string>>({ // examples
+                        make_pair(this->prefix + "trace on", "Start recording"),
+                        make_pair(this->prefix + "trace dump", "Write the recorded spans to " + defaultFile),
+                        make_pair(this->prefix + "trace dump slow_chat.json", "Write the recorded spans to slow_chat.json"),
+                        make_pair(this->prefix + "trace clear", "Forget the recorded spans")
+                    }),
+                    vector<string>({ // notes
+                        string("Open the dump in https://ui.perfetto.dev or chrome://tracing"),
+                        string("Every thread keeps its latest " + to_string(Tracer::bufferSize) + " events")
+                    })
+                }).to_string()
+            }));
+        }
+
+        void run(void* worker_void, const vector<string>& args) override {
+            Worker<T>& worker = *safe((Worker<T>*)worker_void);
+            Agency<T>& agency = *safe((Agency<T>*)worker.getAgencyPtr());
+            UserAgent<T>& user = (UserAgent<T>&)agency.getWorkerRef("user");
+            UserAgentInterface<T>& interface = user.getInterfaceRef();
+            Tracer& tracer = Tracer::instance();
+
+            string action = args.size() > 1 ? args[1] : "";
+            if (action == "on" || action == "off") {
+                tracer.enable(action == "on");
+                interface.println("Tracing is " + string(action == "on" ? "ON" : "OFF"));
+                return;
+            }
+            if (action == "clear") {
+                tracer.clear();
+                interface.println("Trace cleared.");
+                return;
+            }
+            if (action == "dump") {
+                string filename = args.size() > 2 ? args[2] : defaultFile;
+                size_t events = tracer.collect().size();
+                file_put_contents(filename, tracer.dump(), false, true);
+                interface.println("Trace of " + to_string(events) + " event(s) written to: " + filename);
+                return;
+            }
+
+            throw ERROR("Unrecognised trace command: '" + implode(" ", args) + "'");
+        }
+
+    };
+
+}
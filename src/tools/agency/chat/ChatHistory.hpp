@@ -26,6 +26,14 @@ namespace tools::agency::chat {
         virtual ~ChatHistory() {}
 
         vector<ChatMessage> getMessages() const { return messages; }
+
+        // The messages after the first from ones
+        vector<ChatMessage> getMessages(size_t from) const {
+            if (from >= messages.size()) return {};
+            return vector<ChatMessage>(messages.begin() + from, messages.end());
+        }
+
+        size_t size() const { return messages.size(); }
     
         void append(const string& sender, const string& text) {        
             ChatMessage message(sender, text);
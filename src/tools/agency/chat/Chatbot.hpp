@@ -1,10 +1,12 @@
 #pragma once
 
 #include <string>
+#include <typeinfo>
 
 // #include "../../utils/Printer.hpp"
 // #include "../../voice/TTS.hpp"
 // #include "../../voice/SentenceStream.hpp"
+#include "../../utils/Tracer.hpp"
 #include "ChatHistory.hpp"
 #include "ChatPlugin.hpp"
 
@@ -61,8 +63,11 @@ namespace tools::agency::chat {
 
         virtual string getInstructions() { 
             string proceed = "";// this->instructions;
-            for (void* plugin: plugins->getPlugs())
-                proceed = ((ChatPlugin*)safe(plugin))->processInstructions(this, proceed);
+            for (void* plugin: plugins->getPlugs()) {
+                ChatPlugin* plug = (ChatPlugin*)safe(plugin);
+                TraceSpan span("chat", "processInstructions", typeid(*plug).name(), 0, true);
+                proceed = plug->processInstructions(this, proceed);
+            }
             return proceed; 
         }
 
@@ -80,8 +85,11 @@ namespace tools::agency::chat {
         // prompt completion call
         virtual string completion(const string& sender, const string& text) {
             string proceed = text;
-            for (void* plugin: plugins->getPlugs())
-                proceed = ((ChatPlugin*)safe(plugin))->processCompletion(this, sender, proceed);
+            for (void* plugin: plugins->getPlugs()) {
+                ChatPlugin* plug = (ChatPlugin*)safe(plugin);
+                TraceSpan span("chat", "processCompletion", typeid(*plug).name(), 0, true);
+                proceed = plug->processCompletion(this, sender, proceed);
+            }
             return proceed; 
 
             // if (talks) throw ERROR("Talkbots does not support full completion resonse.");
@@ -94,8 +102,11 @@ namespace tools::agency::chat {
             // DEBUG(sender);
             // DEBUG(text);
             string proceed = text;
-            for (void* plugin: plugins->getPlugs())
-                proceed = ((ChatPlugin*)safe(plugin))->processChat(this, sender, proceed, interrupted);
+            for (void* plugin: plugins->getPlugs()) {
+                ChatPlugin* plug = (ChatPlugin*)safe(plugin);
+                TraceSpan span("chat", "processChat", typeid(*plug).name(), 0, true);
+                proceed = plug->processChat(this, sender, proceed, interrupted);
+            }
             // DEBUG(proceed);
             return proceed; 
         }
@@ -103,8 +114,11 @@ namespace tools::agency::chat {
         // on stream chunk recieved
         virtual string chunk(const string& chunk) {
             string proceed = chunk;
-            for (void* plugin: plugins->getPlugs())
-                proceed = ((ChatPlugin*)safe(plugin))->processChunk(this, proceed);
+            for (void* plugin: plugins->getPlugs()) {
+                ChatPlugin* plug = (ChatPlugin*)safe(plugin);
+                TraceSpan span("chat", "processChunk", typeid(*plug).name(), 0, true);
+                proceed = plug->processChunk(this, proceed);
+            }
             return proceed; 
 
             // if (talks) { // talkbot:
@@ -130,8 +144,11 @@ namespace tools::agency::chat {
         // on full response recieved
         virtual string response(const string& response) {
             string proceed = response;
-            for (void* plugin: plugins->getPlugs())
-                proceed = ((ChatPlugin*)safe(plugin))->processResponse(this, proceed);
+            for (void* plugin: plugins->getPlugs()) {
+                ChatPlugin* plug = (ChatPlugin*)safe(plugin);
+                TraceSpan span("chat", "processResponse", typeid(*plug).name(), 0, true);
+                proceed = plug->processResponse(this, proceed);
+            }
             return proceed; 
 
             // if (talks) {
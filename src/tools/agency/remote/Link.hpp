@@ -0,0 +1,228 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+
+#include "../../utils/UnixSocket.hpp"
+#include "Wire.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::agency::remote {
+
+    struct LinkStats {
+        size_t sent = 0;     // frames
+        size_t received = 0; // frames
+        size_t writes = 0;   // socket writes, sent / writes: frames per batch
+        size_t bytes = 0;    // written
+    };
+
+    /**
+     * Connection to another node (agency process).
+     *
+     * send() only appends the frame to the outbox and returns, nobody
+     * waits for a reply (pipelining). The writer thread writes whatever
+     * piled up meanwhile in one go, so the small frames of a busy link
+     * are batched into few writes. The reader thread hands the frames
+     * to the receiver in arrival order.
+     */
+    class Link {
+    public:
+        using Receiver = function<void(Frame&)>;
+        using Closer = function<void()>;
+
+        static constexpr size_t readSize = 64 << 10;
+
+        Link(UnixSocket&& socket): socket(move(socket)) {}
+
+        ~Link() { close(); }
+
+        Link(const Link&) = delete;
+        Link& operator=(const Link&) = delete;
+
+        // The closer is called (on the reader thread) when the peer is gone
+        void start(Receiver receiver, Closer closer) {
+            writer = thread([this]() { writing(); });
+            reader = thread([this, receiver, closer]() { reading(receiver, closer); });
+        }
+
+        // False if the link is closed
+        bool send(const Frame& frame) {
+            {
+                lock_guard<mutex> lock(mtx);
+                if (closed) return false;
+                Wire::encode(frame, outbox);
+                stats.sent++;
+            }
+            pending.notify_one();
+            return true;
+        }
+
+        // Flushes the outbox and stops, the closer is not called.
+        // Not from the receiver.
+        void close() {
+            {
+                lock_guard<mutex> lock(mtx);
+                closing = true;
+                closed = true;
+            }
+            pending.notify_all();
+            if (writer.joinable()) writer.join();
+            socket.shutdown();
+            if (reader.joinable()) reader.join();
+            socket.close();
+        }
+
+        bool isOpen() const {
+            lock_guard<mutex> lock(mtx);
+            return !closed;
+        }
+
+        // Name of the node at the other end (see FrameType::Hello)
+        string getNode() const {
+            lock_guard<mutex> lock(mtx);
+            return node;
+        }
+
+        void setNode(const string& node) {
+            {
+                lock_guard<mutex> lock(mtx);
+                this->node = node;
+            }
+            named.notify_all();
+        }
+
+        // Waits up to ms for the node name, false on timeout or close
+        bool waitNode(long ms) {
+            unique_lock<mutex> lock(mtx);
+            return named.wait_for(lock, chrono::milliseconds(ms), [this]() { return !node.empty() || closed; }) && !node.empty();
+        }
+
+        LinkStats getStats() const {
+            lock_guard<mutex> lock(mtx);
+            return stats;
+        }
+
+    private:
+        void writing() {
+            string batch;
+            bool written = true;
+            unique_lock<mutex> lock(mtx);
+            while (written) {
+                pending.wait(lock, [this]() { return !outbox.empty() || closed; });
+                if (outbox.empty()) break; // closed and flushed
+                batch.swap(outbox);
+                stats.writes++;
+                stats.bytes += batch.size();
+                lock.unlock();
+                written = socket.write(batch.data(), batch.size());
+                batch.clear();
+                lock.lock();
+            }
+            if (written) return;
+            closed = true; // peer is gone
+            outbox.clear();
+            lock.unlock();
+            socket.shutdown(); // wakes the reader
+        }
+
+        void reading(Receiver receiver, Closer closer) {
+            FrameReader frames;
+            Frame frame;
+            string buff(readSize, '\0');
+            try {
+                while (size_t n = socket.read(buff.data(), buff.size())) {
+                    frames.feed(buff.data(), n);
+                    while (frames.next(frame)) {
+                        {
+                            lock_guard<mutex> lock(mtx);
+                            stats.received++;
+                        }
+                        receiver(frame);
+                    }
+                }
+            } catch (exception& e) {
+                // broken stream, drops the link
+            }
+            bool local;
+            {
+                lock_guard<mutex> lock(mtx);
+                local = closing;
+                closed = true;
+            }
+            pending.notify_all();
+            named.notify_all();
+            if (!local) closer();
+        }
+
+        UnixSocket socket;
+        mutable mutex mtx;
+        condition_variable pending;
+        condition_variable named;
+        string outbox;
+        string node;
+        bool closed = false;
+        bool closing = false; // closed by us
+        LinkStats stats;
+        thread writer;
+        thread reader;
+    };
+
+}
+
+#ifdef TEST
+
+#include "../../utils/Test.hpp"
+
+using namespace tools::agency::remote;
+
+void test_Link_batches_in_order() {
+    auto [a, b] = UnixSocket::makePair();
+    Link sender(move(a));
+    Link receiver(move(b));
+    mutex mtx;
+    condition_variable done;
+    vector<string> received;
+    const size_t count = 2000;
+    sender.start([](Frame&) {}, []() {});
+    receiver.start([&](Frame& frame) {
+        lock_guard<mutex> lock(mtx);
+        received.push_back(frame.fields[0]);
+        if (received.size() == count) done.notify_one();
+    }, []() {});
+    for (size_t i = 0; i < count; i++)
+        assert(sender.send({ FrameType::Pack, { to_string(i) } }) && "Open link should send");
+    {
+        unique_lock<mutex> lock(mtx);
+        assert(done.wait_for(lock, chrono::seconds(5), [&]() { return received.size() == count; }) && "All frames should arrive");
+    }
+    for (size_t i = 0; i < count; i++) assert(received[i] == to_string(i) && "Frames should arrive in order");
+    LinkStats stats = sender.getStats();
+    assert(stats.sent == count && stats.writes >= 1 && stats.writes <= count && "Writes should not exceed the frames");
+    assert(receiver.getStats().received == count && "Receiver should count the frames");
+}
+
+void test_Link_closer_on_peer_gone() {
+    auto [a, b] = UnixSocket::makePair();
+    Link* local = new Link(move(a));
+    Link remote(move(b));
+    atomic<bool> localClosed = false, remoteClosed = false;
+    local->start([](Frame&) {}, [&]() { localClosed = true; });
+    remote.start([](Frame&) {}, [&]() { remoteClosed = true; });
+    assert(remote.waitNode(10) == false && "No hello, no node");
+    delete local; // closes
+    for (int i = 0; i < 500 && !remoteClosed; i++) this_thread::sleep_for(chrono::milliseconds(1));
+    assert(!remote.isOpen() && remoteClosed && "Peer should see the link closed");
+    assert(!localClosed && "Local close should not call the closer");
+    assert(!remote.send({ FrameType::Kill, { "x" } }) && "Closed link should not send");
+}
+
+TEST(test_Link_batches_in_order);
+TEST(test_Link_closer_on_peer_gone);
+
+#endif
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <unistd.h>
+
+#include "../../containers/array_key_exists.hpp"
+#include "../../containers/in_array.hpp"
+#include "../../utils/ERROR.hpp"
+#include "../../utils/JSON.hpp"
+#include "../../utils/UnixSocket.hpp"
+#include "RemoteWorker.hpp"
+#include "Link.hpp"
+
+using namespace std;
+using namespace tools::containers;
+using namespace tools::utils;
+
+namespace tools::agency {
+
+    template<typename T>
+    class Agency;
+
+}
+
+namespace tools::agency::remote {
+
+    /**
+     * The links of an agency to the other nodes (agency processes) over
+     * Unix domain sockets. The workers of each node show up in the other
+     * as RemoteWorkers: they join with the hello of the node and with its
+     * later spawns, and leave with its kills or when the link is gone.
+     */
+    template<typename T>
+    class Nodes {
+    public:
+        // how long connect() waits for the hello of the other node
+        static constexpr long connectTimeoutMs = 1000;
+
+        // how often the listener checks if it should stop
+        static constexpr int acceptPollMs = 100;
+
+        Nodes(Agency<T>& agency): agency(agency) {}
+
+        ~Nodes() {
+            listen("");
+        }
+
+        // Name of this agency for the other nodes, set it before listen()
+        // or connect(), defaults to <agency name>@<pid>
+        string getNode() const {
+            lock_guard<mutex> lock(links_mtx);
+            return localNode();
+        }
+
+        void setNode(const string& node) {
+            lock_guard<mutex> lock(links_mtx);
+            this->node = node;
+        }
+
+        // The name is set (not the default)
+        bool isNamed() const {
+            lock_guard<mutex> lock(links_mtx);
+            return !node.empty();
+        }
+
+        // Accepts the connect() of other nodes at path ("": stops listening)
+        void listen(const string& path) {
+            accepting = false;
+            if (listening.joinable()) listening.join();
+            listener.close();
+            {
+                lock_guard<mutex> lock(links_mtx);
+                listenPath = path;
+            }
+            if (path.empty()) return;
+            listener = UnixSocket::listen(path);
+            accepting = true;
+            listening = thread([this]() {
+                while (accepting) {
+                    try {
+                        UnixSocket socket = listener.accept(acceptPollMs);
+                        if (socket.valid()) link(move(socket));
+                    } catch (exception &e) {
+                        agency.hoops("Listener error: " + string(e.what()));
+                    }
+                }
+            });
+        }
+
+        // "": not listening
+        string getListening() const {
+            lock_guard<mutex> lock(links_mtx);
+            return listenPath;
+        }
+
+        // Joins the node listening at path, returns its name
+        string connect(const string& path) {
+            shared_ptr<Link> link = this->link(UnixSocket::connect(path));
+            if (!link->waitNode(connectTimeoutMs)) {
+                closeLink(link);
+                throw ERROR("No hello from node at " + path);
+            }
+            lock_guard<mutex> lock(links_mtx);
+            if (!in_array(path, connected)) connected.push_back(path);
+            return link->getNode();
+        }
+
+        // The paths joined by connect()
+        vector<string> getConnected() const {
+            lock_guard<mutex> lock(links_mtx);
+            return connected;
+        }
+
+        // Closes the links to the node ("": to every node), its workers
+        // leave here
+        void disconnect(const string& node = "") {
+            vector<shared_ptr<Link>> closing;
+            {
+                lock_guard<mutex> lock(links_mtx);
+                for (const shared_ptr<Link>& link: links)
+                    if (node.empty() || link->getNode() == node) closing.push_back(link);
+                if (node.empty()) connected.clear();
+            }
+            for (shared_ptr<Link>& link: closing) closeLink(link);
+        }
+
+        // Spawns a worker of the role in the node (the role has to be known
+        // there), it joins here as a RemoteWorker
+        void spawnAt(const string& node, const string& role, const string& name, const JSON& json) {
+            shared_ptr<Link> link;
+            {
+                lock_guard<mutex> lock(links_mtx);
+                for (const shared_ptr<Link>& candidate: links)
+                    if (candidate->isOpen() && candidate->getNode() == node) link = candidate;
+            }
+            if (!link || !link->send({ FrameType::Spawn, { role, name, json.dump() } }))
+                throw ERROR("Node not connected: " + node);
+        }
+
+        vector<string> getNodes() const {
+            vector<string> nodes;
+            lock_guard<mutex> lock(links_mtx);
+            for (const shared_ptr<Link>& link: links)
+                if (link->isOpen() && !link->getNode().empty()) nodes.push_back(link->getNode());
+            return nodes;
+        }
+
+        map<string, LinkStats> getLinkStats() const {
+            map<string, LinkStats> stats;
+            lock_guard<mutex> lock(links_mtx);
+            for (const shared_ptr<Link>& link: links)
+                stats[link->getNode()] = link->getStats();
+            return stats;
+        }
+
+        // Tells the other nodes (Joined / Left)
+        void announce(const Frame& frame) {
+            lock_guard<mutex> lock(links_mtx);
+            for (const shared_ptr<Link>& link: links) link->send(frame);
+        }
+
+        // The link of a remote worker, nullptr for a local one
+        shared_ptr<Link> linkOf(const string& name) const {
+            lock_guard<mutex> lock(agency.workers_mtx);
+            const RemoteWorker<T>* remote = remote_of(agency.workers.find(name));
+            return remote ? remote->getLinkRef() : nullptr;
+        }
+
+    private:
+
+        // See getNode(), needs links_mtx
+        string localNode() const {
+            return node.empty() ? agency.getName() + "@" + to_string(getpid()) : node;
+        }
+
+        // The hello goes out first, the later spawns are announced
+        shared_ptr<Link> link(UnixSocket&& socket) {
+            shared_ptr<Link> link = make_shared<Link>(move(socket));
+            Link* raw = link.get(); // the callbacks end before the link
+            vector<shared_ptr<Link>> closed;
+            {
+                lock_guard<mutex> lock(links_mtx);
+                for (auto it = links.begin(); it != links.end();) {
+                    if ((*it)->isOpen()) it++;
+                    else {
+                        closed.push_back(*it);
+                        it = links.erase(it);
+                    }
+                }
+                vector<string> hello = { localNode() };
+                {
+                    lock_guard<mutex> workers_lock(agency.workers_mtx);
+                    for (const Worker<T>* worker: agency.workers.all())
+                        if (!remote_of(worker)) hello.push_back(worker->getName());
+                }
+                link->send({ FrameType::Hello, hello });
+                links.push_back(link);
+            }
+            link->start(
+                [this, raw](Frame& frame) { receive(*raw, frame); },
+                [this, raw]() { leave(*raw); }
+            );
+            return link;
+        }
+
+        void closeLink(const shared_ptr<Link>& link) {
+            {
+                lock_guard<mutex> lock(links_mtx);
+                links.erase(remove(links.begin(), links.end(), link), links.end());
+            }
+            link->close();
+            leave(*link);
+        }
+
+        // On the reader thread of the link
+        void receive(Link& link, const Frame& frame) {
+            try {
+                const vector<string>& fields = frame.fields;
+                switch (frame.type) {
+                    case FrameType::Hello:
+                        link.setNode(fields.at(0));
+                        for (size_t i = 1; i < fields.size(); i++) join(link, fields[i]);
+                        break;
+                    case FrameType::Pack: {
+                        Priority priority = fields.size() > 3 && fields[3].size() == 1 && (size_t)fields[3][0] < priorities ?
+                            (Priority)fields[3][0] : Priority::Normal;
+                        agency.getQueueRef().Produce(Pack<T>(fields.at(0), fields.at(1), Payload<T>(Codec<T>::decode(fields.at(2))), priority));
+                        break;
+                    }
+                    case FrameType::Spawn: {
+                        const string& role = fields.at(0);
+                        if (!array_key_exists(role, agency.roles))
+                            throw ERROR("Role not exists: " + role);
+                        agency.roles[role](fields.at(1), JSON(fields.at(2)));
+                        break;
+                    }
+                    case FrameType::Kill:
+                        if (!linkOf(fields.at(0))) (void)agency.kill(fields.at(0));
+                        break;
+                    case FrameType::Joined:
+                        join(link, fields.at(0));
+                        break;
+                    case FrameType::Left:
+                        if (linkOf(fields.at(0)).get() == &link) agency.dismiss(fields.at(0));
+                        break;
+                    default:
+                        throw ERROR("Unknown frame type: " + to_string((int)frame.type));
+                }
+            } catch (exception &e) {
+                agency.hoops("Node '" + link.getNode() + "' error: " + string(e.what()));
+            }
+        }
+
+        // A worker of the node shows up here (unless the name is taken)
+        void join(Link& link, const string& name) {
+            shared_ptr<Link> shared;
+            {
+                lock_guard<mutex> lock(links_mtx);
+                for (const shared_ptr<Link>& candidate: links)
+                    if (candidate.get() == &link) shared = candidate;
+            }
+            if (!shared || agency.hasWorker(name)) return;
+            agency.template spawn<RemoteWorker<T>>(agency.getOwnsRef(), &agency, agency.getQueueRef(), name, shared);
+        }
+
+        // The workers of the node leave here
+        void leave(Link& link) {
+            vector<string> names;
+            {
+                lock_guard<mutex> lock(agency.workers_mtx);
+                for (const Worker<T>* worker: agency.workers.all()) {
+                    const RemoteWorker<T>* remote = remote_of(worker);
+                    if (remote && remote->getLinkRef().get() == &link) names.push_back(worker->getName());
+                }
+            }
+            for (const string& name: names) agency.dismiss(name);
+        }
+
+        Agency<T>& agency;
+        string node; // see getNode()
+        UnixSocket listener;
+        string listenPath;
+        thread listening;
+        atomic<bool> accepting = false;
+        mutable mutex links_mtx;
+        vector<shared_ptr<Link>> links; // to the other nodes
+        vector<string> connected; // paths, see connect()
+    };
+
+}
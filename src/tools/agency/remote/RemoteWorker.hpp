@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "../Worker.hpp"
+#include "Link.hpp"
+
+using namespace std;
+
+namespace tools::agency::remote {
+
+    // Stand-in of a worker living in another node: the packs routed to
+    // it go down the link (see Agency::connect())
+    template<typename T>
+    class RemoteWorker: public Worker<T> {
+    public:
+        RemoteWorker(
+            Owns& owns,
+            Worker<T>* agency,
+            PackQueue<T>& queue,
+            const string& name,
+            shared_ptr<Link> link
+        ):
+            Worker<T>(owns, agency, queue, name),
+            link(link)
+        {}
+
+        virtual ~RemoteWorker() {}
+
+        string type() const override { return "remote"; }
+
+        void handle(const string& sender, const T& item) override {
+            string priority(1, (char)this->getHandling()); // of the pack forwarded
+            if (!link->send({ FrameType::Pack, { sender, this->getName(), Codec<T>::encode(item), priority } }))
+                throw ERROR("Node '" + link->getNode() + "' of worker '" + this->getName() + "' is disconnected, pack dropped.");
+        }
+
+        string dump() const override {
+            return "Worker '" + this->getName() + "' is a remote worker in node '" + link->getNode() + "'.";
+        }
+
+        const shared_ptr<Link>& getLinkRef() const { return link; }
+
+    private:
+        shared_ptr<Link> link;
+    };
+
+    // nullptr for a local worker
+    template<typename T>
+    const RemoteWorker<T>* remote_of(const Worker<T>* worker) {
+        return dynamic_cast<const RemoteWorker<T>*>(worker);
+    }
+
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include "../../utils/ERROR.hpp"
+#include "../../utils/JSON.hpp"
+
+using namespace std;
+using namespace tools::utils;
+
+namespace tools::agency::remote {
+
+    enum class FrameType: uint8_t {
+        Hello = 1, // node, names of its workers...
+        Pack,      // sender, recipient, item, priority (a byte)
+        Spawn,     // role, name, json
+        Kill,      // name
+        Joined,    // name (a worker spawned in the node)
+        Left,      // name (a worker killed in the node)
+    };
+
+    struct Frame {
+        FrameType type;
+        vector<string> fields;
+    };
+
+    /**
+     * Length-prefixed binary framing:
+     *   u32 size of the rest | u8 type | (u32 size | bytes) per field
+     * integers little endian.
+     */
+    class Wire {
+    public:
+        static constexpr size_t maxFrameSize = 64 << 20;
+
+        // Appends the frame to out
+        static void encode(const Frame& frame, string& out) {
+            size_t size = 1;
+            for (const string& field: frame.fields) size += 4 + field.size();
+            if (size > maxFrameSize) throw ERROR("Frame too large: " + to_string(size) + " bytes");
+            out.reserve(out.size() + 4 + size);
+            put(out, (uint32_t)size);
+            out.push_back((char)frame.type);
+            for (const string& field: frame.fields) {
+                put(out, (uint32_t)field.size());
+                out.append(field);
+            }
+        }
+
+        static uint32_t get(const char* data) {
+            const unsigned char* bytes = (const unsigned char*)data;
+            return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+        }
+
+    private:
+        static void put(string& out, uint32_t value) {
+            char bytes[4] = { (char)(value & 0xff), (char)((value >> 8) & 0xff), (char)((value >> 16) & 0xff), (char)((value >> 24) & 0xff) };
+            out.append(bytes, 4);
+        }
+    };
+
+    // Cuts the frames out of a byte stream, fed in any chunks
+    class FrameReader {
+    public:
+        void feed(const char* data, size_t size) {
+            if (offset && offset == buffer.size()) {
+                buffer.clear();
+                offset = 0;
+            }
+            buffer.append(data, size);
+        }
+
+        // Throws on a broken stream
+        bool next(Frame& frame) {
+            size_t available = buffer.size() - offset;
+            if (available < 4) return false;
+            const char* data = buffer.data() + offset;
+            uint32_t size = Wire::get(data);
+            if (!size || size > Wire::maxFrameSize) throw ERROR("Invalid frame size: " + to_string(size));
+            if (available < 4 + (size_t)size) return false;
+            const char* end = data + 4 + size;
+            const char* p = data + 4;
+            frame.type = (FrameType)*p++;
+            frame.fields.clear();
+            while (p < end) {
+                if (end - p < 4) throw ERROR("Broken frame field");
+                uint32_t length = Wire::get(p);
+                p += 4;
+                if ((size_t)(end - p) < length) throw ERROR("Broken frame field");
+                frame.fields.emplace_back(p, length);
+                p += length;
+            }
+            offset += 4 + size;
+            if (offset > buffer.size() / 2) { // keeps the buffer small
+                buffer.erase(0, offset);
+                offset = 0;
+            }
+            return true;
+        }
+
+    private:
+        string buffer;
+        size_t offset = 0;
+    };
+
+    // Item bytes on the wire, JSON by default
+    template<typename T>
+    struct Codec {
+        static string encode(const T& item) { return json(item).dump(); }
+        static T decode(const string& data) { return json::parse(data).get<T>(); }
+    };
+
+    template<>
+    struct Codec<string> {
+        static const string& encode(const string& item) { return item; }
+        static string decode(const string& data) { return data; }
+    };
+
+}
+
+#ifdef TEST
+
+#include "../../utils/Test.hpp"
+
+using namespace tools::agency::remote;
+
+void test_Wire_roundtrip_in_chunks() {
+    string stream;
+    Wire::encode({ FrameType::Pack, { "alice", "bob", string("hi\0there", 8) } }, stream);
+    Wire::encode({ FrameType::Kill, { "bob" } }, stream);
+    Wire::encode({ FrameType::Hello, {} }, stream);
+    FrameReader reader;
+    vector<Frame> frames;
+    Frame frame;
+    for (char c: stream) { // byte by byte
+        reader.feed(&c, 1);
+        while (reader.next(frame)) frames.push_back(frame);
+    }
+    assert(frames.size() == 3 && "All frames should be read");
+    assert(frames[0].type == FrameType::Pack && frames[0].fields.size() == 3 && "Pack frame should have 3 fields");
+    assert(frames[0].fields[2] == string("hi\0there", 8) && "Binary field should round trip");
+    assert(frames[1].type == FrameType::Kill && frames[1].fields[0] == "bob" && "Kill frame should round trip");
+    assert(frames[2].type == FrameType::Hello && frames[2].fields.empty() && "Empty frame should round trip");
+}
+
+void test_Wire_rejects_broken_stream() {
+    FrameReader reader;
+    reader.feed("\xff\xff\xff\xff", 4);
+    Frame frame;
+    bool thrown = false;
+    try {
+        (void)reader.next(frame);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Oversized frame should throw");
+}
+
+void test_Wire_codec() {
+    assert(Codec<string>::decode(Codec<string>::encode("raw")) == "raw" && "Strings go raw");
+    assert(Codec<int>::decode(Codec<int>::encode(42)) == 42 && "Others go as JSON");
+}
+
+TEST(test_Wire_roundtrip_in_chunks);
+TEST(test_Wire_rejects_broken_stream);
+TEST(test_Wire_codec);
+
+#endif
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+namespace tools::utils {
+
+    /**
+     * Lock-free log-linear (HDR style) histogram of non-negative integer values,
+     * e.g. durations in nanoseconds.
+     *
+     * Values below 2 * subBucketCount are counted exactly, the larger ones in
+     * subBucketCount buckets per power of two, so the relative error stays
+     * below 1 / subBucketCount. Recording is a few relaxed atomic adds, safe
+     * from any number of threads. Values above 2^maxValueBits are counted in
+     * the last bucket.
+     */
+    class Histogram {
+    public:
+        static const size_t subBucketBits = 5;
+        static const size_t subBucketCount = 1 << subBucketBits;
+        static const size_t maxValueBits = 40; // ~18 minutes in ns
+        static const size_t bucketCount = 2 * subBucketCount + (maxValueBits - subBucketBits - 1) * subBucketCount;
+
+        // Copy of the counters at one point in time
+        struct Snapshot {
+            uint64_t count = 0;
+            uint64_t sum = 0;
+            uint64_t min = 0;
+            uint64_t max = 0;
+            vector<uint64_t> buckets;
+
+            // Merges another snapshot into this one
+            void add(const Snapshot& other) {
+                if (!other.count) return;
+                if (buckets.size() < other.buckets.size()) buckets.resize(other.buckets.size());
+                for (size_t i = 0; i < other.buckets.size(); i++) buckets[i] += other.buckets[i];
+                min = count ? std::min(min, other.min) : other.min;
+                max = std::max(max, other.max);
+                count += other.count;
+                sum += other.sum;
+            }
+
+            double mean() const {
+                return count ? (double)sum / count : 0;
+            }
+
+            // Value at the given percentile (0-100), upper bound of its bucket
+            uint64_t percentile(double p) const {
+                if (!count) return 0;
+                uint64_t rank = (uint64_t)(p / 100 * count + 0.5);
+                rank = clamp<uint64_t>(rank, 1, count);
+                uint64_t seen = 0;
+                for (size_t i = 0; i < buckets.size(); i++) {
+                    seen += buckets[i];
+                    if (seen >= rank) return clamp(bucketUpperBound(i), min, max);
+                }
+                return max;
+            }
+        };
+
+        Histogram() {
+            for (atomic<uint64_t>& bucket: buckets) bucket.store(0, memory_order_relaxed);
+        }
+
+        Histogram(const Histogram&) = delete;
+        Histogram& operator=(const Histogram&) = delete;
+
+        void record(uint64_t value) {
+            buckets[bucketIndex(value)].fetch_add(1, memory_order_relaxed);
+            sum.fetch_add(value, memory_order_relaxed);
+            uint64_t current = min.load(memory_order_relaxed);
+            while (value < current && !min.compare_exchange_weak(current, value, memory_order_relaxed));
+            current = max.load(memory_order_relaxed);
+            while (value > current && !max.compare_exchange_weak(current, value, memory_order_relaxed));
+        }
+
+        // Not atomic as a whole, the counters may be off by the records running meanwhile
+        Snapshot snapshot() const {
+            Snapshot snapshot;
+            snapshot.buckets.resize(bucketCount);
+            uint64_t total = 0;
+            for (size_t i = 0; i < bucketCount; i++) {
+                snapshot.buckets[i] = buckets[i].load(memory_order_relaxed);
+                total += snapshot.buckets[i];
+            }
+            snapshot.count = total;
+            snapshot.sum = sum.load(memory_order_relaxed);
+            snapshot.min = total ? min.load(memory_order_relaxed) : 0;
+            snapshot.max = max.load(memory_order_relaxed);
+            return snapshot;
+        }
+
+        void reset() {
+            for (atomic<uint64_t>& bucket: buckets) bucket.store(0, memory_order_relaxed);
+            sum.store(0, memory_order_relaxed);
+            min.store(UINT64_MAX, memory_order_relaxed);
+            max.store(0, memory_order_relaxed);
+        }
+
+        static size_t bucketIndex(uint64_t value) {
+            if (value < 2 * subBucketCount) return value;
+            size_t msb = 63 - __builtin_clzll(value);
+            if (msb >= maxValueBits) return bucketCount - 1;
+            size_t shift = msb - subBucketBits;
+            return 2 * subBucketCount + (msb - subBucketBits - 1) * subBucketCount + ((value >> shift) - subBucketCount);
+        }
+
+        // Largest value that falls into the bucket
+        static uint64_t bucketUpperBound(size_t index) {
+            if (index < 2 * subBucketCount) return index;
+            size_t range = (index - 2 * subBucketCount) / subBucketCount; // power of two above the linear part
+            size_t shift = range + 1;
+            uint64_t base = (uint64_t)(subBucketCount + (index - 2 * subBucketCount) % subBucketCount) << shift;
+            return base + ((uint64_t)1 << shift) - 1;
+        }
+
+    private:
+        atomic<uint64_t> buckets[bucketCount];
+        atomic<uint64_t> sum = 0;
+        atomic<uint64_t> min = UINT64_MAX;
+        atomic<uint64_t> max = 0;
+    };
+
+}
+
+#ifdef TEST
+
+#include <thread>
+
+#include "Test.hpp"
+
+using namespace tools::utils;
+
+void test_Histogram_exact_small_values() {
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 10; value++) histogram.record(value);
+    Histogram::Snapshot snapshot = histogram.snapshot();
+    assert(snapshot.count == 10 && "Histogram should count every record");
+    assert(snapshot.min == 1 && snapshot.max == 10 && "Histogram should track min and max");
+    assert(snapshot.mean() == 5.5 && "Histogram should track the mean");
+    assert(snapshot.percentile(50) == 5 && "Small values should be exact");
+    assert(snapshot.percentile(100) == 10 && "Top percentile should be the max");
+}
+
+void test_Histogram_relative_error() {
+    for (uint64_t value: { 100ull, 1000ull, 123456ull, 987654321ull }) {
+        size_t index = Histogram::bucketIndex(value);
+        uint64_t upper = Histogram::bucketUpperBound(index);
+        assert(upper >= value && "Bucket upper bound should cover the value");
+        assert(upper - value <= value / Histogram::subBucketCount && "Bucket should be within the relative error");
+        assert(Histogram::bucketIndex(upper) == index && "Upper bound should fall in the same bucket");
+        assert(Histogram::bucketIndex(upper + 1) == index + 1 && "Next value should fall in the next bucket");
+    }
+    assert(Histogram::bucketIndex(UINT64_MAX) == Histogram::bucketCount - 1 && "Huge values should go to the last bucket");
+}
+
+void test_Histogram_percentiles() {
+    Histogram histogram;
+    for (uint64_t value = 1; value <= 1000; value++) histogram.record(value * 1000);
+    Histogram::Snapshot snapshot = histogram.snapshot();
+    uint64_t p50 = snapshot.percentile(50);
+    uint64_t p99 = snapshot.percentile(99);
+    assert(p50 >= 500000 && p50 <= 500000 + 500000 / Histogram::subBucketCount && "p50 should be within the error");
+    assert(p99 >= 990000 && p99 <= 990000 + 990000 / Histogram::subBucketCount && "p99 should be within the error");
+}
+
+void test_Histogram_concurrent_record() {
+    Histogram histogram;
+    vector<thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&histogram]() {
+            for (uint64_t value = 0; value < 10000; value++) histogram.record(value);
+        });
+    }
+    for (thread& t: threads) t.join();
+    Histogram::Snapshot snapshot = histogram.snapshot();
+    assert(snapshot.count == 40000 && "Concurrent records should not be lost");
+    assert(snapshot.max == 9999 && snapshot.min == 0 && "Concurrent min and max should be kept");
+    histogram.reset();
+    assert(histogram.snapshot().count == 0 && "Reset should clear the histogram");
+}
+
+void test_Histogram_snapshot_add() {
+    Histogram first;
+    Histogram second;
+    first.record(10);
+    first.record(20);
+    second.record(5);
+    Histogram::Snapshot merged;
+    merged.add(first.snapshot());
+    merged.add(second.snapshot());
+    assert(merged.count == 3 && merged.sum == 35 && "Merge should sum the counters");
+    assert(merged.min == 5 && merged.max == 20 && "Merge should keep the extremes");
+    assert(merged.percentile(50) == 10 && "Merged buckets should give the percentiles");
+}
+
+TEST(test_Histogram_exact_small_values);
+TEST(test_Histogram_relative_error);
+TEST(test_Histogram_percentiles);
+TEST(test_Histogram_concurrent_record);
+TEST(test_Histogram_snapshot_add);
+
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace tools::utils {
+
+    /**
+     * Table of interned strings: each string gets a dense index (0 is the
+     * empty string) the first time it is seen. Indexes are never reused and
+     * the entries never move, so pointers to them can be kept around and
+     * compared instead of the strings. Interning a new string takes a lock,
+     * a known one a shared lock, so keep the entries instead of interning
+     * on hot paths.
+     */
+    class Interner {
+    public:
+        struct Entry {
+            string text;
+            size_t index;
+        };
+
+        Interner() {
+            entries.push_back({ "", 0 });
+            lookup[entries.front().text] = &entries.front();
+        }
+
+        Interner(const Interner&) = delete;
+        Interner& operator=(const Interner&) = delete;
+
+        // The entry of the string, a new one if it's not known yet
+        const Entry& intern(const string& text) {
+            {
+                shared_lock<shared_mutex> lock(mtx);
+                auto it = lookup.find(text);
+                if (it != lookup.end()) return *it->second;
+            }
+            unique_lock<shared_mutex> lock(mtx);
+            auto it = lookup.find(text);
+            if (it != lookup.end()) return *it->second;
+            entries.push_back({ text, entries.size() });
+            lookup[entries.back().text] = &entries.back();
+            return entries.back();
+        }
+
+        // Looks up the string without interning it (nullptr if unknown)
+        const Entry* find(const string& text) const {
+            shared_lock<shared_mutex> lock(mtx);
+            auto it = lookup.find(text);
+            return it == lookup.end() ? nullptr : it->second;
+        }
+
+        // The entry of an index (nullptr if unknown)
+        const Entry* at(size_t index) const {
+            shared_lock<shared_mutex> lock(mtx);
+            return index < entries.size() ? &entries[index] : nullptr;
+        }
+
+        // The empty string, index 0
+        const Entry& empty() const { return entries.front(); }
+
+        // Number of interned strings (all the indexes are below)
+        size_t size() const {
+            shared_lock<shared_mutex> lock(mtx);
+            return entries.size();
+        }
+
+    private:
+        mutable shared_mutex mtx;
+        deque<Entry> entries; // by index, push_back keeps the references
+        unordered_map<string_view, const Entry*> lookup; // views of the entries
+    };
+
+}
+
+#ifdef TEST
+
+#include <thread>
+#include <vector>
+
+#include "Test.hpp"
+
+using namespace tools::utils;
+
+void test_Interner_intern() {
+    Interner interner;
+    const Interner::Entry& a = interner.intern("a");
+    const Interner::Entry& b = interner.intern("b");
+    assert(&interner.intern(string("a")) == &a && "Same string should get the same entry");
+    assert(a.index == 1 && b.index == 2 && interner.size() == 3 && "Indexes should be dense");
+    assert(&interner.intern("") == &interner.empty() && interner.empty().index == 0 && "Empty string should be index 0");
+    assert(interner.at(1) == &a && interner.at(3) == nullptr && "Index should map back to the entry");
+}
+
+void test_Interner_find() {
+    Interner interner;
+    assert(interner.find("x") == nullptr && interner.size() == 1 && "Find shouldn't intern");
+    const Interner::Entry& x = interner.intern("x");
+    assert(interner.find("x") == &x && "Known string should be found");
+}
+
+void test_Interner_concurrent() {
+    Interner interner;
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&interner]() {
+            for (int i = 0; i < 1000; i++) interner.intern(to_string(i));
+        });
+    for (thread& t: threads) t.join();
+    assert(interner.size() == 1001 && "Every string should be interned once");
+    for (int i = 0; i < 1000; i++)
+        assert(interner.at(interner.intern(to_string(i)).index)->text == to_string(i) && "Entries should keep their strings");
+}
+
+TEST(test_Interner_intern);
+TEST(test_Interner_find);
+TEST(test_Interner_concurrent);
+
+#endif
@@ -228,6 +228,10 @@ namespace tools::utils {
             minLogLevel = level;
         }
 
+        Level getMinLogLevel() const {
+            return minLogLevel;
+        }
+
         virtual void log(Level level, const string& message) {
             if (level < minLogLevel) return; // Skip if below minimum level
             if (message.empty()) return; // Ignore empty log notes
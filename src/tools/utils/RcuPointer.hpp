@@ -0,0 +1,218 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
+
+using namespace std;
+
+namespace tools::utils {
+
+    /**
+     * Read-copy-update pointer to an immutable snapshot.
+     *
+     * Readers take the current snapshot without locks or allocations, they
+     * only count themselves on a per-thread (striped) counter. Writers build
+     * a new snapshot, replace() it and synchronize(): the previous snapshots
+     * are freed when every reader that might still use them is done
+     * (two phase grace period).
+     */
+    template<typename T>
+    class RcuPointer {
+    public:
+        static const size_t stripeCount = 64;
+        static const size_t cacheLineSize = 64;
+
+    private:
+        struct alignas(cacheLineSize) Stripe {
+            atomic<size_t> readers[2] = { 0, 0 };
+        };
+
+    public:
+
+        // Read-side critical section, the snapshot is valid while the reader lives
+        class Reader {
+        public:
+            Reader(const RcuPointer& owner): stripe(&owner.stripes[stripeIndex()]) {
+                parity = owner.epoch.load(memory_order_seq_cst) & 1;
+                stripe->readers[parity].fetch_add(1, memory_order_seq_cst);
+                readDepth()++;
+                snapshot = owner.current.load(memory_order_seq_cst);
+            }
+
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+
+            Reader(Reader&& other): stripe(other.stripe), parity(other.parity), snapshot(other.snapshot) {
+                other.stripe = nullptr;
+            }
+
+            ~Reader() {
+                if (!stripe) return;
+                readDepth()--;
+                stripe->readers[parity].fetch_sub(1, memory_order_release);
+            }
+
+            const T* get() const { return snapshot; }
+            const T* operator->() const { return snapshot; }
+            const T& operator*() const { return *snapshot; }
+
+        private:
+            Stripe* stripe;
+            size_t parity;
+            const T* snapshot;
+        };
+
+        RcuPointer(unique_ptr<const T> initial = make_unique<const T>()): current(initial.release()) {}
+
+        RcuPointer(const RcuPointer&) = delete;
+        RcuPointer& operator=(const RcuPointer&) = delete;
+
+        ~RcuPointer() {
+            delete current.load();
+            for (const T* snapshot: retired) delete snapshot;
+        }
+
+        Reader read() const {
+            return Reader(*this);
+        }
+
+        // Swaps in a new snapshot, the previous one is freed by a later synchronize()
+        void replace(unique_ptr<const T> next) {
+            lock_guard<mutex> lock(writerMutex);
+            retired.push_back(current.exchange(next.release(), memory_order_seq_cst));
+        }
+
+        // Waits until the readers of the replaced snapshots are done and frees them.
+        // Can't wait inside a read-side section of the calling thread, returns false then
+        // (and the snapshots are freed by a next synchronize() or the destructor).
+        bool synchronize() {
+            if (isReading()) return false;
+            lock_guard<mutex> syncLock(syncMutex);
+            vector<const T*> reclaim;
+            {
+                lock_guard<mutex> lock(writerMutex);
+                reclaim.swap(retired);
+            }
+            for (int phase = 0; phase < 2; phase++) {
+                size_t parity = epoch.fetch_add(1, memory_order_seq_cst) & 1;
+                while (countReaders(parity)) this_thread::yield();
+            }
+            for (const T* snapshot: reclaim) delete snapshot;
+            return true;
+        }
+
+        void update(unique_ptr<const T> next) {
+            replace(move(next));
+            synchronize();
+        }
+
+        // True if the calling thread is inside a read-side section (of any RcuPointer<T>)
+        static bool isReading() {
+            return readDepth() > 0;
+        }
+
+    private:
+        static size_t stripeIndex() {
+            static atomic<size_t> nextStripe = 0;
+            thread_local size_t index = nextStripe.fetch_add(1, memory_order_relaxed) % stripeCount;
+            return index;
+        }
+
+        static size_t& readDepth() {
+            thread_local size_t depth = 0;
+            return depth;
+        }
+
+        size_t countReaders(size_t parity) const {
+            size_t count = 0;
+            for (size_t i = 0; i < stripeCount; i++)
+                count += stripes[i].readers[parity].load(memory_order_seq_cst);
+            return count;
+        }
+
+        mutable Stripe stripes[stripeCount];
+        atomic<const T*> current;
+        atomic<size_t> epoch = 0;
+        mutex writerMutex;
+        mutex syncMutex;
+        vector<const T*> retired;
+    };
+
+}
+
+#ifdef TEST
+
+#include "Test.hpp"
+#include "system.hpp"
+
+using namespace tools::utils;
+
+void test_RcuPointer_read_initial() {
+    RcuPointer<int> ptr(make_unique<const int>(42));
+    RcuPointer<int>::Reader reader = ptr.read();
+    assert(*reader == 42 && "Reader should see the initial snapshot");
+}
+
+void test_RcuPointer_update_replaces_snapshot() {
+    RcuPointer<int> ptr(make_unique<const int>(1));
+    ptr.update(make_unique<const int>(2));
+    assert(*ptr.read() == 2 && "Reader should see the updated snapshot");
+}
+
+void test_RcuPointer_reader_keeps_old_snapshot() {
+    RcuPointer<int> ptr(make_unique<const int>(1));
+    RcuPointer<int>::Reader reader = ptr.read();
+    ptr.replace(make_unique<const int>(2));
+    assert(*reader == 1 && "Running reader should keep its snapshot");
+    assert(*ptr.read() == 2 && "New reader should see the new snapshot");
+    assert(!ptr.synchronize() && "Synchronize should not wait inside a read section");
+}
+
+void test_RcuPointer_synchronize_waits_for_readers() {
+    RcuPointer<int> ptr(make_unique<const int>(1));
+    atomic<bool> reading = false;
+    atomic<bool> done = false;
+    thread reader([&]() {
+        RcuPointer<int>::Reader snapshot = ptr.read();
+        reading = true;
+        sleep_ms(100);
+        done = true;
+        assert(*snapshot == 1 && "Snapshot should stay valid while read");
+    });
+    while (!reading) this_thread::yield();
+    ptr.update(make_unique<const int>(2));
+    assert(done && "Update should return only after the reader of the old snapshot is done");
+    reader.join();
+}
+
+void test_RcuPointer_concurrent_readers_and_writer() {
+    RcuPointer<vector<int>> ptr(make_unique<const vector<int>>(100, 0));
+    atomic<bool> running = true;
+    atomic<bool> consistent = true;
+    vector<thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&]() {
+            while (running) {
+                RcuPointer<vector<int>>::Reader snapshot = ptr.read();
+                int first = snapshot->front();
+                for (int value: *snapshot) if (value != first) consistent = false;
+            }
+        });
+    }
+    for (int i = 1; i <= 20; i++) ptr.update(make_unique<const vector<int>>(100, i));
+    running = false;
+    for (thread& reader: readers) reader.join();
+    assert(consistent && "Readers should always see a complete snapshot");
+    assert(ptr.read()->front() == 20 && "Last update should win");
+}
+
+TEST(test_RcuPointer_read_initial);
+TEST(test_RcuPointer_update_replaces_snapshot);
+TEST(test_RcuPointer_reader_keeps_old_snapshot);
+TEST(test_RcuPointer_synchronize_waits_for_readers);
+TEST(test_RcuPointer_concurrent_readers_and_writer);
+
+#endif
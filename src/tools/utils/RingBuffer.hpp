@@ -8,13 +8,26 @@
 #include <algorithm>
 #include <chrono>
 #include <thread>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
 
 #include "ERROR.hpp"
+#include "RingSpans.hpp"
 
 using namespace std;
 
 namespace tools::utils {
 
+    /**
+     * Bounded ring buffer guarded by a mutex, readers can block until data arrives.
+     *
+     * Writes and reads copy in at most two contiguous segments (memcpy for
+     * trivially copyable items). With roundToPowerOfTwo the capacity is
+     * rounded up so the positions wrap with a mask instead of a modulo.
+     */
     template<typename T>
     class RingBuffer {
     public:
@@ -25,10 +38,12 @@ namespace tools::utils {
         };
 
         // Caller must select a policy
-        RingBuffer(size_t capacity, WritePolicy policy) 
-            : buffer(capacity), capacity(capacity), policy(policy) {
+        RingBuffer(size_t capacity, WritePolicy policy, bool roundToPowerOfTwo = false) 
+            : capacity(roundToPowerOfTwo ? roundUp(capacity) : capacity), 
+              mask(roundToPowerOfTwo ? this->capacity - 1 : 0), policy(policy) {
             if (capacity < 1) 
                 throw ERROR("Capacity must be at least 1");
+            buffer.resize(this->capacity);
         }
         
         // Original methods
@@ -43,7 +58,7 @@ namespace tools::utils {
                     } else if (policy == WritePolicy::Rotate) {
                         // Overwrite only as many items as necessary
                         size_t excess = (current_size + count) - capacity;
-                        readPos = (readPos + excess) % capacity;
+                        readPos = advance(readPos, excess);
                         // Adjust current_size to reflect that we have discarded 'excess' items
                         current_size = current_size > excess ? current_size - excess : 0;
                     } else if (policy == WritePolicy::Reset) {
@@ -53,10 +68,7 @@ namespace tools::utils {
                     }
                 }
                 
-                for (size_t i = 0; i < count; ++i)
-                    buffer[(writePos + i) % capacity] = data[i];
-                
-                writePos = (writePos + count) % capacity;
+                copyIn(data, count);
                 size.store(min(capacity, current_size + count), memory_order_release);
             }
             cv.notify_one();
@@ -82,7 +94,7 @@ namespace tools::utils {
                     } else if (policy == WritePolicy::Rotate) {
                         // We'll write everything, but need to discard oldest items
                         size_t excess = count - available_space;
-                        readPos = (readPos + excess) % capacity;
+                        readPos = advance(readPos, excess);
                         // Adjust current_size to reflect that we have discarded 'excess' items
                         current_size = current_size > excess ? current_size - excess : 0;
                     } else if (policy == WritePolicy::Reset) {
@@ -92,10 +104,7 @@ namespace tools::utils {
                     }
                 }
                 
-                for (size_t i = 0; i < count; ++i)
-                    buffer[(writePos + i) % capacity] = data[i];
-                
-                writePos = (writePos + count) % capacity;
+                copyIn(data, count);
                 size.store(min(capacity, current_size + count), memory_order_release);
             }
             cv.notify_one();
@@ -118,10 +127,7 @@ namespace tools::utils {
             
             size_t toRead = min(current_size, maxCount);
             
-            for (size_t i = 0; i < toRead; ++i)
-                dest[i] = buffer[(readPos + i) % capacity];
-            
-            readPos = (readPos + toRead) % capacity;
+            copyOut(dest, toRead);
             size.store(current_size - toRead, memory_order_release);
             return toRead;
         }
@@ -141,6 +147,42 @@ namespace tools::utils {
             return true;
         }
         
+        // Zero-copy read: the readable items in place (up to maxCount).
+        // They stay valid until consume(), as long as no write overwrites
+        // them (Reject policy or a single thread), one reader at a time.
+        RingSpans<const T> peek_spans(size_t maxCount = SIZE_MAX) const {
+            lock_guard<mutex> lock(mtx);
+            return getSpans<const T>(readPos, min(maxCount, size.load(memory_order_acquire)));
+        }
+
+        // Releases the first count peeked items
+        void consume(size_t count) {
+            lock_guard<mutex> lock(mtx);
+            size_t current_size = size.load(memory_order_acquire);
+            if (count > current_size) throw ERROR("Consuming more than available: " + to_string(count));
+            readPos = advance(readPos, count);
+            size.store(current_size - count, memory_order_release);
+        }
+
+        // Zero-copy write: the free slots in place (up to maxCount) to fill,
+        // commit() publishes the first count of them. One writer at a time,
+        // write policies don't apply (there is no more room than reserved).
+        RingSpans<T> reserve_spans(size_t maxCount = SIZE_MAX) {
+            lock_guard<mutex> lock(mtx);
+            return getSpans<T>(writePos, min(maxCount, capacity - size.load(memory_order_acquire)));
+        }
+
+        void commit(size_t count) {
+            {
+                lock_guard<mutex> lock(mtx);
+                size_t current_size = size.load(memory_order_acquire);
+                if (count > capacity - current_size) throw ERROR("Committing more than reserved: " + to_string(count));
+                writePos = advance(writePos, count);
+                size.store(current_size + count, memory_order_release);
+            }
+            cv.notify_one();
+        }
+
         // Original method
         size_t available() const {
             return size.load(memory_order_acquire);
@@ -170,8 +212,65 @@ namespace tools::utils {
         }
         
     private:
+        static size_t roundUp(size_t capacity) {
+            size_t rounded = 1;
+            while (rounded < capacity) rounded <<= 1;
+            return rounded;
+        }
+
+        template<typename U>
+        RingSpans<U> getSpans(size_t pos, size_t count) const {
+            size_t first = min(count, capacity - pos);
+            U* data = const_cast<U*>(buffer.data());
+            return RingSpans<U>(span<U>(data + pos, first), span<U>(data, count - first));
+        }
+
+        size_t advance(size_t pos, size_t count) const {
+            return mask ? (pos + count) & mask : (pos + count) % capacity;
+        }
+
+        // Copies count items from src to the buffer at pos, wrapping around at the end
+        void copyTo(size_t pos, const T* src, size_t count) {
+            size_t first = min(count, capacity - pos);
+            if constexpr (is_trivially_copyable<T>::value) {
+                memcpy(buffer.data() + pos, src, first * sizeof(T));
+                if (count > first) memcpy(buffer.data(), src + first, (count - first) * sizeof(T));
+            } else {
+                copy_n(src, first, buffer.begin() + pos);
+                copy_n(src + first, count - first, buffer.begin());
+            }
+        }
+
+        // Writes at writePos and moves it, of a write larger than
+        // the buffer only the last capacity items are kept
+        void copyIn(const T* data, size_t count) {
+            if (count > capacity) {
+                size_t skip = count - capacity;
+                copyTo(advance(writePos, skip), data + skip, capacity);
+                writePos = advance(writePos, count);
+                readPos = writePos; // the whole buffer is new, oldest first
+                return;
+            }
+            copyTo(writePos, data, count);
+            writePos = advance(writePos, count);
+        }
+
+        // Reads from readPos and moves it (count <= size)
+        void copyOut(T* dest, size_t count) {
+            size_t first = min(count, capacity - readPos);
+            if constexpr (is_trivially_copyable<T>::value) {
+                memcpy(dest, buffer.data() + readPos, first * sizeof(T));
+                if (count > first) memcpy(dest + first, buffer.data(), (count - first) * sizeof(T));
+            } else {
+                copy_n(buffer.begin() + readPos, first, dest);
+                copy_n(buffer.begin(), count - first, dest + first);
+            }
+            readPos = advance(readPos, count);
+        }
+
         vector<T> buffer;
         size_t capacity;
+        size_t mask; // capacity - 1 if it's rounded to a power of two, 0 otherwise
         size_t readPos{0};
         size_t writePos{0};
         atomic<size_t> size{0};
@@ -784,6 +883,69 @@ void test_RingBuffer_drop_callback() {
     }
 }
 
+// Test power of two capacity (mask instead of modulo) across the wrap
+void test_RingBuffer_power_of_two_wraparound() {
+    RingBuffer<float> rb(5, RingBuffer<float>::WritePolicy::Reject, true);
+    assert(rb.getCapacity() == 8 && "Capacity should be rounded up to a power of two");
+    float data[6] = { 1, 2, 3, 4, 5, 6 };
+    float readData[6] = {};
+    rb.write(data, 6);
+    rb.read(readData, 5);
+    assert(rb.write(data, 6) == true && rb.available() == 7 && "Write should wrap around");
+    assert(rb.read(readData, 6) == 6 && "Read should wrap around");
+    assert(readData[0] == 6 && readData[1] == 1 && readData[5] == 5 && "Wrapped items should keep the order");
+}
+
+// Test segmented copy of items that are not trivially copyable
+void test_RingBuffer_wraparound_strings() {
+    RingBuffer<string> rb(3, RingBuffer<string>::WritePolicy::Rotate);
+    string data[] = { "a", "b", "c", "d", "e" };
+    rb.write(data, 2);
+    rb.write(data + 2, 3); // rotates "a" and "b" out
+    string readData[3];
+    assert(rb.read(readData, 3) == 3 && "Read should return the full buffer");
+    assert(readData[0] == "c" && readData[1] == "d" && readData[2] == "e" && "Rotated strings should keep the order");
+}
+
+// Test a write larger than the buffer keeps the last items
+void test_RingBuffer_write_larger_than_capacity() {
+    RingBuffer<int> rb(4, RingBuffer<int>::WritePolicy::Reset);
+    int first[] = { 1 };
+    rb.write(first, 1);
+    int data[] = { 1, 2, 3, 4, 5, 6 };
+    rb.write(data, 6);
+    int readData[4] = {};
+    assert(rb.read(readData, 4) == 4 && "Buffer should be full");
+    for (int i = 0; i < 4; i++) assert(readData[i] == i + 3 && "The last items of the write should be kept");
+}
+
+// Test in place reads and writes across the wrap
+void test_RingBuffer_spans() {
+    RingBuffer<float> rb(4, RingBuffer<float>::WritePolicy::Reject);
+    float data[] = { 1, 2, 3 };
+    rb.write(data, 3);
+    RingSpans<const float> peeked = rb.peek_spans(2);
+    assert(peeked.size() == 2 && peeked[0] == 1 && peeked[1] == 2 && "Peek should expose the oldest items");
+    rb.consume(2);
+    RingSpans<float> reserved = rb.reserve_spans();
+    assert(reserved.size() == 3 && reserved.first.size() == 1 && reserved.second.size() == 2 && "Free slots should wrap around");
+    for (size_t i = 0; i < reserved.size(); i++) reserved[i] = 4.0f + i;
+    rb.commit(3);
+    assert(rb.available() == 4 && "Commit should publish the items");
+    vector<float> all;
+    rb.peek_spans().appendTo(all);
+    assert((all == vector<float>{ 3, 4, 5, 6 }) && "Committed items should follow in order");
+    float readData[4] = {};
+    assert(rb.read(readData, 4) == 4 && readData[3] == 6 && "Committed items should be readable");
+    bool thrown = false;
+    try {
+        rb.consume(1);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Consuming more than available should throw");
+}
+
 // Register all tests
 TEST(test_RingBuffer_constructor_normal);
 TEST(test_RingBuffer_constructor_invalid);
@@ -819,5 +981,9 @@ TEST(test_RingBuffer_peek_one_empty);
 TEST(test_RingBuffer_remaining_capacity_basic);
 TEST(test_RingBuffer_clear_basic);
 TEST(test_RingBuffer_drop_callback);
+TEST(test_RingBuffer_power_of_two_wraparound);
+TEST(test_RingBuffer_wraparound_strings);
+TEST(test_RingBuffer_write_larger_than_capacity);
+TEST(test_RingBuffer_spans);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <concepts>
+#include <algorithm>
+
+using namespace std;
+
+namespace tools::utils {
+
+    /**
+     * A region of a ring buffer as (at most) two contiguous spans:
+     * the part up to the end of the storage and the part wrapped around
+     * to its beginning. See RingBuffer and SpscRingBuffer peek_spans()
+     * and reserve_spans().
+     */
+    template<typename T>
+    struct RingSpans {
+        span<T> first;
+        span<T> second;
+
+        RingSpans() = default;
+        RingSpans(span<T> first, span<T> second = {}): first(first), second(second) {}
+
+        // One contiguous range (e.g. a vector)
+        template<typename Range>
+        requires convertible_to<Range&, span<T>> && (!same_as<remove_cv_t<Range>, RingSpans>)
+        RingSpans(Range& range): first(range) {}
+
+        size_t size() const { return first.size() + second.size(); }
+        bool empty() const { return first.empty() && second.empty(); }
+
+        T& operator[](size_t index) const {
+            return index < first.size() ? first[index] : second[index - first.size()];
+        }
+
+        // The first count items
+        RingSpans prefix(size_t count) const {
+            if (count <= first.size()) return RingSpans(first.first(count));
+            return RingSpans(first, second.first(min(count - first.size(), second.size())));
+        }
+
+        template<typename Visitor>
+        void forEach(Visitor visit) const {
+            for (T& item: first) visit(item);
+            for (T& item: second) visit(item);
+        }
+
+        // Appends the items to a vector
+        template<typename U>
+        void appendTo(vector<U>& target) const {
+            target.insert(target.end(), first.begin(), first.end());
+            target.insert(target.end(), second.begin(), second.end());
+        }
+    };
+
+}
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+
+#include <sys/mman.h>
+
+#include "ERROR.hpp"
+#include "RingSpans.hpp"
+
+using namespace std;
+
+namespace tools::utils {
+
+    /**
+     * Wait-free single-producer/single-consumer ring buffer for real-time
+     * producers (e.g. an audio callback).
+     *
+     * The capacity is rounded up to a power of two, the read and write
+     * positions are free running counters published with acquire/release,
+     * so neither side locks, waits, allocates or calls back. What doesn't
+     * fit is not written and counted in getOverruns() (the producer can't
+     * rotate the oldest items out from under the consumer).
+     *
+     * The storage can be locked in RAM (mlock, best effort, see
+     * isMemoryLocked()) so the producer never takes a page fault.
+     */
+    template<typename T>
+    class SpscRingBuffer {
+    public:
+        static const size_t cacheLineSize = 64;
+
+        SpscRingBuffer(size_t capacity, bool lockMemory = false):
+            capacity(roundUp(capacity)),
+            mask(this->capacity - 1),
+            buffer(make_unique<T[]>(this->capacity))
+        {
+            if (lockMemory) locked = mlock(buffer.get(), this->capacity * sizeof(T)) == 0;
+        }
+
+        ~SpscRingBuffer() {
+            if (locked) munlock(buffer.get(), capacity * sizeof(T));
+        }
+
+        SpscRingBuffer(const SpscRingBuffer&) = delete;
+        SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+        // Producer only: writes what fits, returns the number of items written
+        size_t write(const T* data, size_t count) {
+            size_t head = writePos.load(memory_order_relaxed);
+            size_t tail = readPos.load(memory_order_acquire);
+            size_t space = capacity - (head - tail);
+            size_t toWrite = min(count, space);
+            if (toWrite < count) overruns.fetch_add(count - toWrite, memory_order_relaxed);
+            if (!toWrite) return 0;
+            size_t offset = head & mask;
+            size_t first = min(toWrite, capacity - offset);
+            copy_n(data, first, buffer.get() + offset);
+            copy_n(data + first, toWrite - first, buffer.get());
+            writePos.store(head + toWrite, memory_order_release);
+            return toWrite;
+        }
+
+        bool write_one(const T& item) {
+            return write(&item, 1) == 1;
+        }
+
+        // Consumer only: returns the number of items read
+        size_t read(T* dest, size_t maxCount) {
+            size_t tail = readPos.load(memory_order_relaxed);
+            size_t head = writePos.load(memory_order_acquire);
+            size_t toRead = min(maxCount, head - tail);
+            if (!toRead) return 0;
+            size_t offset = tail & mask;
+            size_t first = min(toRead, capacity - offset);
+            copy_n(buffer.get() + offset, first, dest);
+            copy_n(buffer.get(), toRead - first, dest + first);
+            readPos.store(tail + toRead, memory_order_release);
+            return toRead;
+        }
+
+        bool read_one(T& item) {
+            return read(&item, 1) == 1;
+        }
+
+        // Consumer only: the readable items in place (up to maxCount),
+        // they stay valid until consume() gives them back
+        RingSpans<const T> peek_spans(size_t maxCount = SIZE_MAX) const {
+            size_t tail = readPos.load(memory_order_relaxed);
+            size_t head = writePos.load(memory_order_acquire);
+            return getSpans<const T>(tail, min(maxCount, head - tail));
+        }
+
+        // Consumer only: releases the first count peeked items
+        void consume(size_t count) {
+            size_t tail = readPos.load(memory_order_relaxed);
+            if (count > writePos.load(memory_order_acquire) - tail)
+                throw ERROR("Consuming more than available: " + to_string(count));
+            readPos.store(tail + count, memory_order_release);
+        }
+
+        // Producer only: the free slots in place (up to maxCount) to fill,
+        // commit() publishes the first count of them
+        RingSpans<T> reserve_spans(size_t maxCount = SIZE_MAX) {
+            size_t head = writePos.load(memory_order_relaxed);
+            size_t tail = readPos.load(memory_order_acquire);
+            return getSpans<T>(head, min(maxCount, capacity - (head - tail)));
+        }
+
+        void commit(size_t count) {
+            size_t head = writePos.load(memory_order_relaxed);
+            if (count > capacity - (head - readPos.load(memory_order_acquire)))
+                throw ERROR("Committing more than reserved: " + to_string(count));
+            writePos.store(head + count, memory_order_release);
+        }
+
+        // Consumer only: drops everything written so far
+        void clear() {
+            readPos.store(writePos.load(memory_order_acquire), memory_order_release);
+        }
+
+        size_t available() const {
+            return writePos.load(memory_order_acquire) - readPos.load(memory_order_acquire);
+        }
+
+        size_t remaining_capacity() const {
+            return capacity - available();
+        }
+
+        size_t getCapacity() const {
+            return capacity;
+        }
+
+        // Items the producer couldn't write because the buffer was full
+        size_t getOverruns() const {
+            return overruns.load(memory_order_relaxed);
+        }
+
+        bool isMemoryLocked() const {
+            return locked;
+        }
+
+    private:
+        template<typename U>
+        RingSpans<U> getSpans(size_t pos, size_t count) const {
+            size_t offset = pos & mask;
+            size_t first = min(count, capacity - offset);
+            return RingSpans<U>(span<U>(buffer.get() + offset, first), span<U>(buffer.get(), count - first));
+        }
+
+        static size_t roundUp(size_t capacity) {
+            if (capacity < 1) throw ERROR("Capacity must be at least 1");
+            size_t rounded = 1;
+            while (rounded < capacity) rounded <<= 1;
+            return rounded;
+        }
+
+        const size_t capacity;
+        const size_t mask;
+        unique_ptr<T[]> buffer;
+        bool locked = false;
+        alignas(cacheLineSize) atomic<size_t> writePos = 0;
+        alignas(cacheLineSize) atomic<size_t> readPos = 0;
+        alignas(cacheLineSize) atomic<size_t> overruns = 0;
+    };
+
+} // namespace tools::utils
+
+#ifdef TEST
+
+#include <thread>
+
+#include "Test.hpp"
+
+using namespace tools::utils;
+
+void test_SpscRingBuffer_write_read() {
+    SpscRingBuffer<int> rb(5);
+    assert(rb.getCapacity() == 8 && "Capacity should be rounded up to a power of two");
+    int data[] = { 1, 2, 3, 4, 5 };
+    assert(rb.write(data, 5) == 5 && rb.available() == 5 && "Write should fit");
+    int readData[5] = {};
+    assert(rb.read(readData, 3) == 3 && rb.available() == 2 && "Partial read should leave the rest");
+    assert(readData[0] == 1 && readData[2] == 3 && "Read should keep the order");
+    bool thrown = false;
+    try {
+        SpscRingBuffer<int> invalid(0);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Zero capacity should throw");
+}
+
+void test_SpscRingBuffer_wraparound() {
+    SpscRingBuffer<int> rb(4);
+    int data[] = { 1, 2, 3 };
+    int readData[4] = {};
+    rb.write(data, 3);
+    rb.read(readData, 3);
+    int wrapped[] = { 4, 5, 6, 7 };
+    assert(rb.write(wrapped, 4) == 4 && "Write should wrap around");
+    assert(rb.read(readData, 4) == 4 && "Read should wrap around");
+    for (int i = 0; i < 4; i++) assert(readData[i] == wrapped[i] && "Wrapped items should keep the order");
+}
+
+void test_SpscRingBuffer_overruns() {
+    SpscRingBuffer<int> rb(4);
+    int data[] = { 1, 2, 3, 4, 5, 6 };
+    assert(rb.write(data, 6) == 4 && "Write should stop when full");
+    assert(rb.getOverruns() == 2 && "Items that don't fit should be counted");
+    assert(!rb.write_one(7) && rb.getOverruns() == 3 && "Write to full buffer should be counted");
+    int item = 0;
+    assert(rb.read_one(item) && item == 1 && "Oldest items should be kept");
+    rb.clear();
+    assert(rb.available() == 0 && rb.remaining_capacity() == 4 && "Clear should empty the buffer");
+}
+
+void test_SpscRingBuffer_concurrent() {
+    SpscRingBuffer<int> rb(64, true);
+    const int count = 20000;
+    thread producer([&rb]() {
+        int block[7];
+        int next = 0;
+        while (next < count) {
+            int n = 0;
+            while (n < 7 && next + n < count) { block[n] = next + n; n++; }
+            size_t written = rb.write(block, n);
+            if (!written) this_thread::yield();
+            next += (int)written;
+        }
+    });
+    int expected = 0;
+    bool ordered = true;
+    int block[5];
+    while (expected < count) {
+        size_t n = rb.read(block, 5);
+        if (!n) this_thread::yield();
+        for (size_t i = 0; i < n; i++) if (block[i] != expected++) ordered = false;
+    }
+    producer.join();
+    assert(ordered && "Consumer should see every item in order");
+}
+
+void test_SpscRingBuffer_spans() {
+    SpscRingBuffer<int> rb(4);
+    int data[] = { 1, 2, 3 };
+    rb.write(data, 3);
+    rb.consume(rb.peek_spans(2).size());
+    RingSpans<int> reserved = rb.reserve_spans();
+    assert(reserved.size() == 3 && reserved.first.size() == 1 && reserved.second.size() == 2 && "Free slots should wrap around");
+    for (size_t i = 0; i < reserved.size(); i++) reserved[i] = 4 + (int)i;
+    rb.commit(2);
+    RingSpans<const int> peeked = rb.peek_spans();
+    assert(peeked.size() == 3 && peeked[0] == 3 && peeked[1] == 4 && peeked[2] == 5 && "Committed items should be readable in place");
+    assert(peeked.first.size() == 2 && peeked.second.size() == 1 && "Readable items should wrap around");
+    rb.consume(3);
+    assert(rb.available() == 0 && "Consume should release the items");
+    bool thrown = false;
+    try {
+        rb.consume(1);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Consuming more than available should throw");
+}
+
+TEST(test_SpscRingBuffer_write_read);
+TEST(test_SpscRingBuffer_wraparound);
+TEST(test_SpscRingBuffer_overruns);
+TEST(test_SpscRingBuffer_concurrent);
+TEST(test_SpscRingBuffer_spans);
+
+#endif
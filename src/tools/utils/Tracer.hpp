@@ -0,0 +1,415 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+#include <cxxabi.h>
+
+using namespace std;
+
+namespace tools::utils {
+
+    /**
+     * Low overhead span recorder, dumped as Chrome trace-event JSON
+     * (chrome://tracing or https://ui.perfetto.dev).
+     *
+     * Every thread records into its own ring buffer, allocated on its
+     * first event, the owner thread is the only writer so recording takes
+     * no lock. The slots are seqlocked: dump() reads them while the
+     * threads keep recording and skips the ones overwritten meanwhile.
+     * A full ring overwrites its oldest events.
+     *
+     * Names are not copied, they have to outlive the tracer (literals,
+     * interned WorkerId names, typeid names). Type name details are
+     * demangled at dump time.
+     *
+     * Off by default, then the recording points cost an atomic load.
+     */
+    class Tracer {
+    public:
+        struct Event {
+            const char* category = nullptr;
+            const char* name = nullptr;
+            const char* detail = nullptr; // shown in args, optional
+            uint64_t id = 0;              // pack id (see nextId()), 0: none
+            int64_t start = 0;            // ns since the tracer started
+            int64_t duration = 0;         // ns, complete spans only
+            char phase = 'X';             // X: span, i: instant, s/t/f: flow start/step/end
+            bool mangled = false;         // detail is a typeid name
+        };
+
+        struct ThreadEvent {
+            size_t tid;
+            Event event;
+        };
+
+        static constexpr size_t bufferSize = 1 << 14; // events kept per thread, power of 2
+
+        static Tracer& instance() {
+            static Tracer tracer;
+            return tracer;
+        }
+
+        static bool on() {
+            return instance().enabled.load(memory_order_relaxed);
+        }
+
+        void enable(bool state = true) {
+            enabled.store(state, memory_order_relaxed);
+        }
+
+        static uint64_t nextId() {
+            static atomic<uint64_t> ids = 0;
+            return ids.fetch_add(1, memory_order_relaxed) + 1;
+        }
+
+        int64_t now() const {
+            return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+        }
+
+        void record(const Event& event) {
+            buffer().push(event);
+        }
+
+        void instant(const char* category, const char* name, const char* detail = nullptr, uint64_t id = 0, bool mangled = false) {
+            record({ category, name, detail, id, now(), 0, 'i', mangled });
+        }
+
+        // Flow arrows of an id between the spans enclosing them, phase:
+        // 's' start, 't' step, 'f' end
+        void flow(char phase, uint64_t id) {
+            record({ "flow", "pack", nullptr, id, now(), 0, phase });
+        }
+
+        // Lane name in the trace viewer, for the calling thread
+        void setThreadName(const string& name) {
+            threadName() = name;
+            lock_guard<mutex> lock(mtx);
+            if (current()) current()->name = name;
+        }
+
+        // Events of every thread, oldest first per thread
+        vector<ThreadEvent> collect() const {
+            vector<ThreadEvent> events;
+            lock_guard<mutex> lock(mtx);
+            for (const shared_ptr<Buffer>& buffer: buffers)
+                buffer->read(events);
+            return events;
+        }
+
+        // Forgets the events recorded so far
+        void clear() {
+            lock_guard<mutex> lock(mtx);
+            for (const shared_ptr<Buffer>& buffer: buffers)
+                buffer->floor.store(buffer->head.load(memory_order_acquire), memory_order_release);
+        }
+
+        // Chrome trace-event JSON
+        string dump() const {
+            vector<ThreadEvent> events = collect();
+            string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+            bool first = true;
+            auto add = [&](const string& event) {
+                if (!first) out += ",";
+                out += "\n" + event;
+                first = false;
+            };
+            {
+                lock_guard<mutex> lock(mtx);
+                for (const shared_ptr<Buffer>& buffer: buffers)
+                    add("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + to_string(buffer->tid)
+                        + ",\"args\":{\"name\":" + quote(buffer->name.empty() ? "thread " + to_string(buffer->tid) : buffer->name) + "}}");
+            }
+            for (const ThreadEvent& te: events) {
+                const Event& e = te.event;
+                string event = "{\"ph\":\"" + string(1, e.phase) + "\""
+                    + ",\"cat\":" + quote(e.category ? e.category : "")
+                    + ",\"name\":" + quote(e.name ? e.name : "")
+                    + ",\"ts\":" + micros(e.start)
+                    + ",\"pid\":1,\"tid\":" + to_string(te.tid);
+                if (e.phase == 'X') event += ",\"dur\":" + micros(e.duration);
+                if (e.phase == 'i') event += ",\"s\":\"t\"";
+                if (e.phase == 's' || e.phase == 't' || e.phase == 'f') {
+                    event += ",\"id\":" + to_string(e.id);
+                    if (e.phase != 's') event += ",\"bp\":\"e\""; // binds to the enclosing span
+                } else if (e.id || e.detail) {
+                    event += ",\"args\":{";
+                    if (e.id) event += "\"id\":" + to_string(e.id);
+                    if (e.id && e.detail) event += ",";
+                    if (e.detail) event += "\"detail\":" + quote(e.mangled ? demangle(e.detail) : e.detail);
+                    event += "}";
+                }
+                add(event + "}");
+            }
+            return out + "\n]}\n";
+        }
+
+    private:
+        class Buffer {
+        public:
+            Buffer(size_t tid, const string& name): tid(tid), name(name), slots(new Slot[bufferSize]) {}
+
+            size_t tid;
+            string name; // needs Tracer::mtx
+            atomic<uint64_t> head = 0;  // next slot to write
+            atomic<uint64_t> floor = 0; // first slot not cleared
+
+            // Owner thread only
+            void push(const Event& event) {
+                uint64_t i = head.load(memory_order_relaxed);
+                Slot& slot = slots[i & (bufferSize - 1)];
+                slot.seq.store(2 * i + 1, memory_order_relaxed); // odd: being written
+                atomic_thread_fence(memory_order_release);
+                slot.category.store(event.category, memory_order_relaxed);
+                slot.name.store(event.name, memory_order_relaxed);
+                slot.detail.store(event.detail, memory_order_relaxed);
+                slot.id.store(event.id, memory_order_relaxed);
+                slot.start.store(event.start, memory_order_relaxed);
+                slot.duration.store(event.duration, memory_order_relaxed);
+                slot.phase.store(event.phase, memory_order_relaxed);
+                slot.mangled.store(event.mangled, memory_order_relaxed);
+                slot.seq.store(2 * i + 2, memory_order_release);
+                head.store(i + 1, memory_order_release);
+            }
+
+            // Any thread
+            void read(vector<ThreadEvent>& events) const {
+                uint64_t end = head.load(memory_order_acquire);
+                uint64_t begin = max(floor.load(memory_order_acquire), end > bufferSize ? end - bufferSize : 0);
+                for (uint64_t i = begin; i < end; i++) {
+                    const Slot& slot = slots[i & (bufferSize - 1)];
+                    uint64_t seq = slot.seq.load(memory_order_acquire);
+                    if (seq != 2 * i + 2) continue; // overwritten
+                    Event event;
+                    event.category = slot.category.load(memory_order_relaxed);
+                    event.name = slot.name.load(memory_order_relaxed);
+                    event.detail = slot.detail.load(memory_order_relaxed);
+                    event.id = slot.id.load(memory_order_relaxed);
+                    event.start = slot.start.load(memory_order_relaxed);
+                    event.duration = slot.duration.load(memory_order_relaxed);
+                    event.phase = slot.phase.load(memory_order_relaxed);
+                    event.mangled = slot.mangled.load(memory_order_relaxed);
+                    atomic_thread_fence(memory_order_acquire);
+                    if (slot.seq.load(memory_order_relaxed) != seq) continue; // overwritten meanwhile
+                    events.push_back({ tid, event });
+                }
+            }
+
+        private:
+            struct Slot {
+                atomic<uint64_t> seq = 0;
+                atomic<const char*> category = nullptr;
+                atomic<const char*> name = nullptr;
+                atomic<const char*> detail = nullptr;
+                atomic<uint64_t> id = 0;
+                atomic<int64_t> start = 0;
+                atomic<int64_t> duration = 0;
+                atomic<char> phase = 0;
+                atomic<bool> mangled = false;
+            };
+
+            unique_ptr<Slot[]> slots;
+        };
+
+        Tracer(): epoch(chrono::steady_clock::now()) {}
+
+        static Buffer*& current() {
+            thread_local Buffer* buffer = nullptr;
+            return buffer;
+        }
+
+        static string& threadName() {
+            thread_local string name;
+            return name;
+        }
+
+        // The buffers outlive their threads, so their events stay dumpable
+        Buffer& buffer() {
+            Buffer*& buffer = current();
+            if (!buffer) {
+                lock_guard<mutex> lock(mtx);
+                buffers.push_back(make_shared<Buffer>(buffers.size() + 1, threadName()));
+                buffer = buffers.back().get();
+            }
+            return *buffer;
+        }
+
+        static string micros(int64_t ns) {
+            char buff[32];
+            snprintf(buff, sizeof(buff), "%.3f", ns / 1000.0);
+            return buff;
+        }
+
+        static string demangle(const char* name) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+            if (status || !demangled) return name;
+            string result = demangled;
+            free(demangled);
+            return result;
+        }
+
+        static string quote(const string& s) {
+            string out = "\"";
+            for (unsigned char c: s) {
+                if (c == '"' || c == '\\') out += string("\\") + (char)c;
+                else if (c < 0x20) {
+                    char buff[8];
+                    snprintf(buff, sizeof(buff), "\\u%04x", c);
+                    out += buff;
+                } else out += (char)c;
+            }
+            return out + "\"";
+        }
+
+        atomic<bool> enabled = false;
+        chrono::steady_clock::time_point epoch;
+        mutable mutex mtx;
+        vector<shared_ptr<Buffer>> buffers;
+    };
+
+    // Records a complete span from construction to destruction (if
+    // tracing was on at the start and the span wasn't cancelled)
+    class TraceSpan {
+    public:
+        TraceSpan(const char* category, const char* name, const char* detail = nullptr, uint64_t id = 0, bool mangled = false):
+            category(category), name(name), detail(detail), id(id), mangled(mangled),
+            start(Tracer::on() ? Tracer::instance().now() : -1) {}
+
+        ~TraceSpan() {
+            if (start < 0) return;
+            Tracer& tracer = Tracer::instance();
+            tracer.record({ category, name, detail, id, start, tracer.now() - start, 'X', mangled });
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+        bool active() const { return start >= 0; }
+
+        void cancel() { start = -1; }
+
+    private:
+        const char* category;
+        const char* name;
+        const char* detail;
+        uint64_t id;
+        bool mangled;
+        int64_t start;
+    };
+
+}
+
+#ifdef TEST
+
+#include <set>
+#include <thread>
+#include <typeinfo>
+
+#include "Test.hpp"
+#include "JSON.hpp"
+#include "../str/str_contains.hpp"
+
+using namespace tools::utils;
+using namespace tools::str;
+
+// Events of the test, tracer left off and cleared
+static vector<Tracer::Event> tracer_test_events(const char* category) {
+    vector<Tracer::Event> events;
+    for (const Tracer::ThreadEvent& te: Tracer::instance().collect())
+        if (te.event.category && string(te.event.category) == category) events.push_back(te.event);
+    return events;
+}
+
+void test_Tracer_off_records_nothing() {
+    Tracer& tracer = Tracer::instance();
+    tracer.enable(false);
+    tracer.clear();
+    {
+        TraceSpan span("test_off", "span");
+        assert(!span.active() && "Span should be inactive while tracing is off");
+    }
+    assert(tracer_test_events("test_off").empty() && "Nothing should be recorded while off");
+}
+
+void test_Tracer_spans_per_thread() {
+    Tracer& tracer = Tracer::instance();
+    tracer.clear();
+    tracer.enable();
+    uint64_t id = Tracer::nextId();
+    thread other([&]() {
+        tracer.setThreadName("other");
+        TraceSpan span("test_threads", "work", nullptr, id);
+        tracer.flow('f', id);
+    });
+    {
+        TraceSpan span("test_threads", "send", nullptr, id);
+        tracer.flow('s', id);
+    }
+    other.join();
+    tracer.enable(false);
+
+    size_t spans = 0;
+    set<size_t> tids;
+    for (const Tracer::ThreadEvent& te: tracer.collect()) {
+        if (string(te.event.category) != "test_threads") continue;
+        spans++;
+        tids.insert(te.tid);
+        assert(te.event.phase == 'X' && te.event.id == id && te.event.duration >= 0 && "Span should be complete");
+    }
+    assert(spans == 2 && tids.size() == 2 && "Both threads should have their span");
+
+    json trace = json::parse(tracer.dump());
+    bool named = false, flowStart = false, flowEnd = false;
+    for (const json& event: trace["traceEvents"]) {
+        if (event["ph"] == "M" && event["args"]["name"] == "other") named = true;
+        if (event["ph"] == "s" && event["id"] == id) flowStart = true;
+        if (event["ph"] == "f" && event["id"] == id && event["bp"] == "e") flowEnd = true;
+    }
+    assert(named && flowStart && flowEnd && "Dump should have the thread name and the flow");
+    tracer.clear();
+}
+
+void test_Tracer_ring_keeps_latest() {
+    Tracer& tracer = Tracer::instance();
+    tracer.clear();
+    for (size_t i = 0; i < Tracer::bufferSize + 10; i++)
+        tracer.record({ "test_ring", "event", nullptr, i, tracer.now(), 0, 'i' });
+    vector<Tracer::Event> events = tracer_test_events("test_ring");
+    assert(events.size() == Tracer::bufferSize && "Ring should keep bufferSize events");
+    assert(events.front().id == 10 && events.back().id == Tracer::bufferSize + 9 && "Ring should keep the latest");
+    tracer.clear();
+    assert(tracer_test_events("test_ring").empty() && "Clear should forget the events");
+}
+
+void test_Tracer_demangles_details() {
+    struct Traced { virtual ~Traced() {} };
+    Tracer& tracer = Tracer::instance();
+    tracer.clear();
+    tracer.instant("test_detail", "plugin", typeid(Traced).name(), 0, true);
+    tracer.instant("test_detail", "plugin", "i");
+    tracer.instant("test_detail", "plugin", "bob \"quoted\"");
+    json trace = json::parse(tracer.dump());
+    vector<string> details;
+    for (const json& event: trace["traceEvents"])
+        if (event.value("cat", "") == "test_detail") details.push_back(event["args"]["detail"]);
+    assert(details.size() == 3 && "Every instant should be dumped");
+    assert(str_contains(details[0], "Traced") && details[0] != typeid(Traced).name() && "Type names should be demangled");
+    assert(details[1] == "i" && details[2] == "bob \"quoted\"" && "Plain details should be escaped only");
+    tracer.clear();
+}
+
+TEST(test_Tracer_off_records_nothing);
+TEST(test_Tracer_spans_per_thread);
+TEST(test_Tracer_ring_keeps_latest);
+TEST(test_Tracer_demangles_details);
+
+#endif
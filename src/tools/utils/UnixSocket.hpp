@@ -0,0 +1,217 @@
+#pragma once
+
+#include <string>
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "ERROR.hpp"
+
+using namespace std;
+
+namespace tools::utils {
+
+    /**
+     * Stream socket in the Unix domain (AF_UNIX), owns its descriptor.
+     * Errors throw, except of the ones telling the peer is gone (see
+     * write() and read()).
+     */
+    class UnixSocket {
+    public:
+        UnixSocket(int fd = -1): fd(fd) {}
+
+        ~UnixSocket() { close(); }
+
+        UnixSocket(const UnixSocket&) = delete;
+        UnixSocket& operator=(const UnixSocket&) = delete;
+
+        UnixSocket(UnixSocket&& other): fd(other.fd), path(move(other.path)) {
+            other.fd = -1;
+            other.path = "";
+        }
+
+        UnixSocket& operator=(UnixSocket&& other) {
+            if (this == &other) return *this;
+            close();
+            fd = other.fd;
+            path = move(other.path);
+            other.fd = -1;
+            other.path = "";
+            return *this;
+        }
+
+        // Listens at path (a stale socket file there is replaced), the
+        // file is removed on close()
+        static UnixSocket listen(const string& path, int backlog = 16) {
+            UnixSocket socket(create());
+            sockaddr_un addr = address(path);
+            ::unlink(path.c_str());
+            if (::bind(socket.fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+                throw ERROR("Unable to bind socket at " + path + ": " + strerror(errno));
+            if (::listen(socket.fd, backlog) < 0)
+                throw ERROR("Unable to listen at " + path + ": " + strerror(errno));
+            socket.path = path;
+            return socket;
+        }
+
+        static UnixSocket connect(const string& path) {
+            UnixSocket socket(create());
+            sockaddr_un addr = address(path);
+            if (::connect(socket.fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+                throw ERROR("Unable to connect to " + path + ": " + strerror(errno));
+            return socket;
+        }
+
+        // Two connected sockets (socketpair)
+        static pair<UnixSocket, UnixSocket> makePair() {
+            int fds[2];
+            if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0)
+                throw ERROR("Unable to create socket pair: " + string(strerror(errno)));
+            return { UnixSocket(fds[0]), UnixSocket(fds[1]) };
+        }
+
+        // Waits up to ms for a connection, invalid socket on timeout
+        UnixSocket accept(int ms) {
+            pollfd pfd = { fd, POLLIN, 0 };
+            int ready = ::poll(&pfd, 1, ms);
+            if (ready < 0 && errno != EINTR) throw ERROR("Unable to poll socket: " + string(strerror(errno)));
+            if (ready <= 0) return UnixSocket();
+            int client = ::accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) {
+                if (errno == EAGAIN || errno == EINTR || errno == ECONNABORTED) return UnixSocket();
+                throw ERROR("Unable to accept connection: " + string(strerror(errno)));
+            }
+            return UnixSocket(client);
+        }
+
+        // Writes all the bytes, false if the peer is gone
+        bool write(const char* data, size_t size) {
+            while (size) {
+                ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EPIPE || errno == ECONNRESET || errno == EBADF || errno == ENOTCONN) return false;
+                    throw ERROR("Unable to write socket: " + string(strerror(errno)));
+                }
+                data += n;
+                size -= n;
+            }
+            return true;
+        }
+
+        // Reads what is there (at most size), blocks if nothing,
+        // 0 if the peer is gone (or shutdown())
+        size_t read(char* data, size_t size) {
+            while (true) {
+                ssize_t n = ::recv(fd, data, size, 0);
+                if (n >= 0) return n;
+                if (errno == EINTR) continue;
+                if (errno == ECONNRESET || errno == EBADF || errno == ENOTCONN) return 0;
+                throw ERROR("Unable to read socket: " + string(strerror(errno)));
+            }
+        }
+
+        // Wakes up the blocking read() of other threads
+        void shutdown() {
+            if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+        }
+
+        void close() {
+            if (fd < 0) return;
+            ::close(fd);
+            fd = -1;
+            if (!path.empty()) ::unlink(path.c_str());
+            path = "";
+        }
+
+        bool valid() const { return fd >= 0; }
+
+        int getFd() const { return fd; }
+
+    private:
+        static int create() {
+            int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) throw ERROR("Unable to create socket: " + string(strerror(errno)));
+            return fd;
+        }
+
+        static sockaddr_un address(const string& path) {
+            sockaddr_un addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(addr.sun_path))
+                throw ERROR("Invalid socket path: '" + path + "'");
+            memcpy(addr.sun_path, path.c_str(), path.size());
+            return addr;
+        }
+
+        int fd;
+        string path; // of a listening socket
+    };
+
+}
+
+#ifdef TEST
+
+#include <thread>
+
+#include "Test.hpp"
+
+using namespace tools::utils;
+
+void test_UnixSocket_pair_roundtrip() {
+    auto [a, b] = UnixSocket::makePair();
+    assert(a.write("hello", 5) && "Write should succeed");
+    char buff[16];
+    size_t n = b.read(buff, sizeof(buff));
+    assert(string(buff, n) == "hello" && "Peer should read what was written");
+    a.close();
+    assert(b.read(buff, sizeof(buff)) == 0 && "Read should tell the peer is gone");
+    assert(!b.write("x", 1) && "Write should tell the peer is gone");
+}
+
+void test_UnixSocket_listen_connect() {
+    string path = "/tmp/test_UnixSocket_" + to_string(getpid()) + ".sock";
+    UnixSocket server = UnixSocket::listen(path);
+    assert(!server.accept(0).valid() && "Accept should time out without clients");
+    UnixSocket client = UnixSocket::connect(path);
+    UnixSocket accepted = server.accept(1000);
+    assert(accepted.valid() && "Accept should return the client");
+    assert(client.write("ping", 4) && "Client should write");
+    char buff[8];
+    assert(string(buff, accepted.read(buff, sizeof(buff))) == "ping" && "Server side should read");
+    server.close();
+    assert(access(path.c_str(), F_OK) != 0 && "Closed listener should remove its file");
+    bool thrown = false;
+    try {
+        UnixSocket::connect(path);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Connect without a listener should throw");
+}
+
+void test_UnixSocket_shutdown_wakes_reader() {
+    auto [a, b] = UnixSocket::makePair();
+    size_t n = 1;
+    thread reader([&]() {
+        char buff[8];
+        n = a.read(buff, sizeof(buff));
+    });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    a.shutdown();
+    reader.join();
+    assert(n == 0 && "Shutdown should wake the blocked read");
+}
+
+TEST(test_UnixSocket_pair_roundtrip);
+TEST(test_UnixSocket_listen_connect);
+TEST(test_UnixSocket_shutdown_wakes_reader);
+
+#endif
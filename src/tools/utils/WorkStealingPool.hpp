@@ -0,0 +1,334 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "ERROR.hpp"
+#include "Tracer.hpp"
+
+using namespace std;
+
+namespace tools::utils {
+
+    /**
+     * Fixed size thread pool where every thread has its own task lane.
+     *
+     * Tasks submitted from a pool thread go to its own lane, others are
+     * spread round robin. A thread runs its own lane oldest first and when
+     * it's empty steals the newest task of another lane, so a thread stuck
+     * in a long task doesn't hold back the tasks queued behind it.
+     * Pinned tasks are never stolen, urgent ones jump the queue of their
+     * lane (see submit()).
+     *
+     * The threads can be bound to CPUs (best effort, see isCpuBound()).
+     * The destructor runs what is still queued before joining.
+     */
+    class WorkStealingPool {
+    public:
+        using Task = function<void()>;
+
+        WorkStealingPool(size_t threads, const vector<int>& cpus = {}) {
+            if (threads < 1) throw ERROR("Pool needs at least 1 thread");
+            cpuBound = !cpus.empty();
+            for (size_t i = 0; i < threads; i++) lanes.push_back(make_unique<Lane>());
+            for (size_t i = 0; i < threads; i++) {
+                lanes[i]->worker = thread([this, i]() { run(i); });
+                if (!cpus.empty()) cpuBound = bindCpu(lanes[i]->worker, cpus[i % cpus.size()]) && cpuBound;
+            }
+        }
+
+        ~WorkStealingPool() {
+            {
+                lock_guard<mutex> lock(sleepMtx);
+                stopping = true;
+            }
+            awake.notify_all();
+            for (unique_ptr<Lane>& lane: lanes)
+                if (lane->worker.joinable()) lane->worker.join();
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        // lane < 0: the calling pool thread's own lane or round robin,
+        // pinned tasks run on (lane % threads) only, urgent ones next
+        void submit(Task task, int lane = -1, bool pinned = false, bool urgent = false) {
+            size_t index = lane >= 0 ? (size_t)lane % lanes.size() : pickLane();
+            Lane& target = *lanes[index];
+            pending.fetch_add(1, memory_order_acq_rel);
+            {
+                lock_guard<mutex> lock(target.mtx);
+                deque<Task>& tasks = pinned ? target.pinned : target.tasks;
+                if (urgent) tasks.push_front(move(task));
+                else tasks.push_back(move(task));
+                if (pinned) target.pinnedCount++;
+                else stealable.fetch_add(1, memory_order_release);
+            }
+            {
+                lock_guard<mutex> lock(sleepMtx);
+            }
+            if (pinned) awake.notify_all();
+            else awake.notify_one();
+        }
+
+        // Runs one queued task (of any lane) on the calling thread,
+        // e.g. to help while waiting for a task, returns false if none
+        bool runOne() {
+            size_t start = currentPool == this ? currentLane : 0;
+            for (size_t i = 0; i < lanes.size(); i++) {
+                Task task;
+                size_t index = (start + i) % lanes.size();
+                if (take(index, task, true)) {
+                    execute(task);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Blocks until nothing is queued or running
+        void wait() {
+            unique_lock<mutex> lock(sleepMtx);
+            idle.wait(lock, [this]() { return pending.load(memory_order_acquire) == 0; });
+        }
+
+        size_t getThreads() const {
+            return lanes.size();
+        }
+
+        // Tasks queued or running
+        size_t getPending() const {
+            return pending.load(memory_order_acquire);
+        }
+
+        size_t getSteals() const {
+            return steals.load(memory_order_relaxed);
+        }
+
+        bool isCpuBound() const {
+            return cpuBound;
+        }
+
+        // The lane of the calling thread in this pool, -1 outside of it
+        int getCurrentLane() const {
+            return currentPool == this ? (int)currentLane : -1;
+        }
+
+    private:
+        struct Lane {
+            mutex mtx;
+            deque<Task> tasks;
+            deque<Task> pinned;
+            size_t pinnedCount = 0;
+            thread worker;
+        };
+
+        void run(size_t index) {
+            currentPool = this;
+            currentLane = index;
+            Tracer::instance().setThreadName("pool " + to_string(index));
+            while (true) {
+                Task task;
+                if (take(index, task, false) || steal(index, task)) {
+                    execute(task);
+                    continue;
+                }
+                unique_lock<mutex> lock(sleepMtx);
+                awake.wait(lock, [this, index]() {
+                    return stealable.load(memory_order_acquire) > 0 || hasPinned(index) ||
+                        (stopping && !pending.load(memory_order_acquire));
+                });
+                if (stopping && !pending.load(memory_order_acquire)) break;
+            }
+            currentPool = nullptr;
+        }
+
+        // Own lane: pinned first, then the oldest,
+        // anyPinned lets a helper take the pinned ones of any lane
+        bool take(size_t index, Task& task, bool anyPinned) {
+            Lane& lane = *lanes[index];
+            lock_guard<mutex> lock(lane.mtx);
+            bool own = currentPool == this && currentLane == index;
+            if (!lane.pinned.empty() && (own || anyPinned)) {
+                task = move(lane.pinned.front());
+                lane.pinned.pop_front();
+                lane.pinnedCount--;
+                return true;
+            }
+            if (lane.tasks.empty()) return false;
+            task = move(lane.tasks.front());
+            lane.tasks.pop_front();
+            stealable.fetch_sub(1, memory_order_acq_rel);
+            return true;
+        }
+
+        // Other lanes: the newest
+        bool steal(size_t thief, Task& task) {
+            for (size_t i = 1; i < lanes.size(); i++) {
+                Lane& lane = *lanes[(thief + i) % lanes.size()];
+                lock_guard<mutex> lock(lane.mtx);
+                if (lane.tasks.empty()) continue;
+                task = move(lane.tasks.back());
+                lane.tasks.pop_back();
+                stealable.fetch_sub(1, memory_order_acq_rel);
+                steals.fetch_add(1, memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+
+        void execute(Task& task) {
+            try {
+                task();
+            } catch (exception& e) {
+                cerr << "Pool task error: " << e.what() << endl;
+            }
+            if (pending.fetch_sub(1, memory_order_acq_rel) == 1) {
+                lock_guard<mutex> lock(sleepMtx);
+                idle.notify_all();
+                awake.notify_all(); // stopping threads wait for the last one
+            }
+        }
+
+        bool hasPinned(size_t index) {
+            Lane& lane = *lanes[index];
+            lock_guard<mutex> lock(lane.mtx);
+            return lane.pinnedCount > 0;
+        }
+
+        size_t pickLane() {
+            if (currentPool == this) return currentLane;
+            return next.fetch_add(1, memory_order_relaxed) % lanes.size();
+        }
+
+        static bool bindCpu(thread& t, int cpu) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            return pthread_setaffinity_np(t.native_handle(), sizeof(set), &set) == 0;
+        }
+
+        vector<unique_ptr<Lane>> lanes;
+        mutex sleepMtx;
+        condition_variable awake;
+        condition_variable idle;
+        bool stopping = false;
+        bool cpuBound = true;
+        atomic<size_t> pending = 0;
+        atomic<size_t> stealable = 0;
+        atomic<size_t> steals = 0;
+        atomic<size_t> next = 0;
+
+        static inline thread_local WorkStealingPool* currentPool = nullptr;
+        static inline thread_local size_t currentLane = 0;
+    };
+
+} // namespace tools::utils
+
+#ifdef TEST
+
+#include <chrono>
+
+#include "Test.hpp"
+
+using namespace tools::utils;
+
+void test_WorkStealingPool_runs_all() {
+    atomic<int> sum = 0;
+    {
+        WorkStealingPool pool(3);
+        assert(pool.getThreads() == 3 && "Pool should have the requested threads");
+        for (int i = 1; i <= 100; i++) pool.submit([&sum, i]() { sum += i; });
+        pool.wait();
+        assert(sum == 5050 && pool.getPending() == 0 && "Wait should return when every task ran");
+        for (int i = 1; i <= 10; i++) pool.submit([&sum]() { sum++; });
+    }
+    assert(sum == 5060 && "Destructor should run the queued tasks");
+    bool thrown = false;
+    try {
+        WorkStealingPool invalid(0);
+    } catch (exception& e) {
+        thrown = true;
+    }
+    assert(thrown && "Zero threads should throw");
+}
+
+void test_WorkStealingPool_steal() {
+    WorkStealingPool pool(2);
+    atomic<bool> release = false;
+    atomic<int> done = 0;
+    pool.submit([&]() { while (!release) this_thread::sleep_for(chrono::milliseconds(1)); }, 0);
+    for (int i = 0; i < 5; i++) pool.submit([&]() { done++; }, 0);
+    for (int i = 0; i < 2000 && done < 5; i++) this_thread::sleep_for(chrono::milliseconds(1));
+    int doneWhileBlocked = done;
+    release = true;
+    pool.wait();
+    assert(doneWhileBlocked == 5 && "Tasks behind a blocked one should be stolen");
+    assert(pool.getSteals() >= 5 && "Steals should be counted");
+}
+
+void test_WorkStealingPool_pinned() {
+    WorkStealingPool pool(3);
+    mutex mtx;
+    vector<int> lanes;
+    for (int i = 0; i < 20; i++) pool.submit([&]() {
+        lock_guard<mutex> lock(mtx);
+        lanes.push_back(pool.getCurrentLane());
+    }, 4, true);
+    pool.wait();
+    assert(lanes.size() == 20 && "Pinned tasks should run");
+    for (int lane: lanes) assert(lane == 1 && "Pinned tasks should run on their lane only");
+    assert(pool.getCurrentLane() == -1 && "Outside of the pool there is no lane");
+}
+
+void test_WorkStealingPool_runOne() {
+    WorkStealingPool pool(1);
+    atomic<bool> release = false;
+    atomic<bool> helped = false;
+    pool.submit([&]() { while (!release) this_thread::sleep_for(chrono::milliseconds(1)); });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    pool.submit([&]() { helped = true; }, 0, true);
+    bool ran = pool.runOne();
+    release = true;
+    pool.wait();
+    assert(ran && helped && "Helper should run a queued task");
+    assert(!pool.runOne() && "Nothing left to help with");
+}
+
+void test_WorkStealingPool_urgent() {
+    WorkStealingPool pool(1);
+    atomic<bool> release = false;
+    mutex mtx;
+    string order;
+    pool.submit([&]() { while (!release) this_thread::sleep_for(chrono::milliseconds(1)); });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    for (string task: { "a", "b" }) pool.submit([&, task]() {
+        lock_guard<mutex> lock(mtx);
+        order += task;
+    });
+    pool.submit([&]() {
+        lock_guard<mutex> lock(mtx);
+        order += "!";
+    }, 0, false, true);
+    release = true;
+    pool.wait();
+    assert(order == "!ab" && "Urgent task should run next");
+}
+
+TEST(test_WorkStealingPool_runs_all);
+TEST(test_WorkStealingPool_steal);
+TEST(test_WorkStealingPool_pinned);
+TEST(test_WorkStealingPool_runOne);
+TEST(test_WorkStealingPool_urgent);
+
+#endif
@@ -16,6 +16,8 @@ namespace tools::voice {
         // ------ RMS (max/decay) ------
         float rmax = -INFINITY;
     public:
+        using AudioSpans = RingSpans<const float>;
+
         using NoiseCallback = function<void(
             void* listener, 
             float vol_pc, 
@@ -23,7 +25,7 @@ namespace tools::voice {
             float rmax, 
             float rms, 
             bool is_noisy, 
-            vector<float>& buffer,
+            const AudioSpans& samples, // in place in the recorder, valid during the call
             bool muted
         )>;
 
@@ -52,18 +54,19 @@ namespace tools::voice {
             running = true;
             joined = false;
             monitor_thread = thread([=, this]{
-                vector<float> buffer(window);
                 while (running) {
                     Pa_Sleep(pollIntervalMs);
                     const size_t avail = recorder.available();
                     if (avail >= window) {
-                        recorder.read_audio(buffer.data(), window);
+                        AudioSpans buffer = recorder.peek_audio(window);
+                        if (buffer.size() < window) continue;
                         float rms = calculate_rms(buffer);
                         if (rms >= rmax) rmax = rms;
                         float vol_pc = muted ? 0.0 : (rms / rmax);
                         if (isnan(vol_pc)) vol_pc = 0;
                         bool noisy = vol_pc > threshold_pc;
                         cb(listener, vol_pc, threshold_pc, rmax, rms, noisy, buffer, muted);
+                        recorder.consume_audio(window);
                         rmax += ((rmax < rmax * threshold_pc * 2) ? 1 : -1) * rmax * rmax_decay_pc;
                     }
                 }
@@ -109,8 +112,12 @@ namespace tools::voice {
     protected:
 
         float calculate_rms(const vector<float>& buffer) {
+            return calculate_rms(AudioSpans(buffer));
+        }
+
+        float calculate_rms(const AudioSpans& buffer) {
             float sum = 0;
-            for (float sample : buffer) sum += sample * sample;
+            buffer.forEach([&sum](float sample) { sum += sample * sample; });
             return sqrt(sum / buffer.size());
         }
 
@@ -213,7 +220,7 @@ void test_NoiseMonitor_start_stop() {
         NoiseMonitor monitor(recorder, 0.1f, 0.01f, 1024);
     
         bool called = false;
-        monitor.start(nullptr, [&](void*, float, float, float, float, bool, vector<float>&, bool) {
+        monitor.start(nullptr, [&](void*, float, float, float, float, bool, const NoiseMonitor::AudioSpans&, bool) {
             called = true;
         }, 10);
         
@@ -238,7 +245,7 @@ void test_NoiseMonitor_start_callback_behavior() {
         recorder.set_available(1024);
         recorder.set_audio_data(audio_data);
         
-        monitor.start(nullptr, [&](void*, float vol_pc, float /*threshold_pc*/, float /*rmax*/, float rms, bool /*is_noisy*/, vector<float>& buffer, bool /*muted*/) {
+        monitor.start(nullptr, [&](void*, float vol_pc, float /*threshold_pc*/, float /*rmax*/, float rms, bool /*is_noisy*/, const NoiseMonitor::AudioSpans& buffer, bool /*muted*/) {
             last_vol_pc = vol_pc;
             callback_called = true;
             assert(buffer.size() == 1024 && "Buffer size should match window");
@@ -270,7 +277,7 @@ void test_NoiseMonitor_thread_safety_start_stop() {
         auto worker = [&monitor, &success_count]() {
             for (int i = 0; i < iterations; ++i) {
                 bool started = monitor.start(nullptr, 
-                    [](void*, float, float, float, float, bool, vector<float>&, bool) {}, 
+                    [](void*, float, float, float, float, bool, const NoiseMonitor::AudioSpans&, bool) {}, 
                     1, false);
                 if (started) {
                     Pa_Sleep(1);
@@ -303,10 +310,10 @@ void test_NoiseMonitor_start_throws_when_running() {
         NoiseMonitor monitor(recorder, 0.1f, 0.01f, 1024);
 
         // Start the monitor
-        monitor.start(nullptr, [](void*, float, float, float, float, bool, vector<float>&, bool) {}, 10);
+        monitor.start(nullptr, [](void*, float, float, float, float, bool, const NoiseMonitor::AudioSpans&, bool) {}, 10);
         
         // Try to start again with throws = true
-        monitor.start(nullptr, [](void*, float, float, float, float, bool, vector<float>&, bool) {}, 10, true);
+        monitor.start(nullptr, [](void*, float, float, float, float, bool, const NoiseMonitor::AudioSpans&, bool) {}, 10, true);
         monitor.stop();
     } catch (const runtime_error& e) {
         thrown = true;
@@ -325,10 +332,10 @@ void test_NoiseMonitor_start_fails_silently_when_running() {
         NoiseMonitor monitor(recorder, 0.1f, 0.01f, 1024);
     
         // Start the monitor
-        monitor.start(nullptr, [](void*, float, float, float, float, bool, vector<float>&, bool) {}, 10);
+        monitor.start(nullptr, [](void*, float, float, float, float, bool, const NoiseMonitor::AudioSpans&, bool) {}, 10);
         
         // Try to start again with throws = false, join = false
-        started = monitor.start(nullptr, [](void*, float, float, float, float, bool, vector<float>&, bool) {}, 10, false);
+        started = monitor.start(nullptr, [](void*, float, float, float, float, bool, const NoiseMonitor::AudioSpans&, bool) {}, 10, false);
         
         monitor.stop();
     }
@@ -346,7 +353,7 @@ void test_NoiseMonitor_start_empty_buffer() {
     
         recorder.set_available(0); // No data available
         
-        monitor.start(nullptr, [&](void*, float, float, float, float, bool, vector<float>&, bool) {
+        monitor.start(nullptr, [&](void*, float, float, float, float, bool, const NoiseMonitor::AudioSpans&, bool) {
             callback_called = true;
         }, 10);
         
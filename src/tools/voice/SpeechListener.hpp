@@ -43,12 +43,12 @@ namespace tools::voice {
             float rmax, 
             float rms, 
             bool is_noisy, 
-            vector<float>& buffer,
+            const NoiseMonitor::AudioSpans& buffer,
             bool muted
         ) {
             NULLCHK(listener, "Listener cannot be null");
             SpeechListener* that = (SpeechListener*)listener;
-            if (is_noisy) for (float sample: buffer) that->record.push_back(sample);
+            if (is_noisy) buffer.appendTo(that->record); // straight from the recorder
             else if (!is_noisy && that->is_noisy_prev) if (that->speech_cb) that->speech_cb(that->record);
             that->is_noisy_prev = is_noisy;
             if (that->rms_cb) that->rms_cb(vol_pc, threshold_pc, rmax, rms, is_noisy, muted);
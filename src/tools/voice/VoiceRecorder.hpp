@@ -7,7 +7,7 @@
 #include <fstream> // For file I/O
 #include <portaudio.h>
 
-#include "../utils/RingBuffer.hpp"
+#include "../utils/SpscRingBuffer.hpp"
 #include "../utils/ERROR.hpp"
 
 using namespace std;
@@ -16,6 +16,12 @@ using namespace tools::utils;
 namespace tools::voice {
 
 
+    /**
+     * Records the default input device into a ring buffer. The PortAudio
+     * callback writes a wait-free SPSC ring (no locks, allocation or
+     * callbacks on the audio thread), the samples that don't fit are
+     * counted in getOverruns(). Read from one thread only.
+     */
     class VoiceRecorder {
     public:
         using AudioCallback = function<void(const float* data, size_t count)>;
@@ -24,11 +30,11 @@ namespace tools::voice {
             double sampleRate, 
             unsigned long framesPerBuffer, 
             size_t bufferSeconds,
-            RingBuffer<float>::WritePolicy writePolicy = RingBuffer<float>::WritePolicy::Rotate
+            bool lockMemory = true // mlock the ring (best effort)
         ):
             sampleRate(sampleRate),
             framesPerBuffer(framesPerBuffer),
-            ringBuffer(sampleRate * bufferSeconds, writePolicy)
+            ringBuffer(sampleRate * bufferSeconds, lockMemory)
         {
 
             PaError err = Pa_Initialize();
@@ -66,6 +72,21 @@ namespace tools::voice {
             ringBuffer.read(dest, maxSamples);
         }
 
+        // Zero-copy read: the recorded samples in place (up to maxSamples),
+        // valid until consume_audio() gives them back
+        virtual RingSpans<const float> peek_audio(size_t maxSamples) {
+            return ringBuffer.peek_spans(maxSamples);
+        }
+
+        virtual void consume_audio(size_t count) {
+            ringBuffer.consume(count);
+        }
+
+        // Samples dropped by the audio callback because the ring was full
+        size_t getOverruns() const {
+            return ringBuffer.getOverruns();
+        }
+
         // Save recorded data as a raw PCM file
         static void save_as_pcm(const string& filename, const vector<float>& buffer) {
             ofstream file(filename, ios::binary);
@@ -89,7 +110,7 @@ namespace tools::voice {
     private:
         double sampleRate;
         unsigned long framesPerBuffer;
-        RingBuffer<float> ringBuffer;
+        SpscRingBuffer<float> ringBuffer;
         atomic<bool> running{true};
         thread workerThread;
 
@@ -105,11 +126,9 @@ namespace tools::voice {
             return self->process_audio(static_cast<const float*>(input), frameCount);
         }
 
+        // Runs on the audio thread, overflow is counted by the ring
         int process_audio(const float* input, unsigned long frameCount) {
-            if (!ringBuffer.write(input, frameCount)) {
-                // TODO: Handle buffer overflow (optional)
-                //cerr << "Voice recorder buffer overflow" << endl;
-            }
+            if (input) ringBuffer.write(input, frameCount);
             return paContinue;
         }
 
@@ -14,7 +14,7 @@ public:
         float rmax, 
         float rms, 
         bool is_noisy, 
-        vector<float>& buffer,
+        const NoiseMonitor::AudioSpans& buffer,
         bool muted
     ) {
         SpeechListener::noise_cb(
@@ -36,6 +36,13 @@ public:
         }
         read_pos += samples_to_read;
     }
+    RingSpans<const float> peek_audio(size_t maxSamples) override {
+        size_t samples_to_peek = min(maxSamples, audio_data.size() - read_pos);
+        return RingSpans<const float>(span<const float>(audio_data.data() + read_pos, samples_to_peek));
+    }
+    void consume_audio(size_t count) override {
+        read_pos += min(count, audio_data.size() - read_pos);
+    }
 
 private:
     size_t available_samples = 0;